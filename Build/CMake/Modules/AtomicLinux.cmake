@@ -11,7 +11,7 @@ find_package(PkgConfig REQUIRED)
 #for native file dialog
 pkg_check_modules(GTK3 REQUIRED gtk+-3.0)
 
-list (APPEND ATOMIC_LINK_LIBRARIES pthread GLEW GL dl)
+list (APPEND ATOMIC_LINK_LIBRARIES pthread GLEW GL dl rt)
 
 
 add_definitions(-DATOMIC_PLATFORM_LINUX)
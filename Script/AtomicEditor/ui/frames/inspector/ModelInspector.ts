@@ -30,6 +30,7 @@ class ModelInspector extends InspectorWidget {
         this.importer.scale = Number(this.scaleEdit.text);
 
         this.importer.importAnimations = this.importAnimationBox.value ? true : false;
+        this.importer.compressAnimations = this.compressAnimationBox.value ? true : false;
 
         for (var i = 0; i < this.importer.animationCount; i++) {
 
@@ -84,6 +85,9 @@ class ModelInspector extends InspectorWidget {
         this.importAnimationBox = this.createAttrCheckBox("Import Animations", animationLayout);
         this.importAnimationBox.value = this.importer.importAnimations ? 1 : 0;
 
+        this.compressAnimationBox = this.createAttrCheckBox("Compress Animations", animationLayout);
+        this.compressAnimationBox.value = this.importer.compressAnimations ? 1 : 0;
+
         this.importAnimationArray = new ArrayEditWidget("Animation Count");
         animationLayout.addChild(this.importAnimationArray);
 
@@ -167,6 +171,7 @@ class ModelInspector extends InspectorWidget {
 
     // animation
     importAnimationBox: Atomic.UICheckBox;
+    compressAnimationBox: Atomic.UICheckBox;
     importAnimationArray: ArrayEditWidget;
     animationInfoLayout: Atomic.UILayout;
 
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Renderer.h"
@@ -44,6 +45,7 @@ extern const char* SUBSYSTEM_CATEGORY;
 static const Vector2 DEFAULT_GRAVITY(0.0f, -9.81f);
 static const int DEFAULT_VELOCITY_ITERATIONS = 8;
 static const int DEFAULT_POSITION_ITERATIONS = 3;
+static const unsigned MIN_QUERIES_PER_BATCH = 32;
 
 PhysicsWorld2D::PhysicsWorld2D(Context* context) :
     Component(context),
@@ -467,6 +469,89 @@ void PhysicsWorld2D::RaycastSingle(PhysicsRaycastResult2D& result, const Vector2
     world_->RayCast(&callback, ToB2Vec2(startPoint), ToB2Vec2(endPoint));
 }
 
+/// Range of batch queries processed by one work item.
+struct PhysicsQueryBatch2D
+{
+    /// Physics world.
+    const PhysicsWorld2D* world_;
+    /// First result.
+    PhysicsRaycastResult2D* results_;
+    /// First query.
+    const PhysicsRaycastQuery2D* queries_;
+    /// Number of queries.
+    unsigned numQueries_;
+};
+
+void PhysicsQueryBatchWork2D(const WorkItem* item, unsigned threadIndex)
+{
+    const PhysicsQueryBatch2D* batch = reinterpret_cast<const PhysicsQueryBatch2D*>(item->start_);
+    batch->world_->ProcessRaycastQueries(batch->results_, batch->queries_, batch->numQueries_);
+}
+
+void PhysicsWorld2D::RaycastSingleBatch(PhysicsRaycastResult2D* results, const PhysicsRaycastQuery2D* queries, unsigned numQueries)
+{
+    PROFILE(PhysicsRaycastBatch2D);
+
+    // Box2D raycasts only read the world and use a local traversal stack, so they can run in parallel
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numBatches = queue ? numQueries / MIN_QUERIES_PER_BATCH : 0;
+    if (queue && numBatches > queue->GetNumThreads() + 1)
+        numBatches = queue->GetNumThreads() + 1;
+    if (numBatches <= 1)
+    {
+        ProcessRaycastQueries(results, queries, numQueries);
+        return;
+    }
+
+    PODVector<PhysicsQueryBatch2D> batches(numBatches);
+
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        PhysicsQueryBatch2D& batch = batches[i];
+        unsigned start = i * numQueries / numBatches;
+        batch.world_ = this;
+        batch.results_ = results + start;
+        batch.queries_ = queries + start;
+        batch.numQueries_ = (i + 1) * numQueries / numBatches - start;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = PhysicsQueryBatchWork2D;
+        item->start_ = &batch;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+void PhysicsWorld2D::RaycastSingleBatch(PODVector<PhysicsRaycastResult2D>& results, const PODVector<PhysicsRaycastQuery2D>& queries)
+{
+    results.Resize(queries.Size());
+    if (queries.Size())
+        RaycastSingleBatch(&results[0], &queries[0], queries.Size());
+}
+
+void PhysicsWorld2D::ProcessRaycastQueries(PhysicsRaycastResult2D* results, const PhysicsRaycastQuery2D* queries,
+    unsigned numQueries) const
+{
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        const PhysicsRaycastQuery2D& query = queries[i];
+        PhysicsRaycastResult2D& result = results[i];
+        result.position_ = Vector2::ZERO;
+        result.normal_ = Vector2::ZERO;
+        result.distance_ = M_INFINITY;
+        result.body_ = 0;
+
+        // Box2D asserts on zero length rays
+        if (query.startPoint_ == query.endPoint_)
+            continue;
+
+        SingleRayCastCallback callback(result, query.startPoint_, query.collisionMask_);
+        world_->RayCast(&callback, ToB2Vec2(query.startPoint_), ToB2Vec2(query.endPoint_));
+    }
+}
+
 // Point query callback class.
 class PointQueryCallback : public b2QueryCallback
 {
@@ -31,6 +31,7 @@ namespace Atomic
 
 class Camera;
 class RigidBody2D;
+struct WorkItem;
 
 /// 2D Physics raycast hit.
 struct ATOMIC_API PhysicsRaycastResult2D
@@ -57,11 +58,38 @@ struct ATOMIC_API PhysicsRaycastResult2D
     RigidBody2D* body_;
 };
 
+/// 2D physics raycast query for batch queries.
+struct ATOMIC_API PhysicsRaycastQuery2D
+{
+    /// Construct with defaults.
+    PhysicsRaycastQuery2D() :
+        collisionMask_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Construct with start and end points and collision mask.
+    PhysicsRaycastQuery2D(const Vector2& startPoint, const Vector2& endPoint, unsigned collisionMask = M_MAX_UNSIGNED) :
+        startPoint_(startPoint),
+        endPoint_(endPoint),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Start point.
+    Vector2 startPoint_;
+    /// End point.
+    Vector2 endPoint_;
+    /// Collision mask.
+    unsigned collisionMask_;
+};
+
 /// 2D physics simulation world component. Should be added only to the root scene node.
 class ATOMIC_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw
 {
     OBJECT(PhysicsWorld2D);
 
+    friend void PhysicsQueryBatchWork2D(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     PhysicsWorld2D(Context* context);
@@ -134,6 +162,10 @@ public:
     /// Perform a physics world raycast and return the closest hit.
     void RaycastSingle(PhysicsRaycastResult2D& result, const Vector2& startPoint, const Vector2& endPoint,
         unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of raycasts and return the closest hit of each to the preallocated result array. Large batches are split to the work queue threads.
+    void RaycastSingleBatch(PhysicsRaycastResult2D* results, const PhysicsRaycastQuery2D* queries, unsigned numQueries);
+    /// Perform a batch of raycasts and return the closest hit of each, in query order.
+    void RaycastSingleBatch(PODVector<PhysicsRaycastResult2D>& results, const PODVector<PhysicsRaycastQuery2D>& queries);
     /// Return rigid body at point.
     RigidBody2D* GetRigidBody(const Vector2& point, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Return rigid body at screen point.
@@ -196,6 +228,8 @@ private:
     void SendBeginContactEvents();
     /// Send end contact events.
     void SendEndContactEvents();
+    /// Process a range of batch queries. Called from the work queue threads.
+    void ProcessRaycastQueries(PhysicsRaycastResult2D* results, const PhysicsRaycastQuery2D* queries, unsigned numQueries) const;
 
     /// Box2D physics world.
     b2World* world_;
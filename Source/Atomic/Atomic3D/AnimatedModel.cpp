@@ -65,7 +65,9 @@ AnimatedModel::AnimatedModel(Context* context) :
     animationLodBias_(1.0f),
     animationLodTimer_(-1.0f),
     animationLodDistance_(0.0f),
+    poseSharingInterval_(0.0f),
     updateInvisible_(false),
+    updateBoneNodes_(true),
     animationDirty_(false),
     animationOrderDirty_(false),
     morphsDirty_(false),
@@ -177,7 +179,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
+            Matrix3x4 transform = GetBoneWorldTransform(i);
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -193,7 +195,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = GetBoneWorldTransform(i).Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -553,6 +555,22 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetUpdateBoneNodes(bool enable)
+{
+    if (enable != updateBoneNodes_)
+    {
+        updateBoneNodes_ = enable;
+        boneModelTransforms_.Clear();
+        MarkAnimationDirty();
+    }
+}
+
+void AnimatedModel::SetPoseSharingInterval(float interval)
+{
+    poseSharingInterval_ = Max(interval, 0.0f);
+    MarkAnimationDirty();
+}
+
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -747,6 +765,7 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
             RemoveRootBone();
 
         skeleton_.Define(skeleton);
+        boneOrder_.Clear();
 
         // Remove collision information from dummy bones that do not affect skinning, to prevent them from being merged
         // to the bounding box
@@ -1220,16 +1239,29 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
         animationOrderDirty_ = false;
     }
 
-    // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
+    // Reset pose, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.ResetSilent();
-        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
-            (*i)->Apply();
+        // If sharing the pose, check first whether another model already evaluated the same animation state this frame
+        AnimationPoseKey poseKey;
+        bool sharePose = GetPoseKey(poseKey);
+        if (!sharePose || !model_->GetPoseCache().GetPose(frame.frameNumber_, poseKey, boneModelTransforms_))
+        {
+            ResetPose();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
+            ApplyPose();
+
+            if (sharePose && boneModelTransforms_.Size())
+                model_->GetPoseCache().SetPose(frame.frameNumber_, poseKey, boneModelTransforms_);
+        }
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
-        node_->MarkDirty();
+        // The pose is applied to the bone nodes "silently" to avoid repeated marking dirty. Mark dirty now
+        if (updateBoneNodes_)
+            node_->MarkDirty();
+        else
+            skinningDirty_ = true;
 
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1238,27 +1270,162 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     animationDirty_ = false;
 }
 
+void AnimatedModel::ResetPose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+    bonePose_.Resize(numBones);
+
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        BonePose& pose = bonePose_[i];
+
+        // Bones with animation disabled are controlled through their nodes, for example by a ragdoll
+        if (!bone.animated_ && bone.node_)
+        {
+            pose.position_ = bone.node_->GetPosition();
+            pose.rotation_ = bone.node_->GetRotation();
+            pose.scale_ = bone.node_->GetScale();
+        }
+        else
+        {
+            pose.position_ = bone.initialPosition_;
+            pose.rotation_ = bone.initialRotation_;
+            pose.scale_ = bone.initialScale_;
+        }
+    }
+}
+
+void AnimatedModel::ApplyPose()
+{
+    Vector<Bone>& bones = skeleton_.GetModifiableBones();
+    unsigned numBones = bones.Size();
+
+    if (updateBoneNodes_)
+    {
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            Bone& bone = bones[i];
+            if (bone.animated_ && bone.node_)
+            {
+                const BonePose& pose = bonePose_[i];
+                bone.node_->SetTransformSilent(pose.position_, pose.rotation_, pose.scale_);
+            }
+        }
+        return;
+    }
+
+    // Order the bones parents first when the skeleton has changed
+    if (boneOrder_.Size() != numBones)
+    {
+        boneOrder_.Clear();
+        PODVector<unsigned char> ordered(numBones);
+        for (unsigned i = 0; i < numBones; ++i)
+            ordered[i] = 0;
+
+        while (boneOrder_.Size() < numBones)
+        {
+            unsigned oldSize = boneOrder_.Size();
+            for (unsigned i = 0; i < numBones; ++i)
+            {
+                unsigned parentIndex = bones[i].parentIndex_;
+                if (!ordered[i] && (parentIndex == i || parentIndex >= numBones || ordered[parentIndex]))
+                {
+                    boneOrder_.Push(i);
+                    ordered[i] = 1;
+                }
+            }
+
+            if (boneOrder_.Size() == oldSize)
+            {
+                LOGERROR("Cyclic bone hierarchy in skeleton, can not calculate pose");
+                boneOrder_.Clear();
+                boneModelTransforms_.Clear();
+                return;
+            }
+        }
+    }
+
+    boneModelTransforms_.Resize(numBones);
+    for (PODVector<unsigned>::ConstIterator i = boneOrder_.Begin(); i != boneOrder_.End(); ++i)
+    {
+        unsigned index = *i;
+        const BonePose& pose = bonePose_[index];
+        unsigned parentIndex = bones[index].parentIndex_;
+        if (parentIndex != index && parentIndex < numBones)
+            boneModelTransforms_[index] = boneModelTransforms_[parentIndex] * Matrix3x4(pose.position_, pose.rotation_, pose.scale_);
+        else
+            boneModelTransforms_[index] = Matrix3x4(pose.position_, pose.rotation_, pose.scale_);
+    }
+}
+
+bool AnimatedModel::GetPoseKey(AnimationPoseKey& key) const
+{
+    if (poseSharingInterval_ <= 0.0f || updateBoneNodes_ || !model_)
+        return false;
+
+    // Bones with animation disabled take their transform from the bone nodes, which are unique to each model
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+    {
+        if (!i->animated_)
+            return false;
+    }
+
+    union
+    {
+        float f;
+        unsigned u;
+    } interval;
+    interval.f = poseSharingInterval_;
+    key.Append(interval.u);
+    key.Append(animationStates_.Size());
+    for (Vector<SharedPtr<AnimationState> >::ConstIterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+        (*i)->AppendPoseKey(key, poseSharingInterval_);
+
+    return true;
+}
+
+Matrix3x4 AnimatedModel::GetBoneWorldTransform(unsigned index) const
+{
+    if (!updateBoneNodes_ && index < boneModelTransforms_.Size())
+        return node_->GetWorldTransform() * boneModelTransforms_[index];
+
+    const Bone& bone = skeleton_.GetBones()[index];
+    return bone.node_ ? bone.node_->GetWorldTransform() : node_->GetWorldTransform();
+}
+
 void AnimatedModel::UpdateBoneBoundingBox()
 {
     if (skeleton_.GetNumBones())
     {
-        // The bone bounding box is in local space, so need the node's inverse transform
+        // The bone bounding box is in local space, so need the node's inverse transform, unless using the pose directly
         boneBoundingBox_.defined_ = false;
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
-
         const Vector<Bone>& bones = skeleton_.GetBones();
-        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+        bool usePose = !updateBoneNodes_ && boneModelTransforms_.Size() == bones.Size();
+        Matrix3x4 inverseNodeTransform = usePose ? Matrix3x4::IDENTITY : node_->GetWorldTransform().Inverse();
+
+        for (unsigned i = 0; i < bones.Size(); ++i)
         {
-            Node* boneNode = i->node_;
-            if (!boneNode)
+            const Bone& bone = bones[i];
+            if (!(bone.collisionMask_ & (BONECOLLISION_BOX | BONECOLLISION_SPHERE)))
+                continue;
+
+            Matrix3x4 boneTransform;
+            if (usePose)
+                boneTransform = boneModelTransforms_[i];
+            else if (bone.node_)
+                boneTransform = inverseNodeTransform * bone.node_->GetWorldTransform();
+            else
                 continue;
 
             // Use hitbox if available. If not, use only half of the sphere radius
             /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            if (bone.collisionMask_ & BONECOLLISION_BOX)
+                boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneTransform));
+            else
+                boneBoundingBox_.Merge(Sphere(boneTransform.Translation(), bone.radius_ * 0.5f));
         }
     }
 
@@ -1273,19 +1440,12 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
-    // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    if (!updateBoneNodes_ && boneModelTransforms_.Size() == bones.Size())
     {
+        // Skinning directly from the pose, without accessing the bone nodes
         for (unsigned i = 0; i < bones.Size(); ++i)
-        {
-            const Bone& bone = bones[i];
-            if (bone.node_)
-                skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
-            else
-                skinMatrices_[i] = worldTransform;
-        }
+            skinMatrices_[i] = worldTransform * boneModelTransforms_[i] * bones[i].offsetMatrix_;
     }
-    // Skinning with per-geometry matrices
     else
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
@@ -1295,8 +1455,14 @@ void AnimatedModel::UpdateSkinning()
                 skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
             else
                 skinMatrices_[i] = worldTransform;
+        }
+    }
 
-            // Copy the skin matrix to per-geometry matrices as needed
+    // Skinning with per-geometry matrices: copy the skin matrices as needed
+    if (geometrySkinMatrices_.Size())
+    {
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
             for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
                 *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
         }
@@ -86,6 +86,10 @@ public:
     void SetAnimationLodBias(float bias);
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     void SetUpdateInvisible(bool enable);
+    /// Set whether animation is applied to the bone scene nodes. Default true. When disabled, skinning, the bone bounding box and bone raycasts use the animated pose directly, which is faster for large crowds. The bone nodes then do not move, so nothing should be attached to them, and skinned attachment models in the same node will not animate.
+    void SetUpdateBoneNodes(bool enable);
+    /// Set time interval for sharing the evaluated pose with other models that use the same model and animations, with animation times in the same interval. 0 (default) disables sharing. Requires that bone node updates are disabled and all bones are animated.
+    void SetPoseSharingInterval(float interval);
     /// Set vertex morph weight by index.
     void SetMorphWeight(unsigned index, float weight);
     /// Set vertex morph weight by name.
@@ -119,6 +123,15 @@ public:
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether animation is applied to the bone scene nodes.
+    bool GetUpdateBoneNodes() const { return updateBoneNodes_; }
+
+    /// Return time interval for sharing the evaluated pose.
+    float GetPoseSharingInterval() const { return poseSharingInterval_; }
+
+    /// Return bone transforms relative to the scene node, calculated on animation update when bone nodes are not updated.
+    const PODVector<Matrix3x4>& GetBoneModelTransforms() const { return boneModelTransforms_; }
+
     /// Return all vertex morphs.
     const Vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -193,6 +206,14 @@ private:
     void CopyMorphVertices(void* dest, void* src, unsigned vertexCount, VertexBuffer* clone, VertexBuffer* original);
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Reset the pose to the bones' initial transforms before applying animations.
+    void ResetPose();
+    /// Apply the pose to the bone nodes, or calculate the bone transforms relative to the scene node if bone nodes are not updated.
+    void ApplyPose();
+    /// Return a bone's world transform.
+    Matrix3x4 GetBoneWorldTransform(unsigned index) const;
+    /// Fill the key for sharing the evaluated pose. Return false if the pose can not be shared.
+    bool GetPoseKey(AnimationPoseKey& key) const;
     /// Recalculate the bone bounding box.
     void UpdateBoneBoundingBox();
     /// Recalculate skinning.
@@ -215,6 +236,12 @@ private:
     Vector<SharedPtr<AnimationState> > animationStates_;
     /// Skinning matrices.
     PODVector<Matrix3x4> skinMatrices_;
+    /// Bone local transforms that animation states are applied to, in skeleton order.
+    PODVector<BonePose> bonePose_;
+    /// Bone transforms relative to the scene node, if bone nodes are not updated.
+    PODVector<Matrix3x4> boneModelTransforms_;
+    /// Bone indices ordered so that parents come before children.
+    PODVector<unsigned> boneOrder_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
     Vector<PODVector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
@@ -235,8 +262,12 @@ private:
     float animationLodTimer_;
     /// Animation LOD distance, the minimum of all LOD view distances last frame.
     float animationLodDistance_;
+    /// Pose sharing time interval.
+    float poseSharingInterval_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
+    /// Apply animation to bone nodes flag.
+    bool updateBoneNodes_;
     /// Animation dirty flag.
     bool animationDirty_;
     /// Animation order dirty flag.
@@ -29,6 +29,7 @@
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/Serializer.h"
+#include "../IO/VectorBuffer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/XMLFile.h"
 
@@ -42,6 +43,214 @@ inline bool CompareTriggers(AnimationTriggerPoint& lhs, AnimationTriggerPoint& r
     return lhs.time_ < rhs.time_;
 }
 
+/// Largest possible absolute value of the three smallest components of a unit quaternion.
+static const float MAX_QUATERNION_COMPONENT = 0.70710678f;
+
+static unsigned short QuantizeFloat(float value, float min, float range)
+{
+    if (range <= 0.0f)
+        return 0;
+    return (unsigned short)Clamp((int)((value - min) / range * 65535.0f + 0.5f), 0, 65535);
+}
+
+static float DequantizeFloat(unsigned short value, float min, float range)
+{
+    return min + (float)value * range / 65535.0f;
+}
+
+static void QuantizeVector3(const Vector3& value, const Vector3& min, const Vector3& range, unsigned short* dest)
+{
+    dest[0] = QuantizeFloat(value.x_, min.x_, range.x_);
+    dest[1] = QuantizeFloat(value.y_, min.y_, range.y_);
+    dest[2] = QuantizeFloat(value.z_, min.z_, range.z_);
+}
+
+static Vector3 DequantizeVector3(const unsigned short* src, const Vector3& min, const Vector3& range)
+{
+    return Vector3(DequantizeFloat(src[0], min.x_, range.x_), DequantizeFloat(src[1], min.y_, range.y_),
+        DequantizeFloat(src[2], min.z_, range.z_));
+}
+
+/// Quantize a rotation to 48 bits by storing the three smallest components with 15 bits each, and the index of the largest
+/// component in the two remaining bits.
+static void QuantizeRotation(const Quaternion& rotation, unsigned short* dest)
+{
+    Quaternion normalized = rotation.Normalized();
+    float components[4] = { normalized.w_, normalized.x_, normalized.y_, normalized.z_ };
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    // Negating all components gives the same rotation, so flip to make the omitted component positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = Clamp(components[i] * sign, -MAX_QUATERNION_COMPONENT, MAX_QUATERNION_COMPONENT);
+        dest[j++] = (unsigned short)((value + MAX_QUATERNION_COMPONENT) / (2.0f * MAX_QUATERNION_COMPONENT) * 32767.0f + 0.5f);
+    }
+
+    dest[0] |= (unsigned short)((largest & 1) << 15);
+    dest[1] |= (unsigned short)((largest >> 1) << 15);
+}
+
+static Quaternion DequantizeRotation(const unsigned short* src)
+{
+    unsigned largest = (unsigned)(src[0] >> 15) | ((unsigned)(src[1] >> 15) << 1);
+    float components[4];
+    float sumSquares = 0.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = (float)(src[j++] & 0x7fff) / 32767.0f * 2.0f * MAX_QUATERNION_COMPONENT - MAX_QUATERNION_COMPONENT;
+        components[i] = value;
+        sumSquares += value * value;
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+static void GetTrackRange(const AnimationTrack& track, unsigned char channel, Vector3& min, Vector3& range)
+{
+    const Vector<AnimationKeyFrame>& keyFrames = track.keyFrames_;
+    if (keyFrames.Empty())
+    {
+        min = range = Vector3::ZERO;
+        return;
+    }
+
+    const Vector3& first = channel == CHANNEL_POSITION ? keyFrames[0].position_ : keyFrames[0].scale_;
+    Vector3 max = first;
+    min = first;
+    for (unsigned i = 1; i < keyFrames.Size(); ++i)
+    {
+        const Vector3& value = channel == CHANNEL_POSITION ? keyFrames[i].position_ : keyFrames[i].scale_;
+        min = Vector3(Min(min.x_, value.x_), Min(min.y_, value.y_), Min(min.z_, value.z_));
+        max = Vector3(Max(max.x_, value.x_), Max(max.y_, value.y_), Max(max.z_, value.z_));
+    }
+    range = max - min;
+}
+
+static float GetRotationError(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return 2.0f * Acos(Min(Abs(lhs.DotProduct(rhs)), 1.0f));
+}
+
+/// Sample a track at an arbitrary time without looping.
+static AnimationKeyFrame SampleTrack(const AnimationTrack& track, float time, unsigned& frame)
+{
+    track.GetKeyFrameIndex(time, frame);
+    const AnimationKeyFrame& keyFrame = track.keyFrames_[frame];
+    if (frame + 1 >= track.keyFrames_.Size())
+        return keyFrame;
+
+    const AnimationKeyFrame& nextKeyFrame = track.keyFrames_[frame + 1];
+    float timeInterval = nextKeyFrame.time_ - keyFrame.time_;
+    float t = timeInterval > 0.0f ? Clamp((time - keyFrame.time_) / timeInterval, 0.0f, 1.0f) : 1.0f;
+
+    AnimationKeyFrame result;
+    result.time_ = time;
+    result.position_ = keyFrame.position_.Lerp(nextKeyFrame.position_, t);
+    result.rotation_ = keyFrame.rotation_.Slerp(nextKeyFrame.rotation_, t);
+    result.scale_ = keyFrame.scale_.Lerp(nextKeyFrame.scale_, t);
+    return result;
+}
+
+/// Return whether a keyframe can be reproduced by interpolating between two others within the tolerances.
+static bool CanInterpolate(const AnimationKeyFrame& start, const AnimationKeyFrame& end, const AnimationKeyFrame& keyFrame,
+    unsigned char channelMask, const AnimationCompressionSettings& settings)
+{
+    float timeInterval = end.time_ - start.time_;
+    if (timeInterval <= 0.0f)
+        return false;
+    float t = (keyFrame.time_ - start.time_) / timeInterval;
+
+    if ((channelMask & CHANNEL_POSITION) && (start.position_.Lerp(end.position_, t) - keyFrame.position_).Length() >
+        settings.positionTolerance_)
+        return false;
+    if ((channelMask & CHANNEL_ROTATION) && GetRotationError(start.rotation_.Slerp(end.rotation_, t), keyFrame.rotation_) >
+        settings.rotationTolerance_)
+        return false;
+    if ((channelMask & CHANNEL_SCALE) && (start.scale_.Lerp(end.scale_, t) - keyFrame.scale_).Length() >
+        settings.scaleTolerance_)
+        return false;
+
+    return true;
+}
+
+/// Remove keyframes that interpolation between the remaining ones reproduces within the tolerances.
+static void ReduceKeyFrames(AnimationTrack& track, const AnimationCompressionSettings& settings)
+{
+    const Vector<AnimationKeyFrame>& keyFrames = track.keyFrames_;
+    if (keyFrames.Size() < 3)
+        return;
+
+    Vector<AnimationKeyFrame> reduced;
+    reduced.Push(keyFrames[0]);
+
+    // Extend each segment from the last kept keyframe as far as all keyframes it spans can be interpolated
+    unsigned start = 0;
+    for (unsigned end = 2; end < keyFrames.Size(); ++end)
+    {
+        for (unsigned i = start + 1; i < end; ++i)
+        {
+            if (!CanInterpolate(keyFrames[start], keyFrames[end], keyFrames[i], track.channelMask_, settings))
+            {
+                start = end - 1;
+                reduced.Push(keyFrames[start]);
+                break;
+            }
+        }
+    }
+
+    reduced.Push(keyFrames.Back());
+    track.keyFrames_ = reduced;
+}
+
+/// Replace the keyframes of a track with the values that the compressed format will reproduce.
+static void QuantizeKeyFrames(AnimationTrack& track)
+{
+    Vector<AnimationKeyFrame>& keyFrames = track.keyFrames_;
+    if (keyFrames.Empty())
+        return;
+
+    float timeRange = keyFrames.Back().time_;
+    Vector3 positionMin, positionRange, scaleMin, scaleRange;
+    GetTrackRange(track, CHANNEL_POSITION, positionMin, positionRange);
+    GetTrackRange(track, CHANNEL_SCALE, scaleMin, scaleRange);
+
+    unsigned short quantized[3];
+    for (unsigned i = 0; i < keyFrames.Size(); ++i)
+    {
+        AnimationKeyFrame& keyFrame = keyFrames[i];
+        keyFrame.time_ = DequantizeFloat(QuantizeFloat(keyFrame.time_, 0.0f, timeRange), 0.0f, timeRange);
+        if (track.channelMask_ & CHANNEL_POSITION)
+        {
+            QuantizeVector3(keyFrame.position_, positionMin, positionRange, quantized);
+            keyFrame.position_ = DequantizeVector3(quantized, positionMin, positionRange);
+        }
+        if (track.channelMask_ & CHANNEL_ROTATION)
+        {
+            QuantizeRotation(keyFrame.rotation_, quantized);
+            keyFrame.rotation_ = DequantizeRotation(quantized);
+        }
+        if (track.channelMask_ & CHANNEL_SCALE)
+        {
+            QuantizeVector3(keyFrame.scale_, scaleMin, scaleRange, quantized);
+            keyFrame.scale_ = DequantizeVector3(quantized, scaleMin, scaleRange);
+        }
+    }
+}
+
 void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
 {
     if (time < 0.0f)
@@ -50,6 +259,18 @@ void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
     if (index >= keyFrames_.Size())
         index = keyFrames_.Size() - 1;
 
+    // If the previous index is not valid for the new time, jump near the correct keyframe using the lookup table
+    if (keyFrameIndex_.Size() && (time < keyFrames_[index].time_ || (index < keyFrames_.Size() - 1 &&
+        time >= keyFrames_[index + 1].time_)))
+    {
+        unsigned slot = (unsigned)(time * keyFrameIndexScale_);
+        if (slot >= keyFrameIndex_.Size())
+            slot = keyFrameIndex_.Size() - 1;
+        index = keyFrameIndex_[slot];
+        if (index >= keyFrames_.Size())
+            index = keyFrames_.Size() - 1;
+    }
+
     // Check for being too far ahead
     while (index && time < keyFrames_[index].time_)
         --index;
@@ -59,9 +280,40 @@ void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
         ++index;
 }
 
+void AnimationTrack::BuildKeyFrameIndex()
+{
+    keyFrameIndex_.Clear();
+    keyFrameIndexScale_ = 0.0f;
+
+    if (keyFrames_.Size() < 2 || keyFrames_.Back().time_ <= 0.0f)
+        return;
+
+    // Use as many slots as there are keyframes, so that with evenly spaced keys each slot points directly to the right one
+    unsigned numSlots = keyFrames_.Size();
+    keyFrameIndexScale_ = (float)numSlots / keyFrames_.Back().time_;
+    keyFrameIndex_.Resize(numSlots);
+
+    unsigned index = 0;
+    for (unsigned i = 0; i < numSlots; ++i)
+    {
+        float slotTime = (float)i / keyFrameIndexScale_;
+        while (index < keyFrames_.Size() - 1 && slotTime >= keyFrames_[index + 1].time_)
+            ++index;
+        keyFrameIndex_[i] = index;
+    }
+}
+
+String AnimationCompressionReport::ToString() const
+{
+    return Atomic::ToString("keyframes %u -> %u, size %u -> %u bytes, max error position %f rotation %f scale %f",
+        originalKeyFrames_, compressedKeyFrames_, originalSize_, compressedSize_, maxPositionError_, maxRotationError_,
+        maxScaleError_);
+}
+
 Animation::Animation(Context* context) :
     Resource(context),
-    length_(0.f)
+    length_(0.f),
+    compressed_(false)
 {
 }
 
@@ -79,7 +331,8 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UANC")
     {
         LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
@@ -90,13 +343,16 @@ bool Animation::BeginLoad(Deserializer& source)
     animationNameHash_ = animationName_;
     length_ = source.ReadFloat();
     tracks_.Clear();
+    compressed_ = fileID == "UANC";
 
     unsigned tracks = source.ReadUInt();
     tracks_.Resize(tracks);
     memoryUse += tracks * sizeof(AnimationTrack);
 
     // Read tracks
-    for (unsigned i = 0; i < tracks; ++i)
+    if (compressed_)
+        memoryUse += ReadCompressedTracks(source);
+    else for (unsigned i = 0; i < tracks; ++i)
     {
         AnimationTrack& newTrack = tracks_[i];
         newTrack.name_ = source.ReadString();
@@ -121,6 +377,12 @@ bool Animation::BeginLoad(Deserializer& source)
         }
     }
 
+    for (unsigned i = 0; i < tracks; ++i)
+    {
+        tracks_[i].BuildKeyFrameIndex();
+        memoryUse += tracks_[i].keyFrameIndex_.Size() * sizeof(unsigned);
+    }
+
     // Optionally read triggers from an XML file
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     String xmlName = ReplaceExtension(GetName(), ".xml");
@@ -150,32 +412,16 @@ bool Animation::BeginLoad(Deserializer& source)
 bool Animation::Save(Serializer& dest) const
 {
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    dest.WriteFileID(compressed_ ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
     // Write tracks
     dest.WriteUInt(tracks_.Size());
-    for (unsigned i = 0; i < tracks_.Size(); ++i)
-    {
-        const AnimationTrack& track = tracks_[i];
-        dest.WriteString(track.name_);
-        dest.WriteUByte(track.channelMask_);
-        dest.WriteUInt(track.keyFrames_.Size());
-
-        // Write keyframes of the track
-        for (unsigned j = 0; j < track.keyFrames_.Size(); ++j)
-        {
-            const AnimationKeyFrame& keyFrame = track.keyFrames_[j];
-            dest.WriteFloat(keyFrame.time_);
-            if (track.channelMask_ & CHANNEL_POSITION)
-                dest.WriteVector3(keyFrame.position_);
-            if (track.channelMask_ & CHANNEL_ROTATION)
-                dest.WriteQuaternion(keyFrame.rotation_);
-            if (track.channelMask_ & CHANNEL_SCALE)
-                dest.WriteVector3(keyFrame.scale_);
-        }
-    }
+    if (compressed_)
+        WriteCompressedTracks(dest);
+    else
+        WriteTracks(dest);
 
     // If triggers have been defined, write an XML file for them
     if (triggers_.Size())
@@ -219,6 +465,9 @@ void Animation::SetLength(float length)
 void Animation::SetTracks(const Vector<AnimationTrack>& tracks)
 {
     tracks_ = tracks;
+
+    for (Vector<AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->BuildKeyFrameIndex();
 }
 
 void Animation::AddTrigger(float time, bool timeIsNormalized, const Variant& data)
@@ -247,6 +496,204 @@ void Animation::SetNumTriggers(unsigned num)
     triggers_.Resize(num);
 }
 
+AnimationCompressionReport Animation::Compress(const AnimationCompressionSettings& settings)
+{
+    AnimationCompressionReport report;
+
+    VectorBuffer originalData;
+    WriteTracks(originalData);
+    report.originalSize_ = originalData.GetSize();
+
+    Vector<AnimationTrack> originalTracks = tracks_;
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+    {
+        AnimationTrack& track = tracks_[i];
+        report.originalKeyFrames_ += track.keyFrames_.Size();
+
+        ReduceKeyFrames(track, settings);
+        QuantizeKeyFrames(track);
+        track.BuildKeyFrameIndex();
+        report.compressedKeyFrames_ += track.keyFrames_.Size();
+
+        // Measure the error at the original keyframes
+        const AnimationTrack& originalTrack = originalTracks[i];
+        unsigned frame = 0;
+        for (unsigned j = 0; j < originalTrack.keyFrames_.Size() && track.keyFrames_.Size(); ++j)
+        {
+            const AnimationKeyFrame& original = originalTrack.keyFrames_[j];
+            AnimationKeyFrame sampled = SampleTrack(track, original.time_, frame);
+            if (track.channelMask_ & CHANNEL_POSITION)
+                report.maxPositionError_ = Max(report.maxPositionError_, (sampled.position_ - original.position_).Length());
+            if (track.channelMask_ & CHANNEL_ROTATION)
+                report.maxRotationError_ = Max(report.maxRotationError_, GetRotationError(sampled.rotation_, original.rotation_));
+            if (track.channelMask_ & CHANNEL_SCALE)
+                report.maxScaleError_ = Max(report.maxScaleError_, (sampled.scale_ - original.scale_).Length());
+        }
+    }
+
+    compressed_ = true;
+
+    VectorBuffer compressedData;
+    WriteCompressedTracks(compressedData);
+    report.compressedSize_ = compressedData.GetSize();
+
+    return report;
+}
+
+void Animation::WriteTracks(Serializer& dest) const
+{
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+    {
+        const AnimationTrack& track = tracks_[i];
+        dest.WriteString(track.name_);
+        dest.WriteUByte(track.channelMask_);
+        dest.WriteUInt(track.keyFrames_.Size());
+
+        // Write keyframes of the track
+        for (unsigned j = 0; j < track.keyFrames_.Size(); ++j)
+        {
+            const AnimationKeyFrame& keyFrame = track.keyFrames_[j];
+            dest.WriteFloat(keyFrame.time_);
+            if (track.channelMask_ & CHANNEL_POSITION)
+                dest.WriteVector3(keyFrame.position_);
+            if (track.channelMask_ & CHANNEL_ROTATION)
+                dest.WriteQuaternion(keyFrame.rotation_);
+            if (track.channelMask_ & CHANNEL_SCALE)
+                dest.WriteVector3(keyFrame.scale_);
+        }
+    }
+}
+
+static void WriteQuantized(Serializer& dest, const unsigned short* quantized)
+{
+    for (unsigned i = 0; i < 3; ++i)
+        dest.WriteUShort(quantized[i]);
+}
+
+static void ReadQuantized(Deserializer& source, unsigned short* quantized)
+{
+    for (unsigned i = 0; i < 3; ++i)
+        quantized[i] = source.ReadUShort();
+}
+
+void Animation::WriteCompressedTracks(Serializer& dest) const
+{
+    unsigned short quantized[3];
+
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+    {
+        const AnimationTrack& track = tracks_[i];
+        const Vector<AnimationKeyFrame>& keyFrames = track.keyFrames_;
+        dest.WriteString(track.name_);
+        dest.WriteUByte(track.channelMask_);
+        dest.WriteUInt(keyFrames.Size());
+        if (keyFrames.Empty())
+            continue;
+
+        // Write each channel as a separate array of 16-bit values, times and vectors relative to the track's range
+        float timeRange = keyFrames.Back().time_;
+        dest.WriteFloat(timeRange);
+        for (unsigned j = 0; j < keyFrames.Size(); ++j)
+            dest.WriteUShort(QuantizeFloat(keyFrames[j].time_, 0.0f, timeRange));
+
+        if (track.channelMask_ & CHANNEL_POSITION)
+        {
+            Vector3 min, range;
+            GetTrackRange(track, CHANNEL_POSITION, min, range);
+            dest.WriteVector3(min);
+            dest.WriteVector3(range);
+            for (unsigned j = 0; j < keyFrames.Size(); ++j)
+            {
+                QuantizeVector3(keyFrames[j].position_, min, range, quantized);
+                WriteQuantized(dest, quantized);
+            }
+        }
+        if (track.channelMask_ & CHANNEL_ROTATION)
+        {
+            for (unsigned j = 0; j < keyFrames.Size(); ++j)
+            {
+                QuantizeRotation(keyFrames[j].rotation_, quantized);
+                WriteQuantized(dest, quantized);
+            }
+        }
+        if (track.channelMask_ & CHANNEL_SCALE)
+        {
+            Vector3 min, range;
+            GetTrackRange(track, CHANNEL_SCALE, min, range);
+            dest.WriteVector3(min);
+            dest.WriteVector3(range);
+            for (unsigned j = 0; j < keyFrames.Size(); ++j)
+            {
+                QuantizeVector3(keyFrames[j].scale_, min, range, quantized);
+                WriteQuantized(dest, quantized);
+            }
+        }
+    }
+}
+
+unsigned Animation::ReadCompressedTracks(Deserializer& source)
+{
+    unsigned memoryUse = 0;
+    unsigned short quantized[3];
+
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+    {
+        AnimationTrack& newTrack = tracks_[i];
+        newTrack.name_ = source.ReadString();
+        newTrack.nameHash_ = newTrack.name_;
+        newTrack.channelMask_ = source.ReadUByte();
+
+        unsigned keyFrames = source.ReadUInt();
+        newTrack.keyFrames_.Resize(keyFrames);
+        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
+        if (!keyFrames)
+            continue;
+
+        for (unsigned j = 0; j < keyFrames; ++j)
+        {
+            AnimationKeyFrame& newKeyFrame = newTrack.keyFrames_[j];
+            newKeyFrame.position_ = Vector3::ZERO;
+            newKeyFrame.rotation_ = Quaternion::IDENTITY;
+            newKeyFrame.scale_ = Vector3::ONE;
+        }
+
+        float timeRange = source.ReadFloat();
+        for (unsigned j = 0; j < keyFrames; ++j)
+            newTrack.keyFrames_[j].time_ = DequantizeFloat(source.ReadUShort(), 0.0f, timeRange);
+
+        if (newTrack.channelMask_ & CHANNEL_POSITION)
+        {
+            Vector3 min = source.ReadVector3();
+            Vector3 range = source.ReadVector3();
+            for (unsigned j = 0; j < keyFrames; ++j)
+            {
+                ReadQuantized(source, quantized);
+                newTrack.keyFrames_[j].position_ = DequantizeVector3(quantized, min, range);
+            }
+        }
+        if (newTrack.channelMask_ & CHANNEL_ROTATION)
+        {
+            for (unsigned j = 0; j < keyFrames; ++j)
+            {
+                ReadQuantized(source, quantized);
+                newTrack.keyFrames_[j].rotation_ = DequantizeRotation(quantized);
+            }
+        }
+        if (newTrack.channelMask_ & CHANNEL_SCALE)
+        {
+            Vector3 min = source.ReadVector3();
+            Vector3 range = source.ReadVector3();
+            for (unsigned j = 0; j < keyFrames; ++j)
+            {
+                ReadQuantized(source, quantized);
+                newTrack.keyFrames_[j].scale_ = DequantizeVector3(quantized, min, range);
+            }
+        }
+    }
+
+    return memoryUse;
+}
+
 const AnimationTrack* Animation::GetTrack(unsigned index) const
 {
     return index < tracks_.Size() ? &tracks_[index] : 0;
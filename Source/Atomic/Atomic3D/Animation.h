@@ -46,8 +46,17 @@ struct AnimationKeyFrame
 /// Skeletal animation track, stores keyframes of a single bone.
 struct AnimationTrack
 {
+    /// Construct.
+    AnimationTrack() :
+        channelMask_(0),
+        keyFrameIndexScale_(0.0f)
+    {
+    }
+
     /// Return keyframe index based on time and previous index.
     void GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Build the time-to-keyframe lookup table. Should be called after modifying the keyframes.
+    void BuildKeyFrameIndex();
 
     /// Bone name.
     String name_;
@@ -57,6 +66,63 @@ struct AnimationTrack
     unsigned char channelMask_;
     /// Keyframes.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Time-to-keyframe lookup table for seeking in constant time.
+    PODVector<unsigned> keyFrameIndex_;
+    /// Multiplier to convert time to a lookup table slot.
+    float keyFrameIndexScale_;
+};
+
+/// %Animation compression settings.
+struct AnimationCompressionSettings
+{
+    /// Construct with default tolerances.
+    AnimationCompressionSettings() :
+        positionTolerance_(0.001f),
+        rotationTolerance_(0.1f),
+        scaleTolerance_(0.001f)
+    {
+    }
+
+    /// Maximum position error allowed when removing keyframes.
+    float positionTolerance_;
+    /// Maximum rotation error in degrees allowed when removing keyframes.
+    float rotationTolerance_;
+    /// Maximum scale error allowed when removing keyframes.
+    float scaleTolerance_;
+};
+
+/// %Animation compression result.
+struct ATOMIC_API AnimationCompressionReport
+{
+    /// Construct.
+    AnimationCompressionReport() :
+        originalKeyFrames_(0),
+        compressedKeyFrames_(0),
+        originalSize_(0),
+        compressedSize_(0),
+        maxPositionError_(0.0f),
+        maxRotationError_(0.0f),
+        maxScaleError_(0.0f)
+    {
+    }
+
+    /// Return as a human-readable string.
+    String ToString() const;
+
+    /// Keyframe count before compression.
+    unsigned originalKeyFrames_;
+    /// Keyframe count after compression.
+    unsigned compressedKeyFrames_;
+    /// Serialized track data size in bytes before compression.
+    unsigned originalSize_;
+    /// Serialized track data size in bytes after compression.
+    unsigned compressedSize_;
+    /// Maximum position error at the original keyframes.
+    float maxPositionError_;
+    /// Maximum rotation error in degrees at the original keyframes.
+    float maxRotationError_;
+    /// Maximum scale error at the original keyframes.
+    float maxScaleError_;
 };
 
 /// %Animation trigger point.
@@ -110,6 +176,10 @@ public:
     void RemoveAllTriggers();
     /// Resize trigger point vector.
     void SetNumTriggers(unsigned num);
+    /// Remove keyframes that can be reproduced by interpolation, quantize the rest and save in compressed format from now on. Return memory and accuracy statistics.
+    AnimationCompressionReport Compress(const AnimationCompressionSettings& settings = AnimationCompressionSettings());
+    /// Set whether to save in compressed format.
+    void SetCompressed(bool enable) { compressed_ = enable; }
 
     /// Return animation name.
     const String& GetAnimationName() const { return animationName_; }
@@ -139,7 +209,17 @@ public:
     /// Return number of animation trigger points.
     unsigned GetNumTriggers() const { return triggers_.Size(); }
 
+    /// Return whether saves in compressed format.
+    bool IsCompressed() const { return compressed_; }
+
 private:
+    /// Write tracks with full precision keyframes.
+    void WriteTracks(Serializer& dest) const;
+    /// Write tracks with quantized keyframes in structure-of-arrays layout.
+    void WriteCompressedTracks(Serializer& dest) const;
+    /// Read tracks with quantized keyframes. Return memory use.
+    unsigned ReadCompressedTracks(Deserializer& source);
+
     /// Animation name.
     String animationName_;
     /// Animation name hash.
@@ -150,6 +230,8 @@ private:
     Vector<AnimationTrack> tracks_;
     /// Animation trigger points.
     Vector<AnimationTriggerPoint> triggers_;
+    /// Compressed format flag.
+    bool compressed_;
 };
 
 }
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Atomic3D/AnimationPoseCache.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+AnimationPoseCache::AnimationPoseCache() :
+    frameNumber_(0)
+{
+}
+
+bool AnimationPoseCache::GetPose(unsigned frameNumber, const AnimationPoseKey& key, PODVector<Matrix3x4>& dest)
+{
+    MutexLock lock(poseMutex_);
+
+    SetFrame(frameNumber);
+    HashMap<AnimationPoseKey, PODVector<Matrix3x4> >::ConstIterator i = poses_.Find(key);
+    if (i == poses_.End())
+        return false;
+
+    dest = i->second_;
+    return true;
+}
+
+void AnimationPoseCache::SetPose(unsigned frameNumber, const AnimationPoseKey& key, const PODVector<Matrix3x4>& transforms)
+{
+    MutexLock lock(poseMutex_);
+
+    SetFrame(frameNumber);
+    poses_[key] = transforms;
+}
+
+void AnimationPoseCache::Clear()
+{
+    MutexLock lock(poseMutex_);
+
+    poses_.Clear();
+}
+
+void AnimationPoseCache::SetFrame(unsigned frameNumber)
+{
+    if (frameNumber != frameNumber_)
+    {
+        poses_.Clear();
+        frameNumber_ = frameNumber;
+    }
+}
+
+}
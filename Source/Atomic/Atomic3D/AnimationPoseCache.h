@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Core/Mutex.h"
+#include "../Math/Matrix3x4.h"
+
+namespace Atomic
+{
+
+/// Description of an animated model's quantized animation state, identifies models that can share an evaluated pose.
+struct ATOMIC_API AnimationPoseKey
+{
+    /// Construct empty.
+    AnimationPoseKey() :
+        hash_(0)
+    {
+    }
+
+    /// Test for equality with another key.
+    bool operator ==(const AnimationPoseKey& rhs) const { return hash_ == rhs.hash_ && data_ == rhs.data_; }
+
+    /// Test for inequality with another key.
+    bool operator !=(const AnimationPoseKey& rhs) const { return !(*this == rhs); }
+
+    /// Append a value.
+    void Append(unsigned value)
+    {
+        data_.Push(value);
+        hash_ ^= value + 0x9e3779b9 + (hash_ << 6) + (hash_ >> 2);
+    }
+
+    /// Append a pointer value.
+    void Append(const void* value)
+    {
+        unsigned long long bits = (unsigned long long)(size_t)value;
+        Append((unsigned)bits);
+        Append((unsigned)(bits >> 32));
+    }
+
+    /// Return hash value for HashMap.
+    unsigned ToHash() const { return hash_; }
+
+    /// Key values.
+    PODVector<unsigned> data_;
+    /// Hash value.
+    unsigned hash_;
+};
+
+/// Cache of the model space bone transforms evaluated during the current frame, for sharing between animated models that use the same model and animation state. Thread-safe, since animation is updated in worker threads.
+class ATOMIC_API AnimationPoseCache
+{
+public:
+    /// Construct.
+    AnimationPoseCache();
+
+    /// Copy a pose evaluated during the frame to the destination. Return true if found.
+    bool GetPose(unsigned frameNumber, const AnimationPoseKey& key, PODVector<Matrix3x4>& dest);
+    /// Store a pose evaluated during the frame.
+    void SetPose(unsigned frameNumber, const AnimationPoseKey& key, const PODVector<Matrix3x4>& transforms);
+    /// Remove all stored poses.
+    void Clear();
+
+    /// Return number of poses stored for the current frame.
+    unsigned GetNumPoses() const { return poses_.Size(); }
+
+private:
+    /// Discard the poses of earlier frames. Called with the mutex held.
+    void SetFrame(unsigned frameNumber);
+
+    /// Stored poses.
+    HashMap<AnimationPoseKey, PODVector<Matrix3x4> > poses_;
+    /// Frame number of the stored poses.
+    unsigned frameNumber_;
+    /// Mutex for accessing the poses.
+    Mutex poseMutex_;
+};
+
+}
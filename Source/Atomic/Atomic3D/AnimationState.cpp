@@ -36,6 +36,7 @@ namespace Atomic
 AnimationStateTrack::AnimationStateTrack() :
     track_(0),
     bone_(0),
+    boneIndex_(0),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -151,6 +152,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = (unsigned)(trackBone - &skeleton.GetModifiableBones()[0]);
             stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
@@ -389,6 +391,20 @@ float AnimationState::GetLength() const
     return animation_ ? animation_->GetLength() : 0.0f;
 }
 
+void AnimationState::AppendPoseKey(AnimationPoseKey& key, float interval) const
+{
+    key.Append(animation_.Get());
+    // Each model has its own skeleton copy, so identify the start bone by name instead of by pointer
+    key.Append(startBone_ ? startBone_->nameHash_.Value() : 0);
+    key.Append((unsigned)looped_);
+    key.Append((unsigned)layer_);
+    key.Append((unsigned)(time_ / interval));
+    key.Append((unsigned)(weight_ * 255.0f + 0.5f));
+
+    for (Vector<AnimationStateTrack>::ConstIterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
+        key.Append((unsigned)(i->weight_ * 255.0f + 0.5f));
+}
+
 void AnimationState::Apply()
 {
     if (!animation_ || !IsEnabled())
@@ -402,6 +418,10 @@ void AnimationState::Apply()
 
 void AnimationState::ApplyToModel()
 {
+    PODVector<BonePose>& pose = model_->bonePose_;
+    if (pose.Size() != model_->GetSkeleton().GetNumBones())
+        return;
+
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
     {
         AnimationStateTrack& stateTrack = *i;
@@ -411,10 +431,7 @@ void AnimationState::ApplyToModel()
         if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
             continue;
 
-        if (Equals(finalWeight, 1.0f))
-            ApplyTrackFullWeightSilent(stateTrack);
-        else
-            ApplyTrackBlendedSilent(stateTrack, finalWeight);
+        ApplyTrackToPose(stateTrack, pose[stateTrack.boneIndex_], finalWeight);
     }
 }
 
@@ -481,12 +498,11 @@ void AnimationState::ApplyTrackFullWeight(AnimationStateTrack& stateTrack)
     }
 }
 
-void AnimationState::ApplyTrackFullWeightSilent(AnimationStateTrack& stateTrack)
+void AnimationState::ApplyTrackToPose(AnimationStateTrack& stateTrack, BonePose& pose, float weight)
 {
     const AnimationTrack* track = stateTrack.track_;
-    Node* node = stateTrack.node_;
 
-    if (track->keyFrames_.Empty() || !node)
+    if (track->keyFrames_.Empty())
         return;
 
     unsigned& frame = stateTrack.keyFrame_;
@@ -508,18 +524,11 @@ void AnimationState::ApplyTrackFullWeightSilent(AnimationStateTrack& stateTrack)
 
     const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
     unsigned char channelMask = track->channelMask_;
+    Vector3 position = keyFrame->position_;
+    Quaternion rotation = keyFrame->rotation_;
+    Vector3 scale = keyFrame->scale_;
 
-    if (!interpolate)
-    {
-        // No interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(keyFrame->position_);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(keyFrame->rotation_);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(keyFrame->scale_);
-    }
-    else
+    if (interpolate)
     {
         const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
         float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
@@ -527,78 +536,33 @@ void AnimationState::ApplyTrackFullWeightSilent(AnimationStateTrack& stateTrack)
             timeInterval += animation_->GetLength();
         float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
 
-        // Interpolation, full weight
         if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(keyFrame->position_.Lerp(nextKeyFrame->position_, t));
+            position = position.Lerp(nextKeyFrame->position_, t);
         if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t));
+            rotation = rotation.Slerp(nextKeyFrame->rotation_, t);
         if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(keyFrame->scale_.Lerp(nextKeyFrame->scale_, t));
+            scale = scale.Lerp(nextKeyFrame->scale_, t);
     }
-}
-
-void AnimationState::ApplyTrackBlendedSilent(AnimationStateTrack& stateTrack, float weight)
-{
-    const AnimationTrack* track = stateTrack.track_;
-    Node* node = stateTrack.node_;
 
-    if (track->keyFrames_.Empty() || !node)
-        return;
-
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
+    if (Equals(weight, 1.0f))
     {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
-
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    unsigned char channelMask = track->channelMask_;
-
-    if (!interpolate)
-    {
-        // No interpolation, blend between old transform & animation
+        // Full weight
         if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(node->GetPosition().Lerp(keyFrame->position_, weight));
+            pose.position_ = position;
         if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(node->GetRotation().Slerp(keyFrame->rotation_, weight));
+            pose.rotation_ = rotation;
         if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(node->GetScale().Lerp(keyFrame->scale_, weight));
+            pose.scale_ = scale;
     }
     else
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-
-        // Interpolation, blend between old transform & animation
+        // Blend between the current pose & animation
         if (channelMask & CHANNEL_POSITION)
-        {
-            node->SetPositionSilent(node->GetPosition().Lerp(
-                keyFrame->position_.Lerp(nextKeyFrame->position_, t), weight));
-        }
+            pose.position_ = pose.position_.Lerp(position, weight);
         if (channelMask & CHANNEL_ROTATION)
-        {
-            node->SetRotationSilent(node->GetRotation().Slerp(
-                keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t), weight));
-        }
+            pose.rotation_ = pose.rotation_.Slerp(rotation, weight);
         if (channelMask & CHANNEL_SCALE)
-        {
-            node->SetScaleSilent(node->GetScale().Lerp(
-                keyFrame->scale_.Lerp(nextKeyFrame->scale_, t), weight));
-        }
+            pose.scale_ = pose.scale_.Lerp(scale, weight);
     }
 }
 
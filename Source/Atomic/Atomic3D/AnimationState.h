@@ -33,6 +33,7 @@ class AnimatedModel;
 class Deserializer;
 class Serializer;
 class Skeleton;
+struct AnimationPoseKey;
 struct AnimationTrack;
 struct Bone;
 
@@ -48,6 +49,8 @@ struct AnimationStateTrack
     const AnimationTrack* track_;
     /// Bone pointer.
     Bone* bone_;
+    /// Bone index in the skeleton.
+    unsigned boneIndex_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
     /// Blending weight.
@@ -130,20 +133,20 @@ public:
     /// Return blending layer.
     unsigned char GetLayer() const { return layer_; }
 
-    /// Apply the animation at the current time position.
+    /// Apply the animation at the current time position. In model mode the animation is blended into the model's pose, which the model applies after all its animation states.
     void Apply();
+    /// Append the animation, time quantized to the interval, and the weights to a pose sharing key.
+    void AppendPoseKey(AnimationPoseKey& key, float interval) const;
 
 private:
-    /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
+    /// Apply animation to the model's pose.
     void ApplyToModel();
     /// Apply animation to a scene node hierarchy.
     void ApplyToNodes();
     /// Apply animation track to a scene node, full weight.
     void ApplyTrackFullWeight(AnimationStateTrack& stateTrack);
-    /// Apply animation track to a scene node, full weight. Apply transform changes silently without marking the node dirty.
-    void ApplyTrackFullWeightSilent(AnimationStateTrack& stateTrack);
-    /// Apply animation track to a scene node, blended with current node transform. Apply transform changes silently without marking the node dirty.
-    void ApplyTrackBlendedSilent(AnimationStateTrack& stateTrack, float weight);
+    /// Apply animation track to a bone pose, blended with the current pose by weight.
+    void ApplyTrackToPose(AnimationStateTrack& stateTrack, BonePose& pose, float weight);
 
     /// Animated model (model mode.)
     WeakPtr<AnimatedModel> model_;
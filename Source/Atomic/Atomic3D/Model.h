@@ -25,6 +25,7 @@
 #include "../Container/ArrayPtr.h"
 #include "../Container/Ptr.h"
 #include "../Graphics/GraphicsDefs.h"
+#include "../Atomic3D/AnimationPoseCache.h"
 #include "../Atomic3D/Skeleton.h"
 #include "../Math/BoundingBox.h"
 #include "../Resource/Resource.h"
@@ -208,6 +209,8 @@ public:
     unsigned GetMorphRangeStart(unsigned bufferIndex) const;
     /// Return vertex buffer morph range vertex count.
     unsigned GetMorphRangeCount(unsigned bufferIndex) const;
+    /// Return the cache of animated poses shared between the animated models using this model.
+    AnimationPoseCache& GetPoseCache() { return poseCache_; }
 
     // ATOMIC BEGIN
 
@@ -238,6 +241,8 @@ private:
     PODVector<unsigned> morphRangeStarts_;
     /// Vertex buffer morph range vertex count.
     PODVector<unsigned> morphRangeCounts_;
+    /// Shared animated poses.
+    AnimationPoseCache poseCache_;
     /// Vertex buffer data for asynchronous loading.
     Vector<VertexBufferDesc> loadVBData_;
     /// Index buffer data for asynchronous loading.
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/FlatHashBase.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+unsigned char* FlatHashBase::AllocateData(unsigned numBuckets, unsigned elementSize)
+{
+    unsigned char* data = new unsigned char[sizeof(Header) + numBuckets * sizeof(FlatHashBucket) +
+        GetCapacity(numBuckets) * elementSize];
+
+    Header* header = reinterpret_cast<Header*>(data);
+    header->size_ = 0;
+    header->mask_ = numBuckets - 1;
+    header->shift_ = 32;
+    header->reserved_ = 0;
+    for (unsigned i = numBuckets; i > 1; i >>= 1)
+        --header->shift_;
+
+    FlatHashBucket* buckets = reinterpret_cast<FlatHashBucket*>(data + sizeof(Header));
+    for (unsigned i = 0; i < numBuckets; ++i)
+        buckets[i].index_ = EMPTY_INDEX;
+
+    return data;
+}
+
+void FlatHashBase::InsertBucket(unsigned hash, unsigned index)
+{
+    FlatHashBucket* buckets = Buckets();
+    unsigned mask = GetHeader()->mask_;
+
+    FlatHashBucket bucket;
+    bucket.hash_ = hash;
+    bucket.index_ = index;
+
+    unsigned pos = HomeBucket(hash);
+    unsigned distance = 0;
+
+    for (;;)
+    {
+        FlatHashBucket& current = buckets[pos];
+        if (current.index_ == EMPTY_INDEX)
+        {
+            current = bucket;
+            return;
+        }
+
+        // Robin Hood: take the place of a bucket that is closer to its home, and continue inserting it instead
+        unsigned currentDistance = ProbeDistance(current.hash_, pos);
+        if (currentDistance < distance)
+        {
+            Atomic::Swap(current, bucket);
+            distance = currentDistance;
+        }
+
+        pos = (pos + 1) & mask;
+        ++distance;
+    }
+}
+
+void FlatHashBase::EraseBucket(unsigned pos)
+{
+    FlatHashBucket* buckets = Buckets();
+    unsigned mask = GetHeader()->mask_;
+
+    for (;;)
+    {
+        unsigned next = (pos + 1) & mask;
+        const FlatHashBucket& nextBucket = buckets[next];
+        if (nextBucket.index_ == EMPTY_INDEX || ProbeDistance(nextBucket.hash_, next) == 0)
+        {
+            buckets[pos].index_ = EMPTY_INDEX;
+            return;
+        }
+
+        buckets[pos] = nextBucket;
+        pos = next;
+    }
+}
+
+unsigned FlatHashBase::FindBucketByIndex(unsigned hash, unsigned index) const
+{
+    const FlatHashBucket* buckets = Buckets();
+    unsigned mask = GetHeader()->mask_;
+    unsigned pos = HomeBucket(hash);
+
+    while (buckets[pos].index_ != index)
+        pos = (pos + 1) & mask;
+
+    return pos;
+}
+
+void FlatHashBase::CopyBuckets(unsigned char* newData) const
+{
+    FlatHashBase newBase;
+    newBase.data_ = newData;
+
+    unsigned numBuckets = NumBuckets();
+    const FlatHashBucket* buckets = Buckets();
+    for (unsigned i = 0; i < numBuckets; ++i)
+    {
+        if (buckets[i].index_ != EMPTY_INDEX)
+            newBase.InsertBucket(buckets[i].hash_, buckets[i].index_);
+    }
+
+    newBase.data_ = 0;
+}
+
+}
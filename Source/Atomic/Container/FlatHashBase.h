@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+
+#include <new>
+
+namespace Atomic
+{
+
+/// Flat hash set/map bucket. Points to an element in the dense element array.
+struct FlatHashBucket
+{
+    /// Full hash of the element's key.
+    unsigned hash_;
+    /// Index of the element, or FlatHashBase::EMPTY_INDEX if the bucket is empty.
+    unsigned index_;
+};
+
+/// Flat hash set/map base class.
+/** Elements are stored contiguously in insertion order, followed by an open-addressing bucket table using Robin Hood
+    linear probing. Element storage, buckets and bookkeeping live in a single allocation, so an empty container
+    allocates nothing and the container itself is the size of one pointer. Unlike %HashMap and %HashSet, inserting
+    may move elements in memory, and erasing moves the last element into the erased position.
+    To prevent extra memory use due to vtable pointer, %FlatHashBase intentionally does not declare a virtual destructor
+    and therefore %FlatHashBase pointers should never be used.
+  */
+class ATOMIC_API FlatHashBase
+{
+public:
+    /// Initial amount of buckets.
+    static const unsigned MIN_BUCKETS = 8;
+    /// Empty bucket index.
+    static const unsigned EMPTY_INDEX = 0xffffffff;
+    /// Not found bucket position.
+    static const unsigned NOT_FOUND = 0xffffffff;
+
+    /// Construct.
+    FlatHashBase() :
+        data_(0)
+    {
+    }
+
+    /// Swap with another flat hash set or map.
+    void Swap(FlatHashBase& rhs) { Atomic::Swap(data_, rhs.data_); }
+
+    /// Return number of elements.
+    unsigned Size() const { return data_ ? GetHeader()->size_ : 0; }
+
+    /// Return number of buckets.
+    unsigned NumBuckets() const { return data_ ? GetHeader()->mask_ + 1 : 0; }
+
+    /// Return number of elements that fit before the buckets need to grow.
+    unsigned Capacity() const { return data_ ? GetCapacity(NumBuckets()) : 0; }
+
+    /// Return whether has no elements.
+    bool Empty() const { return Size() == 0; }
+
+protected:
+    /// Bookkeeping data at the start of the allocation.
+    struct Header
+    {
+        /// Number of elements.
+        unsigned size_;
+        /// Bucket count minus one.
+        unsigned mask_;
+        /// Shift for mapping a hash to its home bucket.
+        unsigned shift_;
+        /// Padding to keep the element array aligned.
+        unsigned reserved_;
+    };
+
+    /// Return the element capacity for a bucket count. Keeps the load factor at most 75%.
+    static unsigned GetCapacity(unsigned numBuckets) { return numBuckets - (numBuckets >> 2); }
+
+    /// Allocate data for a bucket count and element size. Buckets are cleared and size is zero.
+    static unsigned char* AllocateData(unsigned numBuckets, unsigned elementSize);
+
+    /// Return header.
+    Header* GetHeader() const { return reinterpret_cast<Header*>(data_); }
+
+    /// Return buckets.
+    FlatHashBucket* Buckets() const { return reinterpret_cast<FlatHashBucket*>(data_ + sizeof(Header)); }
+
+    /// Return start of element storage.
+    unsigned char* Elements() const { return data_ ? data_ + sizeof(Header) + NumBuckets() * sizeof(FlatHashBucket) : 0; }
+
+    /// Set new size.
+    void SetSize(unsigned size) { GetHeader()->size_ = size; }
+
+    /// Return home bucket of a hash. Uses Fibonacci hashing so that hashes with poor low bits still spread out.
+    unsigned HomeBucket(unsigned hash) const { return (hash * 2654435769U) >> GetHeader()->shift_; }
+
+    /// Return probe distance of a hash found at a bucket position.
+    unsigned ProbeDistance(unsigned hash, unsigned pos) const { return (pos - HomeBucket(hash)) & GetHeader()->mask_; }
+
+    /// Insert an element index to the buckets.
+    void InsertBucket(unsigned hash, unsigned index);
+    /// Erase a bucket by position, shifting following buckets back.
+    void EraseBucket(unsigned pos);
+    /// Return bucket position pointing to an element index. The element must exist.
+    unsigned FindBucketByIndex(unsigned hash, unsigned index) const;
+    /// Rebuild the buckets of new data from the buckets of the current data. Element indices do not change.
+    void CopyBuckets(unsigned char* newData) const;
+
+    /// Allocation holding header, buckets and elements. Null if not allocated.
+    unsigned char* data_;
+};
+
+}
@@ -0,0 +1,451 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+
+namespace Atomic
+{
+
+/// Open-addressing hash map template class with contiguous element storage. Offers the same interface as %HashMap except sorting.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+
+    private:
+        /// Prevent assignment.
+        KeyValue& operator =(const KeyValue& rhs);
+    };
+
+    typedef RandomAccessIterator<KeyValue> Iterator;
+    typedef RandomAccessConstIterator<KeyValue> ConstIterator;
+
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        Insert(map);
+    }
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        Clear();
+        delete[] data_;
+    }
+
+    /// Assign a hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash map.
+    bool operator ==(const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash map.
+    bool operator !=(const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        unsigned hashKey = MakeHash(key);
+        unsigned pos = FindBucket(key, hashKey);
+        return pos != NOT_FOUND ? ElementAt(Buckets()[pos].index_)->second_ : InsertElement(key, U(), hashKey)->second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        return pos != NOT_FOUND ? &ElementAt(Buckets()[pos].index_)->second_ : 0;
+    }
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        unsigned hashKey = MakeHash(pair.first_);
+        unsigned pos = FindBucket(pair.first_, hashKey);
+        if (pos != NOT_FOUND)
+        {
+            KeyValue* element = ElementAt(Buckets()[pos].index_);
+            element->second_ = pair.second_;
+            return Iterator(element);
+        }
+
+        return Iterator(InsertElement(pair.first_, pair.second_, hashKey));
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        if (map.Size() > Capacity() - Size())
+            Reserve(Size() + map.Size());
+
+        for (ConstIterator it = map.Begin(); it != map.End(); ++it)
+            Insert(MakePair(it->first_, it->second_));
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(MakePair(it->first_, it->second_)); }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator it = start; it != end; ++it)
+            Insert(it);
+    }
+
+    /// Insert a pair only if a corresponding key does not already exist.
+    Iterator InsertNew(const T& key, const U& value)
+    {
+        unsigned hashKey = MakeHash(key);
+        unsigned pos = FindBucket(key, hashKey);
+        if (pos != NOT_FOUND)
+            return Iterator(ElementAt(Buckets()[pos].index_));
+
+        return Iterator(InsertElement(key, value, hashKey));
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        if (pos == NOT_FOUND)
+            return false;
+
+        EraseElement(pos);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair, which is the last pair moved into the erased position.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!data_ || !it.ptr_ || it == End())
+            return End();
+
+        unsigned index = (unsigned)(it.ptr_ - ElementAt(0));
+        EraseElement(FindBucketByIndex(MakeHash(it->first_), index));
+        return Iterator(ElementAt(index));
+    }
+
+    /// Clear the map.
+    void Clear()
+    {
+        if (!data_)
+            return;
+
+        unsigned size = Size();
+        for (unsigned i = 0; i < size; ++i)
+            (ElementAt(i))->~KeyValue();
+
+        unsigned numBuckets = NumBuckets();
+        FlatHashBucket* buckets = Buckets();
+        for (unsigned i = 0; i < numBuckets; ++i)
+            buckets[i].index_ = EMPTY_INDEX;
+
+        SetSize(0);
+    }
+
+    /// Rehash to a specific bucket count, which must be a power of two and hold the current elements. Return true if successful.
+    bool Rehash(unsigned numBuckets)
+    {
+        if (numBuckets == NumBuckets())
+            return true;
+        if (!numBuckets || GetCapacity(numBuckets) < Size() || numBuckets < MIN_BUCKETS)
+            return false;
+
+        // Check for being power of two
+        unsigned check = numBuckets;
+        while (!(check & 1))
+            check >>= 1;
+        if (check != 1)
+            return false;
+
+        unsigned char* newData = AllocateData(numBuckets, (unsigned)sizeof(KeyValue));
+        if (data_)
+        {
+            unsigned size = Size();
+            KeyValue* oldElements = ElementAt(0);
+            KeyValue* newElements = reinterpret_cast<KeyValue*>(newData + sizeof(Header) + numBuckets * sizeof(FlatHashBucket));
+            for (unsigned i = 0; i < size; ++i)
+            {
+                new(newElements + i) KeyValue(oldElements[i]);
+                (oldElements + i)->~KeyValue();
+            }
+
+            CopyBuckets(newData);
+            reinterpret_cast<Header*>(newData)->size_ = size;
+            delete[] data_;
+        }
+
+        data_ = newData;
+        return true;
+    }
+
+    /// Reserve buckets so that at least the specified number of elements fit without rehashing.
+    void Reserve(unsigned size)
+    {
+        unsigned numBuckets = data_ ? NumBuckets() : MIN_BUCKETS;
+        while (GetCapacity(numBuckets) < size)
+            numBuckets <<= 1;
+        Rehash(numBuckets);
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        return pos != NOT_FOUND ? Iterator(ElementAt(Buckets()[pos].index_)) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        return pos != NOT_FOUND ? ConstIterator(ElementAt(Buckets()[pos].index_)) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindBucket(key, MakeHash(key)) != NOT_FOUND; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(ElementAt(0)); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(ElementAt(0)); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(ElementAt(Size())); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(ElementAt(Size())); }
+
+    /// Return first key.
+    const T& Front() const { return Begin()->first_; }
+
+    /// Return last key.
+    const T& Back() const { return (--End())->first_; }
+
+private:
+    /// Return element by index. Null if not allocated.
+    KeyValue* ElementAt(unsigned index) const { return data_ ? reinterpret_cast<KeyValue*>(Elements()) + index : 0; }
+
+    /// Return bucket position of a key, or NOT_FOUND.
+    unsigned FindBucket(const T& key, unsigned hashKey) const
+    {
+        if (!data_)
+            return NOT_FOUND;
+
+        const FlatHashBucket* buckets = Buckets();
+        unsigned mask = GetHeader()->mask_;
+        unsigned pos = HomeBucket(hashKey);
+        unsigned distance = 0;
+
+        for (;;)
+        {
+            const FlatHashBucket& bucket = buckets[pos];
+            // An empty bucket, or one closer to its home than the key would be, ends the search
+            if (bucket.index_ == EMPTY_INDEX || ProbeDistance(bucket.hash_, pos) < distance)
+                return NOT_FOUND;
+            if (bucket.hash_ == hashKey && ElementAt(bucket.index_)->first_ == key)
+                return pos;
+
+            pos = (pos + 1) & mask;
+            ++distance;
+        }
+    }
+
+    /// Append a new element, which must not exist yet. Return pointer to it.
+    KeyValue* InsertElement(const T& key, const U& value, unsigned hashKey)
+    {
+        unsigned size = Size();
+        if (!data_ || size >= Capacity())
+        {
+            // Key or value may refer to an element of this map, which growing would move, so copy them first
+            KeyValue pair(key, value);
+            Rehash(data_ ? NumBuckets() << 1 : MIN_BUCKETS);
+            return ConstructElement(pair, hashKey);
+        }
+
+        KeyValue* element = ElementAt(size);
+        new(element) KeyValue(key, value);
+        InsertBucket(hashKey, size);
+        SetSize(size + 1);
+        return element;
+    }
+
+    /// Construct a copy of a pair at the end, which must have room.
+    KeyValue* ConstructElement(const KeyValue& pair, unsigned hashKey)
+    {
+        unsigned size = Size();
+        KeyValue* element = ElementAt(size);
+        new(element) KeyValue(pair);
+        InsertBucket(hashKey, size);
+        SetSize(size + 1);
+        return element;
+    }
+
+    /// Erase the element referred to by a bucket position. The last element is moved into its place.
+    void EraseElement(unsigned pos)
+    {
+        unsigned index = Buckets()[pos].index_;
+        unsigned last = Size() - 1;
+        EraseBucket(pos);
+
+        KeyValue* element = ElementAt(index);
+        element->~KeyValue();
+
+        if (index != last)
+        {
+            KeyValue* lastElement = ElementAt(last);
+            unsigned lastPos = FindBucketByIndex(MakeHash(lastElement->first_), last);
+            new(element) KeyValue(*lastElement);
+            lastElement->~KeyValue();
+            Buckets()[lastPos].index_ = index;
+        }
+
+        SetSize(last);
+    }
+};
+
+template <class T, class U> void Swap(FlatHashMap<T, U>& first, FlatHashMap<T, U>& second)
+{
+    first.Swap(second);
+}
+
+}
+
+namespace std
+{
+
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::ConstIterator begin(const Atomic::FlatHashMap<T, U>& v)
+{
+    return v.Begin();
+}
+
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::ConstIterator end(const Atomic::FlatHashMap<T, U>& v) { return v.End(); }
+
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::Iterator begin(Atomic::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Atomic::FlatHashMap<T, U>::Iterator end(Atomic::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
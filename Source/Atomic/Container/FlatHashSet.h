@@ -0,0 +1,351 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+
+namespace Atomic
+{
+
+/// Open-addressing hash set template class with contiguous element storage. Offers the same interface as %HashSet except sorting.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+    /// Construct from another hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        Insert(set);
+    }
+
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        Clear();
+        delete[] data_;
+    }
+
+    /// Assign a hash set.
+    FlatHashSet& operator =(const FlatHashSet<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash set.
+    bool operator ==(const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash set.
+    bool operator !=(const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        unsigned hashKey = MakeHash(key);
+        unsigned pos = FindBucket(key, hashKey);
+        if (pos != NOT_FOUND)
+            return Iterator(ElementAt(Buckets()[pos].index_));
+
+        return Iterator(InsertElement(key, hashKey));
+    }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        unsigned oldSize = Size();
+        Iterator ret = Insert(key);
+        exists = (Size() == oldSize);
+        return ret;
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        if (set.Size() > Capacity() - Size())
+            Reserve(Size() + set.Size());
+
+        for (ConstIterator it = set.Begin(); it != set.End(); ++it)
+            Insert(*it);
+    }
+
+    /// Insert a key by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(*it); }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        if (pos == NOT_FOUND)
+            return false;
+
+        EraseElement(pos);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key, which is the last key moved into the erased position.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!data_ || !it.ptr_ || it == End())
+            return End();
+
+        unsigned index = (unsigned)(it.ptr_ - ElementAt(0));
+        EraseElement(FindBucketByIndex(MakeHash(*it), index));
+        return Iterator(ElementAt(index));
+    }
+
+    /// Clear the set.
+    void Clear()
+    {
+        if (!data_)
+            return;
+
+        unsigned size = Size();
+        for (unsigned i = 0; i < size; ++i)
+            (ElementAt(i))->~T();
+
+        unsigned numBuckets = NumBuckets();
+        FlatHashBucket* buckets = Buckets();
+        for (unsigned i = 0; i < numBuckets; ++i)
+            buckets[i].index_ = EMPTY_INDEX;
+
+        SetSize(0);
+    }
+
+    /// Rehash to a specific bucket count, which must be a power of two and hold the current elements. Return true if successful.
+    bool Rehash(unsigned numBuckets)
+    {
+        if (numBuckets == NumBuckets())
+            return true;
+        if (!numBuckets || GetCapacity(numBuckets) < Size() || numBuckets < MIN_BUCKETS)
+            return false;
+
+        // Check for being power of two
+        unsigned check = numBuckets;
+        while (!(check & 1))
+            check >>= 1;
+        if (check != 1)
+            return false;
+
+        unsigned char* newData = AllocateData(numBuckets, (unsigned)sizeof(T));
+        if (data_)
+        {
+            unsigned size = Size();
+            T* oldElements = ElementAt(0);
+            T* newElements = reinterpret_cast<T*>(newData + sizeof(Header) + numBuckets * sizeof(FlatHashBucket));
+            for (unsigned i = 0; i < size; ++i)
+            {
+                new(newElements + i) T(oldElements[i]);
+                (oldElements + i)->~T();
+            }
+
+            CopyBuckets(newData);
+            reinterpret_cast<Header*>(newData)->size_ = size;
+            delete[] data_;
+        }
+
+        data_ = newData;
+        return true;
+    }
+
+    /// Reserve buckets so that at least the specified number of keys fit without rehashing.
+    void Reserve(unsigned size)
+    {
+        unsigned numBuckets = data_ ? NumBuckets() : MIN_BUCKETS;
+        while (GetCapacity(numBuckets) < size)
+            numBuckets <<= 1;
+        Rehash(numBuckets);
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        return pos != NOT_FOUND ? Iterator(ElementAt(Buckets()[pos].index_)) : End();
+    }
+
+    /// Return const iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned pos = FindBucket(key, MakeHash(key));
+        return pos != NOT_FOUND ? ConstIterator(ElementAt(Buckets()[pos].index_)) : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindBucket(key, MakeHash(key)) != NOT_FOUND; }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(ElementAt(0)); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(ElementAt(0)); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(ElementAt(Size())); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(ElementAt(Size())); }
+
+    /// Return first key.
+    const T& Front() const { return *Begin(); }
+
+    /// Return last key.
+    const T& Back() const { return *(--End()); }
+
+private:
+    /// Return element by index. Null if not allocated.
+    T* ElementAt(unsigned index) const { return data_ ? reinterpret_cast<T*>(Elements()) + index : 0; }
+
+    /// Return bucket position of a key, or NOT_FOUND.
+    unsigned FindBucket(const T& key, unsigned hashKey) const
+    {
+        if (!data_)
+            return NOT_FOUND;
+
+        const FlatHashBucket* buckets = Buckets();
+        unsigned mask = GetHeader()->mask_;
+        unsigned pos = HomeBucket(hashKey);
+        unsigned distance = 0;
+
+        for (;;)
+        {
+            const FlatHashBucket& bucket = buckets[pos];
+            // An empty bucket, or one closer to its home than the key would be, ends the search
+            if (bucket.index_ == EMPTY_INDEX || ProbeDistance(bucket.hash_, pos) < distance)
+                return NOT_FOUND;
+            if (bucket.hash_ == hashKey && *ElementAt(bucket.index_) == key)
+                return pos;
+
+            pos = (pos + 1) & mask;
+            ++distance;
+        }
+    }
+
+    /// Append a new key, which must not exist yet. Return pointer to it.
+    T* InsertElement(const T& key, unsigned hashKey)
+    {
+        unsigned size = Size();
+        if (!data_ || size >= Capacity())
+        {
+            // Key may refer to an element of this set, which growing would move, so copy it first
+            T keyCopy(key);
+            Rehash(data_ ? NumBuckets() << 1 : MIN_BUCKETS);
+            return ConstructElement(keyCopy, hashKey);
+        }
+
+        return ConstructElement(key, hashKey);
+    }
+
+    /// Construct a key at the end, which must have room.
+    T* ConstructElement(const T& key, unsigned hashKey)
+    {
+        unsigned size = Size();
+        T* element = ElementAt(size);
+        new(element) T(key);
+        InsertBucket(hashKey, size);
+        SetSize(size + 1);
+        return element;
+    }
+
+    /// Erase the key referred to by a bucket position. The last key is moved into its place.
+    void EraseElement(unsigned pos)
+    {
+        unsigned index = Buckets()[pos].index_;
+        unsigned last = Size() - 1;
+        EraseBucket(pos);
+
+        T* element = ElementAt(index);
+        element->~T();
+
+        if (index != last)
+        {
+            T* lastElement = ElementAt(last);
+            unsigned lastPos = FindBucketByIndex(MakeHash(*lastElement), last);
+            new(element) T(*lastElement);
+            lastElement->~T();
+            Buckets()[lastPos].index_ = index;
+        }
+
+        SetSize(last);
+    }
+};
+
+template <class T> void Swap(FlatHashSet<T>& first, FlatHashSet<T>& second)
+{
+    first.Swap(second);
+}
+
+}
+
+namespace std
+{
+
+template <class T> typename Atomic::FlatHashSet<T>::ConstIterator begin(const Atomic::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Atomic::FlatHashSet<T>::ConstIterator end(const Atomic::FlatHashSet<T>& v) { return v.End(); }
+
+template <class T> typename Atomic::FlatHashSet<T>::Iterator begin(Atomic::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Atomic::FlatHashSet<T>::Iterator end(Atomic::FlatHashSet<T>& v) { return v.End(); }
+
+}
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/Ptr.h"
+#include "../Core/InternedString.h"
 #include "../Core/Variant.h"
 
 namespace Atomic
@@ -127,8 +128,8 @@ struct AttributeInfo
 
     /// Attribute type.
     VariantType type_;
-    /// Name.
-    String name_;
+    /// Name. Interned, as the same names are registered for every class and instance default.
+    InternedString name_;
     /// Byte offset from start of object.
     unsigned offset_;
     /// Enum names.
@@ -78,6 +78,16 @@ Context::~Context()
     subsystems_.Clear();
     factories_.Clear();
 
+    // Delete event receiver sets
+    for (FlatHashMap<StringHash, HashSet<Object*>*>::Iterator i = eventReceivers_.Begin(); i != eventReceivers_.End(); ++i)
+        delete i->second_;
+    eventReceivers_.Clear();
+
+    // Delete typed event channels
+    for (FlatHashMap<TypedEventID, TypedEventChannel*>::Iterator i = typedEventChannels_.Begin(); i != typedEventChannels_.End(); ++i)
+        delete i->second_;
+    typedEventChannels_.Clear();
+
     // Delete allocated event data maps
     for (PODVector<VariantMap*>::Iterator i = eventDataMaps_.Begin(); i != eventDataMaps_.End(); ++i)
         delete *i;
@@ -221,7 +231,10 @@ AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
 
 void Context::AddEventReceiver(Object* receiver, StringHash eventType)
 {
-    eventReceivers_[eventType].Insert(receiver);
+    HashSet<Object*>*& group = eventReceivers_[eventType];
+    if (!group)
+        group = new HashSet<Object*>();
+    group->Insert(receiver);
 }
 
 void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash eventType)
@@ -257,4 +270,12 @@ void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash e
         group->Erase(receiver);
 }
 
+TypedEventChannel* Context::GetOrCreateTypedEventChannel(TypedEventID eventID)
+{
+    TypedEventChannel*& channel = typedEventChannels_[eventID];
+    if (!channel)
+        channel = new TypedEventChannel();
+    return channel;
+}
+
 }
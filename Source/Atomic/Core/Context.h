@@ -24,6 +24,7 @@
 
 #include "../Core/Attribute.h"
 #include "../Core/Object.h"
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 #include "../Resource/XMLElement.h"
 
@@ -152,8 +153,15 @@ public:
     /// Return event receivers for an event type, or null if they do not exist.
     HashSet<Object*>* GetEventReceivers(StringHash eventType)
     {
-        HashMap<StringHash, HashSet<Object*> >::Iterator i = eventReceivers_.Find(eventType);
-        return i != eventReceivers_.End() ? &i->second_ : 0;
+        FlatHashMap<StringHash, HashSet<Object*>*>::Iterator i = eventReceivers_.Find(eventType);
+        return i != eventReceivers_.End() ? i->second_ : 0;
+    }
+
+    /// Return receivers of a typed event, or null if it has never been subscribed to.
+    TypedEventChannel* GetTypedEventChannel(TypedEventID eventID) const
+    {
+        FlatHashMap<TypedEventID, TypedEventChannel*>::ConstIterator i = typedEventChannels_.Find(eventID);
+        return i != typedEventChannels_.End() ? i->second_ : 0;
     }
 
     // ATOMIC BEGIN
@@ -177,6 +185,8 @@ private:
     void RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType);
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
+    /// Return receivers of a typed event, creating the channel if necessary.
+    TypedEventChannel* GetOrCreateTypedEventChannel(TypedEventID eventID);
 
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
@@ -203,10 +213,12 @@ private:
     HashMap<StringHash, Vector<AttributeInfo> > attributes_;
     /// Network replication attribute descriptions per object type.
     HashMap<StringHash, Vector<AttributeInfo> > networkAttributes_;
-    /// Event receivers for non-specific events.
-    HashMap<StringHash, HashSet<Object*> > eventReceivers_;
+    /// Event receivers for non-specific events. The receiver sets are allocated separately, so that they stay valid while new event types are subscribed to during sending.
+    FlatHashMap<StringHash, HashSet<Object*>*> eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    /// Typed event receivers. The channels are never removed, as subscribed objects refer to them.
+    FlatHashMap<TypedEventID, TypedEventChannel*> typedEventChannels_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
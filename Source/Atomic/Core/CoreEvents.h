@@ -63,4 +63,40 @@ EVENT(E_ENDFRAME, EndFrame)
 {
 }
 
+/// Typed application-wide logic update event. Sent after E_UPDATE.
+struct UpdateEvent
+{
+    TYPED_EVENT(UpdateEvent);
+
+    /// Timestep.
+    float timeStep_;
+};
+
+/// Typed application-wide logic post-update event. Sent after E_POSTUPDATE.
+struct PostUpdateEvent
+{
+    TYPED_EVENT(PostUpdateEvent);
+
+    /// Timestep.
+    float timeStep_;
+};
+
+/// Typed render update event. Sent after E_RENDERUPDATE.
+struct RenderUpdateEvent
+{
+    TYPED_EVENT(RenderUpdateEvent);
+
+    /// Timestep.
+    float timeStep_;
+};
+
+/// Typed post-render update event. Sent after E_POSTRENDERUPDATE.
+struct PostRenderUpdateEvent
+{
+    TYPED_EVENT(PostRenderUpdateEvent);
+
+    /// Timestep.
+    float timeStep_;
+};
+
 }
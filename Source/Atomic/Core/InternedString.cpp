@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/InternedString.h"
+#include "../Core/Mutex.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Return the intern table. Constructed on first use, so that interned strings may be created during static initialization.
+static HashMap<String, StringHash>& GetInternTable()
+{
+    static HashMap<String, StringHash> table;
+    return table;
+}
+
+/// Return the intern table mutex.
+static Mutex& GetInternMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+InternedString::InternedString(const String& str) :
+    entry_(0)
+{
+    Intern(str);
+}
+
+InternedString::InternedString(const char* str) :
+    entry_(0)
+{
+    Intern(String(str));
+}
+
+unsigned InternedString::GetNumInterned()
+{
+    MutexLock lock(GetInternMutex());
+    return GetInternTable().Size();
+}
+
+void InternedString::Intern(const String& str)
+{
+    if (str.Empty())
+        return;
+
+    MutexLock lock(GetInternMutex());
+
+    // Table nodes are never moved or freed, so the entry pointer stays valid
+    HashMap<String, StringHash>& table = GetInternTable();
+    HashMap<String, StringHash>::Iterator i = table.Find(str);
+    if (i == table.End())
+        i = table.Insert(MakePair(str, StringHash(str)));
+
+    entry_ = &(*i);
+}
+
+}
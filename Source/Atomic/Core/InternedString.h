@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Math/StringHash.h"
+
+namespace Atomic
+{
+
+/// Immutable string stored once in a global table. Copies share the same storage, compare by pointer and carry the StringHash calculated when the string was first interned. Interning is thread-safe. The table lives until the program exits and interned strings are never freed, so only intern names from a bounded set, such as resource and attribute names, not arbitrary runtime strings.
+class ATOMIC_API InternedString
+{
+public:
+    /// Construct empty.
+    InternedString() :
+        entry_(0)
+    {
+    }
+
+    /// Copy-construct from another interned string.
+    InternedString(const InternedString& rhs) :
+        entry_(rhs.entry_)
+    {
+    }
+
+    /// Construct from a string, interning it if necessary.
+    InternedString(const String& str);
+    /// Construct from a C string, interning it if necessary.
+    InternedString(const char* str);
+
+    /// Assign from another interned string.
+    InternedString& operator =(const InternedString& rhs)
+    {
+        entry_ = rhs.entry_;
+        return *this;
+    }
+
+    /// Test for equality with another interned string.
+    bool operator ==(const InternedString& rhs) const { return entry_ == rhs.entry_; }
+
+    /// Test for inequality with another interned string.
+    bool operator !=(const InternedString& rhs) const { return entry_ != rhs.entry_; }
+
+    /// Test for equality with a string. The string is not interned.
+    bool operator ==(const String& rhs) const { return GetString() == rhs; }
+
+    /// Test for inequality with a string. The string is not interned.
+    bool operator !=(const String& rhs) const { return GetString() != rhs; }
+
+    /// Test for equality with a C string. The string is not interned.
+    bool operator ==(const char* rhs) const { return GetString() == rhs; }
+
+    /// Test for inequality with a C string. The string is not interned.
+    bool operator !=(const char* rhs) const { return GetString() != rhs; }
+
+    /// Test if string is less than another interned string.
+    bool operator <(const InternedString& rhs) const { return GetString() < rhs.GetString(); }
+
+    /// Return the string.
+    const String& GetString() const { return entry_ ? entry_->first_ : String::EMPTY; }
+
+    /// Return the string, so that an interned string can be used where a string is expected.
+    operator const String&() const { return GetString(); }
+
+    /// Return the C string.
+    const char* CString() const { return GetString().CString(); }
+
+    /// Return the case-insensitive string hash.
+    StringHash GetHash() const { return entry_ ? entry_->second_ : StringHash::ZERO; }
+
+    /// Return whether is empty.
+    bool Empty() const { return entry_ == 0; }
+
+    /// Return comparison result with a string, the same as String::Compare().
+    int Compare(const String& str, bool caseSensitive = true) const { return GetString().Compare(str, caseSensitive); }
+
+    /// Return hash value for HashSet & HashMap.
+    unsigned ToHash() const { return GetHash().Value(); }
+
+    /// Return number of strings in the intern table.
+    static unsigned GetNumInterned();
+
+private:
+    /// Find or add the string in the intern table.
+    void Intern(const String& str);
+
+    /// Intern table entry, null if empty.
+    const HashMap<String, StringHash>::KeyValue* entry_;
+};
+
+}
@@ -175,6 +175,10 @@ void Object::UnsubscribeFromEvents(Object* sender)
 
 void Object::UnsubscribeFromAllEvents()
 {
+    for (PODVector<TypedEventChannel*>::Iterator i = typedEventChannels_.Begin(); i != typedEventChannels_.End(); ++i)
+        (*i)->RemoveReceiver(this);
+    typedEventChannels_.Clear();
+
     for (;;)
     {
         EventHandler* handler = eventHandlers_.First();
@@ -333,6 +337,43 @@ VariantMap& Object::GetEventDataMap() const
     return context_->GetEventDataMap();
 }
 
+void Object::SubscribeToTypedEvent(TypedEventID eventID, TypedEventFunction function)
+{
+    if (!function)
+        return;
+
+    TypedEventChannel* channel = context_->GetOrCreateTypedEventChannel(eventID);
+    if (!channel->HasReceiver(this))
+        typedEventChannels_.Push(channel);
+    channel->AddReceiver(this, function);
+}
+
+void Object::UnsubscribeFromTypedEvent(TypedEventID eventID)
+{
+    TypedEventChannel* channel = context_->GetTypedEventChannel(eventID);
+    if (channel && channel->RemoveReceiver(this))
+        typedEventChannels_.Remove(channel);
+}
+
+void Object::SendTypedEvent(TypedEventID eventID, void* event)
+{
+    if (!Thread::IsMainThread())
+    {
+        LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+
+    TypedEventChannel* channel = context_->GetTypedEventChannel(eventID);
+    if (!channel || !channel->GetNumReceivers())
+        return;
+
+    // Make a copy of the context pointer in case the object is destroyed during event handling
+    Context* context = context_;
+    context->eventSenders_.Push(this);
+    channel->Send(event);
+    context->eventSenders_.Pop();
+}
+
 Object* Object::GetSubsystem(StringHash type) const
 {
     return context_->GetSubsystem(type);
@@ -361,6 +402,22 @@ bool Object::HasSubscribedToEvent(Object* sender, StringHash eventType) const
         return FindSpecificEventHandler(sender, eventType) != 0;
 }
 
+bool Object::HasEventReceivers(StringHash eventType) const
+{
+    const HashSet<Object*>* group = context_->GetEventReceivers(const_cast<Object*>(this), eventType);
+    if (group && !group->Empty())
+        return true;
+
+    group = context_->GetEventReceivers(eventType);
+    return group && !group->Empty();
+}
+
+bool Object::HasSubscribedToTypedEvent(TypedEventID eventID) const
+{
+    TypedEventChannel* channel = context_->GetTypedEventChannel(eventID);
+    return channel && channel->HasReceiver(const_cast<Object*>(this));
+}
+
 const String& Object::GetCategory() const
 {
     const HashMap<String, Vector<StringHash> >& objectCategories = context_->GetObjectCategories();
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/LinkedList.h"
+#include "../Core/TypedEvent.h"
 #include "../Core/Variant.h"
 #include "../Resource/XMLElement.h"
 
@@ -89,6 +90,18 @@ public:
     void SendEvent(StringHash eventType, VariantMap& eventData);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
+    /// Subscribe to a typed event by event struct identifier and handler function. Replaces an earlier subscription to the same event.
+    void SubscribeToTypedEvent(TypedEventID eventID, TypedEventFunction function);
+    /// Unsubscribe from a typed event.
+    void UnsubscribeFromTypedEvent(TypedEventID eventID);
+    /// Send a typed event to all subscribers. The event struct is passed by pointer without copying or boxing.
+    void SendTypedEvent(TypedEventID eventID, void* event);
+    /// Template version of subscribing to a typed event. The handler is a member function taking the event struct by reference.
+    template <class E, class T, void (T::*F)(E&)> void SubscribeToTypedEvent();
+    /// Template version of unsubscribing from a typed event.
+    template <class E> void UnsubscribeFromTypedEvent() { UnsubscribeFromTypedEvent(GetTypedEventID<E>()); }
+    /// Template version of sending a typed event.
+    template <class E> void SendTypedEvent(E& event) { SendTypedEvent(GetTypedEventID<E>(), &event); }
 
     /// Return execution context.
     Context* GetContext() const { return context_; }
@@ -103,9 +116,15 @@ public:
     bool HasSubscribedToEvent(StringHash eventType) const;
     /// Return whether has subscribed to a specific sender's event.
     bool HasSubscribedToEvent(Object* sender, StringHash eventType) const;
+    /// Return whether has subscribed to a typed event.
+    bool HasSubscribedToTypedEvent(TypedEventID eventID) const;
+    /// Template version of returning whether has subscribed to a typed event.
+    template <class E> bool HasSubscribedToTypedEvent() const { return HasSubscribedToTypedEvent(GetTypedEventID<E>()); }
 
+    /// Return whether any object has subscribed to an event sent by this object, either specifically or without a sender. Use to skip building event data nobody receives.
+    bool HasEventReceivers(StringHash eventType) const;
     /// Return whether has subscribed to any event.
-    bool HasEventHandlers() const { return !eventHandlers_.Empty(); }
+    bool HasEventHandlers() const { return !eventHandlers_.Empty() || !typedEventChannels_.Empty(); }
 
     /// Template version of returning a subsystem.
     template <class T> T* GetSubsystem() const;
@@ -132,10 +151,17 @@ private:
 
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
+    /// Typed event channels subscribed to.
+    PODVector<TypedEventChannel*> typedEventChannels_;
 };
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
 
+template <class E, class T, void (T::*F)(E&)> void Object::SubscribeToTypedEvent()
+{
+    SubscribeToTypedEvent(GetTypedEventID<E>(), &InvokeTypedEventHandler<T, E, F>);
+}
+
 /// Base class for object factories.
 class ATOMIC_API ObjectFactory : public RefCounted
 {
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Semaphore.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+namespace Atomic
+{
+
+#ifdef WIN32
+
+Semaphore::Semaphore(unsigned count) :
+    handle_(0)
+{
+    handle_ = CreateSemaphore(0, (LONG)count, 0x7fffffff, 0);
+}
+
+Semaphore::~Semaphore()
+{
+    CloseHandle((HANDLE)handle_);
+    handle_ = 0;
+}
+
+void Semaphore::Release(unsigned count)
+{
+    if (count)
+        ReleaseSemaphore((HANDLE)handle_, (LONG)count, 0);
+}
+
+void Semaphore::Acquire()
+{
+    WaitForSingleObject((HANDLE)handle_, INFINITE);
+}
+
+bool Semaphore::Acquire(unsigned mSec)
+{
+    return WaitForSingleObject((HANDLE)handle_, mSec) == WAIT_OBJECT_0;
+}
+
+bool Semaphore::TryAcquire()
+{
+    return WaitForSingleObject((HANDLE)handle_, 0) == WAIT_OBJECT_0;
+}
+
+#else
+
+Semaphore::Semaphore(unsigned count) :
+    mutex_(new pthread_mutex_t),
+    event_(new pthread_cond_t),
+    count_(count)
+{
+    pthread_mutex_init((pthread_mutex_t*)mutex_, 0);
+    pthread_cond_init((pthread_cond_t*)event_, 0);
+}
+
+Semaphore::~Semaphore()
+{
+    pthread_cond_t* cond = (pthread_cond_t*)event_;
+    pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
+
+    pthread_cond_destroy(cond);
+    pthread_mutex_destroy(mutex);
+    delete cond;
+    delete mutex;
+    event_ = 0;
+    mutex_ = 0;
+}
+
+void Semaphore::Release(unsigned count)
+{
+    pthread_cond_t* cond = (pthread_cond_t*)event_;
+    pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
+
+    pthread_mutex_lock(mutex);
+    count_ += count;
+    if (count == 1)
+        pthread_cond_signal(cond);
+    else if (count)
+        pthread_cond_broadcast(cond);
+    pthread_mutex_unlock(mutex);
+}
+
+void Semaphore::Acquire()
+{
+    pthread_cond_t* cond = (pthread_cond_t*)event_;
+    pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
+
+    pthread_mutex_lock(mutex);
+    // Loop to handle spurious wakeups
+    while (!count_)
+        pthread_cond_wait(cond, mutex);
+    --count_;
+    pthread_mutex_unlock(mutex);
+}
+
+bool Semaphore::Acquire(unsigned mSec)
+{
+    pthread_cond_t* cond = (pthread_cond_t*)event_;
+    pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
+
+    // Timed waits use an absolute deadline
+    timeval now;
+    gettimeofday(&now, 0);
+    long long nSec = (long long)now.tv_usec * 1000 + (long long)(mSec % 1000) * 1000000;
+    timespec deadline;
+    deadline.tv_sec = now.tv_sec + mSec / 1000 + (time_t)(nSec / 1000000000);
+    deadline.tv_nsec = (long)(nSec % 1000000000);
+
+    pthread_mutex_lock(mutex);
+    // Loop to handle spurious wakeups
+    while (!count_)
+    {
+        if (pthread_cond_timedwait(cond, mutex, &deadline))
+            break;
+    }
+    bool acquired = count_ != 0;
+    if (acquired)
+        --count_;
+    pthread_mutex_unlock(mutex);
+    return acquired;
+}
+
+bool Semaphore::TryAcquire()
+{
+    pthread_mutex_t* mutex = (pthread_mutex_t*)mutex_;
+
+    pthread_mutex_lock(mutex);
+    bool acquired = count_ != 0;
+    if (acquired)
+        --count_;
+    pthread_mutex_unlock(mutex);
+    return acquired;
+}
+
+#endif
+
+}
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Atomic
+{
+
+/// Counting semaphore. Unlike a %Condition, releases are never lost when no thread is waiting yet.
+class ATOMIC_API Semaphore
+{
+public:
+    /// Construct with initial count.
+    Semaphore(unsigned count = 0);
+    /// Destruct.
+    ~Semaphore();
+
+    /// Increment the count, waking up as many waiting threads.
+    void Release(unsigned count = 1);
+    /// Wait until the count is nonzero, then decrement it.
+    void Acquire();
+    /// Wait at most the given time in milliseconds for the count to become nonzero, then decrement it. Return true if decremented.
+    bool Acquire(unsigned mSec);
+    /// Decrement the count if nonzero without waiting. Return true if decremented.
+    bool TryAcquire();
+
+private:
+#ifndef WIN32
+    /// Mutex for the count, necessary for pthreads-based implementation.
+    void* mutex_;
+    /// Condition signaled when the count is incremented.
+    void* event_;
+    /// Count.
+    unsigned count_;
+#else
+    /// Operating system specific semaphore.
+    void* handle_;
+#endif
+};
+
+}
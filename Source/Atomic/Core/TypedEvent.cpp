@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Object.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+TypedEventChannel::TypedEventChannel() :
+    sendDepth_(0),
+    dirty_(false)
+{
+}
+
+void TypedEventChannel::AddReceiver(Object* receiver, TypedEventFunction function)
+{
+    FlatHashMap<Object*, unsigned>::Iterator i = indices_.Find(receiver);
+    if (i != indices_.End())
+    {
+        receivers_[i->second_].function_ = function;
+        return;
+    }
+
+    Receiver entry;
+    entry.receiver_ = receiver;
+    entry.function_ = function;
+    indices_.Insert(MakePair(receiver, receivers_.Size()));
+    receivers_.Push(entry);
+}
+
+bool TypedEventChannel::RemoveReceiver(Object* receiver)
+{
+    FlatHashMap<Object*, unsigned>::Iterator i = indices_.Find(receiver);
+    if (i == indices_.End())
+        return false;
+
+    unsigned index = i->second_;
+    indices_.Erase(i);
+
+    if (sendDepth_)
+    {
+        // Can not move receivers while they are being iterated
+        receivers_[index].receiver_ = 0;
+        dirty_ = true;
+    }
+    else
+    {
+        // Move the last receiver into the freed slot
+        unsigned last = receivers_.Size() - 1;
+        if (index != last)
+        {
+            receivers_[index] = receivers_[last];
+            indices_[receivers_[index].receiver_] = index;
+        }
+        receivers_.Pop();
+    }
+
+    return true;
+}
+
+void TypedEventChannel::Send(void* event)
+{
+    ++sendDepth_;
+
+    // Index on each iteration, as the storage may be reallocated by receivers subscribing during sending
+    unsigned numReceivers = receivers_.Size();
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        Object* receiver = receivers_[i].receiver_;
+        if (receiver)
+            receivers_[i].function_(receiver, event);
+    }
+
+    if (!--sendDepth_ && dirty_)
+        Compact();
+}
+
+void TypedEventChannel::Compact()
+{
+    unsigned dest = 0;
+    for (unsigned i = 0; i < receivers_.Size(); ++i)
+    {
+        if (!receivers_[i].receiver_)
+            continue;
+        if (dest != i)
+        {
+            receivers_[dest] = receivers_[i];
+            indices_[receivers_[dest].receiver_] = dest;
+        }
+        ++dest;
+    }
+
+    receivers_.Resize(dest);
+    dirty_ = false;
+}
+
+}
@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashMap.h"
+#include "../Container/RefCounted.h"
+#include "../Math/StringHash.h"
+
+namespace Atomic
+{
+
+class Object;
+
+/// Typed event identifier. Hash of the event struct name, so that it is the same in every shared library.
+typedef StringHash TypedEventID;
+/// Typed event handler function. Receives the receiver object and a pointer to the event struct.
+typedef void (*TypedEventFunction)(Object* receiver, void* event);
+
+/// Return the identifier of a typed event struct. The struct must declare it with TYPED_EVENT.
+template <class T> TypedEventID GetTypedEventID() { return T::GetTypedEventIDStatic(); }
+
+/// Invoke a receiver's member function for a typed event. Used as the stored handler function so that no handler objects need to be allocated.
+template <class T, class E, void (T::*F)(E&)> void InvokeTypedEventHandler(Object* receiver, void* event)
+{
+    (static_cast<T*>(receiver)->*F)(*static_cast<E*>(event));
+}
+
+/// Receivers of one typed event, stored in a dense array. Owned by the Context.
+class ATOMIC_API TypedEventChannel
+{
+public:
+    /// Construct.
+    TypedEventChannel();
+
+    /// Add a receiver or replace its handler function.
+    void AddReceiver(Object* receiver, TypedEventFunction function);
+    /// Remove a receiver. During sending the slot is only cleared, and compacted when the send finishes.
+    bool RemoveReceiver(Object* receiver);
+    /// Send the event to all receivers. Receivers added during sending will not receive the event being sent.
+    void Send(void* event);
+
+    /// Return whether a receiver is subscribed.
+    bool HasReceiver(Object* receiver) const { return indices_.Contains(receiver); }
+    /// Return number of receivers.
+    unsigned GetNumReceivers() const { return indices_.Size(); }
+
+private:
+    /// Remove cleared slots after sending.
+    void Compact();
+
+    /// Receiver and handler function.
+    struct Receiver
+    {
+        /// Receiver object. Null when removed during sending.
+        Object* receiver_;
+        /// Handler function.
+        TypedEventFunction function_;
+    };
+
+    /// Receivers in dense storage.
+    PODVector<Receiver> receivers_;
+    /// Receiver indices into the dense storage.
+    FlatHashMap<Object*, unsigned> indices_;
+    /// Send nesting depth.
+    unsigned sendDepth_;
+    /// Whether slots have been cleared during sending.
+    bool dirty_;
+};
+
+/// Declare the identifier of a typed event struct from its name. Should be used inside the struct.
+#define TYPED_EVENT(eventName) \
+    static Atomic::TypedEventID GetTypedEventIDStatic() { static const Atomic::TypedEventID typedEventID(#eventName); return typedEventID; }
+
+}
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashMap.h"
 #include "../Container/Ptr.h"
 #include "../Math/Color.h"
@@ -105,8 +106,8 @@ typedef Vector<Variant> VariantVector;
 /// Vector of strings.
 typedef Vector<String> StringVector;
 
-/// Map of variants.
-typedef HashMap<StringHash, Variant> VariantMap;
+/// Map of variants. Uses open addressing, as event data and attribute maps are small and looked up often.
+typedef FlatHashMap<StringHash, Variant> VariantMap;
 
 /// Typed resource reference.
 struct ATOMIC_API ResourceRef
@@ -22,12 +22,17 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 #include "../Database/Database.h"
+#include "../Database/DatabaseEvents.h"
 
 namespace Urho3D
 {
 
+/// Maximum number of connection threads per connection string for asynchronous queries.
+static const unsigned MAX_QUERY_THREADS = 4;
+
 Database::Database(Context* context_) :
     Object(context_),
 #ifdef ODBC_3_OR_LATER
@@ -36,6 +41,14 @@ Database::Database(Context* context_) :
     poolSize_(M_MAX_UNSIGNED)
 #endif
 {
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(Database, HandleBeginFrame));
+}
+
+Database::~Database()
+{
+    // Stop the connection threads before the pending queries are released
+    queryQueues_.Clear();
+    queries_.Clear();
 }
 
 DBAPI Database::GetAPI()
@@ -96,4 +109,54 @@ void Database::Disconnect(DbConnection* connection)
     }
 }
 
+SharedPtr<DbQuery> Database::ExecuteAsync(const String& connectionString, const String& sql, const VariantVector& parameters)
+{
+    SharedPtr<DbQueryQueue>& queue = queryQueues_[connectionString];
+    if (!queue)
+    {
+        // Without pooling each connection thread still needs one connection
+        unsigned maxThreads = poolSize_ < MAX_QUERY_THREADS ? poolSize_ : MAX_QUERY_THREADS;
+        queue = new DbQueryQueue(this, connectionString, maxThreads ? maxThreads : 1);
+    }
+
+    SharedPtr<DbQuery> query(new DbQuery(connectionString, sql, parameters));
+    queries_.Push(query);
+    queue->Push(query);
+    return query;
+}
+
+void Database::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    if (queries_.Empty())
+        return;
+
+    PROFILE(DeliverDatabaseQueries);
+
+    for (HashMap<String, SharedPtr<DbQueryQueue> >::Iterator i = queryQueues_.Begin(); i != queryQueues_.End(); ++i)
+        i->second_->TakeCompleted(completedQueries_);
+
+    for (unsigned i = 0; i < completedQueries_.Size(); ++i)
+    {
+        // Keep the query alive for the event handlers
+        SharedPtr<DbQuery> query(completedQueries_[i]);
+        queries_.Remove(query);
+
+        query->latency_ = query->timer_.GetUSec(false);
+        query->completed_ = true;
+
+        using namespace DbQueryComplete;
+
+        VariantMap& completeData = GetEventDataMap();
+        completeData[P_QUERY] = query.Get();
+        completeData[P_SQL] = query->GetSQL();
+        completeData[P_SUCCESS] = query->IsSuccessful();
+        completeData[P_QUEUETIME] = query->GetQueueTime();
+        completeData[P_EXECUTIONTIME] = query->GetExecutionTime();
+        completeData[P_LATENCY] = query->GetLatency();
+        SendEvent(E_DBQUERYCOMPLETE, completeData);
+    }
+
+    completedQueries_.Clear();
+}
+
 }
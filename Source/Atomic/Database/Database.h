@@ -24,6 +24,7 @@
 
 #include "../Core/Object.h"
 #include "../Database/DbConnection.h"
+#include "../Database/DbQuery.h"
 
 namespace Urho3D
 {
@@ -45,6 +46,8 @@ class URHO3D_API Database : public Object
 public:
     /// Construct.
     Database(Context* context_);
+    /// Destruct. Stop the connection threads of asynchronous queries.
+    ~Database();
     /// Return the underlying database API.
     static DBAPI GetAPI();
 
@@ -52,6 +55,8 @@ public:
     DbConnection* Connect(const String& connectionString);
     /// Disconnect a database connection. The connection object pointer should not be used anymore after this.
     void Disconnect(DbConnection* connection);
+    /// Queue an SQL statement with ? placeholders for execution on a connection thread. The threads take their connections from the connection pool, up to the pool size. Send E_DBQUERYCOMPLETE event on the main thread once executed. Return the query to poll for its result.
+    SharedPtr<DbQuery> ExecuteAsync(const String& connectionString, const String& sql, const VariantVector& parameters = Variant::emptyVariantVector);
 
     /// Return true when using internal database connection pool. The internal database pool is managed by the Database subsystem itself and should not be confused with ODBC connection pool option when ODBC is being used.
     bool IsPooling() const { return (bool)poolSize_; }
@@ -59,16 +64,28 @@ public:
     /// Get internal database connection pool size.
     unsigned GetPoolSize() const { return poolSize_; }
 
+    /// Return number of asynchronous queries not yet delivered.
+    unsigned GetNumPendingQueries() const { return queries_.Size(); }
+
     /// Set internal database connection pool size.
     void SetPoolSize(unsigned poolSize) { poolSize_ = poolSize; }
 
 private:
+    /// Handle begin frame event. Deliver the executed asynchronous queries.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+
     /// %Database connection pool size. Default to 0 when using ODBC 3.0 or later as ODBC 3.0 driver manager could manage its own database connection pool.
     unsigned poolSize_;
     /// Active database connections.
     Vector<SharedPtr<DbConnection> > connections_;
     ///%Database connections pool.
     HashMap<String, Vector<SharedPtr<DbConnection> > > connectionsPool_;
+    /// Asynchronous query queues by connection string.
+    HashMap<String, SharedPtr<DbQueryQueue> > queryQueues_;
+    /// Asynchronous queries not yet delivered.
+    Vector<SharedPtr<DbQuery> > queries_;
+    /// Executed queries being delivered.
+    PODVector<DbQuery*> completedQueries_;
 };
 
 }
@@ -41,4 +41,15 @@ EVENT(E_DBCURSOR, DbCursor)
     PARAM(P_ABORT, Abort);                  // bool [in]
 }
 
+/// Asynchronous database query executed. The resultset can be read from the query object.
+EVENT(E_DBQUERYCOMPLETE, DbQueryComplete)
+{
+    PARAM(P_QUERY, Query);                  // DbQuery pointer
+    PARAM(P_SQL, SQL);                      // String
+    PARAM(P_SUCCESS, Success);              // bool
+    PARAM(P_QUEUETIME, QueueTime);          // float, milliseconds waited for a connection thread
+    PARAM(P_EXECUTIONTIME, ExecutionTime);  // float, milliseconds spent executing
+    PARAM(P_LATENCY, Latency);              // float, milliseconds from queuing until delivery
+}
+
 }
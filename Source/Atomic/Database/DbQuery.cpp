@@ -0,0 +1,193 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Database/Database.h"
+#include "../Database/DbQuery.h"
+
+namespace Urho3D
+{
+
+DbQuery::DbQuery(const String& connectionString, const String& sql, const VariantVector& parameters) :
+    connectionString_(connectionString),
+    sql_(sql),
+    parameters_(parameters),
+    numAffectedRows_(-1),
+    queueTime_(0),
+    executionTime_(0),
+    latency_(0),
+    successful_(false),
+    completed_(false)
+{
+}
+
+DbQueryQueue::DbQueryQueue(Database* owner, const String& connectionString, unsigned maxThreads) :
+    owner_(owner),
+    connectionString_(connectionString),
+    maxThreads_(maxThreads),
+    numIdleThreads_(0),
+    shouldRun_(true)
+{
+}
+
+DbQueryQueue::~DbQueryQueue()
+{
+    {
+        MutexLock lock(queueMutex_);
+        shouldRun_ = false;
+    }
+
+    // Wake up every connection thread, each exits on its first wakeup
+    queryAvailable_.Release(threads_.Size());
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        threads_[i]->Stop();
+        owner_->Disconnect(threads_[i]->GetConnection());
+    }
+    threads_.Clear();
+}
+
+void DbQueryQueue::Push(DbQuery* query)
+{
+    bool startThread;
+    {
+        MutexLock lock(queueMutex_);
+        pending_.Push(query);
+        startThread = pending_.Size() > numIdleThreads_ && threads_.Size() < maxThreads_;
+    }
+
+    if (startThread)
+    {
+        // Connections are taken from the pool on the main thread, as the pool is not thread-safe
+        DbConnection* connection = owner_->Connect(connectionString_);
+        if (connection)
+        {
+            SharedPtr<DbQueryThread> thread(new DbQueryThread(this, connection));
+            {
+                MutexLock lock(queueMutex_);
+                ++numIdleThreads_;
+            }
+            threads_.Push(thread);
+            thread->Run();
+        }
+        else if (threads_.Empty())
+        {
+            // Nothing could execute the pending queries, fail them all
+            MutexLock lock(queueMutex_);
+            for (List<DbQuery*>::Iterator i = pending_.Begin(); i != pending_.End(); ++i)
+                completed_.Push(*i);
+            pending_.Clear();
+        }
+    }
+
+    queryAvailable_.Release();
+}
+
+DbQuery* DbQueryQueue::Pop()
+{
+    for (;;)
+    {
+        queryAvailable_.Acquire();
+
+        MutexLock lock(queueMutex_);
+        if (!shouldRun_)
+            return 0;
+
+        // The queue may have been emptied by failing its queries while no thread could connect
+        if (!pending_.Empty())
+        {
+            DbQuery* query = pending_.Front();
+            pending_.PopFront();
+            --numIdleThreads_;
+            return query;
+        }
+    }
+}
+
+void DbQueryQueue::Complete(DbQuery* query)
+{
+    MutexLock lock(queueMutex_);
+    completed_.Push(query);
+    ++numIdleThreads_;
+}
+
+void DbQueryQueue::TakeCompleted(PODVector<DbQuery*>& dest)
+{
+    MutexLock lock(queueMutex_);
+    dest.Push(completed_);
+    completed_.Clear();
+}
+
+DbQueryThread::DbQueryThread(DbQueryQueue* queue, DbConnection* connection) :
+    queue_(queue),
+    connection_(connection)
+{
+}
+
+void DbQueryThread::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        DbQuery* query = queue_->Pop();
+        if (!query)
+            break;
+
+        ExecuteQuery(query);
+        queue_->Complete(query);
+    }
+}
+
+void DbQueryThread::ExecuteQuery(DbQuery* query)
+{
+    query->queueTime_ = query->timer_.GetUSec(false);
+
+    // The prepared statements are cached by the connection, so repeated queries skip the SQL parsing
+    SharedPtr<DbStatement> statement = connection_->Prepare(query->sql_);
+    if (statement && statement->Bind(query->parameters_))
+    {
+        while (statement->Next())
+        {
+            unsigned numCols = statement->GetNumColumns();
+            VariantVector colValues(numCols);
+            for (unsigned i = 0; i < numCols; ++i)
+                colValues[i] = statement->GetValue(i);
+            query->rows_.Push(colValues);
+        }
+
+        query->successful_ = !statement->HasError();
+        if (query->successful_)
+        {
+            unsigned numCols = statement->GetNumColumns();
+            query->columns_.Resize(numCols);
+            for (unsigned i = 0; i < numCols; ++i)
+                query->columns_[i] = statement->GetColumnName(i);
+            query->numAffectedRows_ = statement->GetNumAffectedRows();
+        }
+
+        statement->Reset();
+    }
+
+    query->executionTime_ = query->timer_.GetUSec(false) - query->queueTime_;
+}
+
+}
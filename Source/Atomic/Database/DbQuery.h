@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/List.h"
+#include "../Container/RefCounted.h"
+#include "../Core/Mutex.h"
+#include "../Core/Semaphore.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
+#include "../Core/Variant.h"
+
+namespace Urho3D
+{
+
+class Database;
+class DbConnection;
+class DbQueryThread;
+
+/// Asynchronous database query. Executed on a connection thread of the %Database subsystem, the result is available once the E_DBQUERYCOMPLETE event has been sent.
+class URHO3D_API DbQuery : public RefCounted
+{
+    REFCOUNTED(DbQuery)
+
+    friend class Database;
+    friend class DbQueryQueue;
+    friend class DbQueryThread;
+
+public:
+    /// Construct. Use Database::ExecuteAsync() to create queries.
+    DbQuery(const String& connectionString, const String& sql, const VariantVector& parameters);
+
+    /// Return connection string.
+    const String& GetConnectionString() const { return connectionString_; }
+    /// Return the SQL statement.
+    const String& GetSQL() const { return sql_; }
+    /// Return the bound parameter values.
+    const VariantVector& GetParameters() const { return parameters_; }
+    /// Return whether the completion has been delivered.
+    bool IsCompleted() const { return completed_; }
+    /// Return whether the query executed successfully.
+    bool IsSuccessful() const { return successful_; }
+    /// Return column headers of the resultset.
+    const StringVector& GetColumns() const { return columns_; }
+    /// Return rows of the resultset.
+    const Vector<VariantVector>& GetRows() const { return rows_; }
+    /// Return number of affected rows by the DML statement or -1 if the number of affected rows is not available.
+    long GetNumAffectedRows() const { return numAffectedRows_; }
+    /// Return time in milliseconds the query waited for a connection thread.
+    float GetQueueTime() const { return queueTime_ / 1000.0f; }
+    /// Return time in milliseconds spent executing the query and fetching the resultset.
+    float GetExecutionTime() const { return executionTime_ / 1000.0f; }
+    /// Return time in milliseconds from queuing the query until its completion was delivered.
+    float GetLatency() const { return latency_ / 1000.0f; }
+
+private:
+    /// Connection string.
+    String connectionString_;
+    /// SQL statement.
+    String sql_;
+    /// Bound parameter values.
+    VariantVector parameters_;
+    /// Column headers of the resultset.
+    StringVector columns_;
+    /// Rows of the resultset.
+    Vector<VariantVector> rows_;
+    /// Number of affected rows by the DML statement.
+    long numAffectedRows_;
+    /// Timer started when queued.
+    HiresTimer timer_;
+    /// Queue time in microseconds.
+    long long queueTime_;
+    /// Execution time in microseconds.
+    long long executionTime_;
+    /// Total latency in microseconds.
+    long long latency_;
+    /// Successful flag.
+    bool successful_;
+    /// Completed flag.
+    bool completed_;
+};
+
+/// Queue of asynchronous queries for one connection string, shared by the connection threads executing them. Owned by the %Database subsystem.
+class DbQueryQueue : public RefCounted
+{
+    REFCOUNTED(DbQueryQueue)
+
+public:
+    /// Construct.
+    DbQueryQueue(Database* owner, const String& connectionString, unsigned maxThreads);
+    /// Destruct. Stop the connection threads and return their connections to the pool. Queries still pending are abandoned.
+    ~DbQueryQueue();
+
+    /// Queue a query, starting another connection thread if all are busy. Called from the main thread.
+    void Push(DbQuery* query);
+    /// Wait for and take the next query. Return null when the queue is shutting down. Called from the connection threads.
+    DbQuery* Pop();
+    /// Mark a query as executed. Called from the connection threads.
+    void Complete(DbQuery* query);
+    /// Move the executed queries to the destination vector. Called from the main thread.
+    void TakeCompleted(PODVector<DbQuery*>& dest);
+
+    /// Return number of connection threads.
+    unsigned GetNumThreads() const { return threads_.Size(); }
+
+private:
+    /// %Database subsystem.
+    Database* owner_;
+    /// Connection string.
+    String connectionString_;
+    /// Maximum number of connection threads.
+    unsigned maxThreads_;
+    /// Connection threads.
+    Vector<SharedPtr<DbQueryThread> > threads_;
+    /// Mutex for the pending and completed queries.
+    Mutex queueMutex_;
+    /// Counts the queued queries, plus one wakeup per connection thread when shutting down.
+    Semaphore queryAvailable_;
+    /// Queries waiting for a connection thread. The queries are kept alive by the %Database subsystem.
+    List<DbQuery*> pending_;
+    /// Executed queries waiting to be delivered.
+    PODVector<DbQuery*> completed_;
+    /// Number of connection threads waiting for a query.
+    unsigned numIdleThreads_;
+    /// Running flag.
+    bool shouldRun_;
+};
+
+/// Connection thread executing asynchronous queries with its own database connection.
+class DbQueryThread : public RefCounted, public Thread
+{
+    REFCOUNTED(DbQueryThread)
+
+public:
+    /// Construct with the queue and a connection taken from the pool.
+    DbQueryThread(DbQueryQueue* queue, DbConnection* connection);
+
+    /// Query execution loop.
+    virtual void ThreadFunction();
+
+    /// Return the database connection.
+    DbConnection* GetConnection() const { return connection_; }
+
+private:
+    /// Execute a query and store its resultset.
+    void ExecuteQuery(DbQuery* query);
+
+    /// Query queue.
+    DbQueryQueue* queue_;
+    /// %Database connection used exclusively by this thread.
+    DbConnection* connection_;
+};
+
+}
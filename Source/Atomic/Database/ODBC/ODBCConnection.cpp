@@ -25,14 +25,16 @@
 #include "../../Database/DatabaseEvents.h"
 #include "../../IO/Log.h"
 
-#include <sqlext.h>
-
 namespace Urho3D
 {
 
+static const unsigned DEFAULT_STATEMENT_CACHE_SIZE = 64;
+
 DbConnection::DbConnection(Context* context, const String& connectionString) :
     Object(context),
-    connectionString_(connectionString)
+    connectionString_(connectionString),
+    transactionImpl_(0),
+    statementCacheSize_(DEFAULT_STATEMENT_CACHE_SIZE)
 {
     try
     {
@@ -61,7 +63,136 @@ DbConnection::~DbConnection()
 
 void DbConnection::Finalize()
 {
-    // TODO
+    // Uncommitted changes are rolled back when the transaction object is destroyed
+    delete transactionImpl_;
+    transactionImpl_ = 0;
+
+    // Statements still referenced elsewhere become unusable
+    for (HashMap<String, SharedPtr<DbStatement> >::Iterator i = statements_.Begin(); i != statements_.End(); ++i)
+        i->second_->Finalize();
+    statements_.Clear();
+}
+
+SharedPtr<DbStatement> DbConnection::Prepare(const String& sql)
+{
+    HashMap<String, SharedPtr<DbStatement> >::Iterator i = statements_.Find(sql);
+    bool cachedInUse = false;
+    if (i != statements_.End())
+    {
+        // Only hand out the cached statement when no one else is stepping through it
+        if (i->second_->Refs() == 1)
+        {
+            i->second_->Reset();
+            i->second_->ClearBindings();
+            return i->second_;
+        }
+        cachedInUse = true;
+    }
+
+    SharedPtr<DbStatement> statement;
+    try
+    {
+        statement = new DbStatement(nanodbc::statement(connectionImpl_, sql.Trimmed().CString()), sql);
+    }
+    catch (std::runtime_error& e)
+    {
+        HandleRuntimeError("Could not prepare", e.what());
+        return SharedPtr<DbStatement>();
+    }
+
+    // Evict cached statements not referenced elsewhere when the cache is full
+    if (statements_.Size() >= statementCacheSize_)
+    {
+        for (i = statements_.Begin(); i != statements_.End();)
+        {
+            if (i->second_->Refs() == 1)
+                i = statements_.Erase(i);
+            else
+                ++i;
+        }
+    }
+
+    // A statement prepared while the cached one is in use stays uncached
+    if (statementCacheSize_ && !cachedInUse)
+        statements_[sql] = statement;
+    return statement;
+}
+
+bool DbConnection::ExecuteBatch(const String& sql, const Vector<VariantVector>& rows)
+{
+    SharedPtr<DbStatement> statement = Prepare(sql);
+    if (!statement || !BeginTransaction())
+        return false;
+
+    for (unsigned i = 0; i < rows.Size(); ++i)
+    {
+        statement->Reset();
+        if (!statement->Bind(rows[i]) || !statement->Execute())
+        {
+            RollbackTransaction();
+            return false;
+        }
+    }
+
+    if (!CommitTransaction())
+    {
+        RollbackTransaction();
+        return false;
+    }
+
+    return true;
+}
+
+bool DbConnection::BeginTransaction()
+{
+    if (transactionImpl_)
+    {
+        LOGERROR("Could not begin transaction: a transaction is already in progress");
+        return false;
+    }
+
+    try
+    {
+        transactionImpl_ = new nanodbc::transaction(connectionImpl_);
+    }
+    catch (std::runtime_error& e)
+    {
+        HandleRuntimeError("Could not begin transaction", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool DbConnection::CommitTransaction()
+{
+    if (!transactionImpl_)
+        return false;
+
+    try
+    {
+        transactionImpl_->commit();
+    }
+    catch (std::runtime_error& e)
+    {
+        HandleRuntimeError("Could not commit transaction", e.what());
+        return false;
+    }
+
+    delete transactionImpl_;
+    transactionImpl_ = 0;
+    return true;
+}
+
+bool DbConnection::RollbackTransaction()
+{
+    if (!transactionImpl_)
+        return false;
+
+    transactionImpl_->rollback();
+    delete transactionImpl_;
+    transactionImpl_ = 0;
+    return true;
 }
 
 DbResult DbConnection::Execute(const String& sql, bool useCursorEvent)
@@ -85,33 +216,7 @@ DbResult DbConnection::Execute(const String& sql, bool useCursorEvent)
             {
                 VariantVector colValues(numCols);
                 for (unsigned i = 0; i < numCols; ++i)
-                {
-                    if (!result.resultImpl_.is_null((short)i))
-                    {
-                        // We can only bind primitive data type that our Variant class supports
-                        switch (result.resultImpl_.column_c_datatype((short)i))
-                        {
-                        case SQL_C_LONG:
-                            colValues[i] = result.resultImpl_.get<int>((short)i);
-                            if (result.resultImpl_.column_datatype((short)i) == SQL_BIT)
-                                colValues[i] = colValues[i] != 0;
-                            break;
-
-                        case SQL_C_FLOAT:
-                            colValues[i] = result.resultImpl_.get<float>((short)i);
-                            break;
-
-                        case SQL_C_DOUBLE:
-                            colValues[i] = result.resultImpl_.get<double>((short)i);
-                            break;
-
-                        default:
-                            // All other types are stored using their string representation in the Variant
-                            colValues[i] = result.resultImpl_.get<nanodbc::string_type>((short)i).c_str();
-                            break;
-                        }
-                    }
-                }
+                    colValues[i] = DbStatement::GetColumnValue(result.resultImpl_, i);
 
                 if (useCursorEvent)
                 {
@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Database/DbStatement.h"
+#include "../../IO/Log.h"
+
+#include <sqlext.h>
+
+namespace Urho3D
+{
+
+DbStatement::DbStatement(const nanodbc::statement& statementImpl, const String& sql) :
+    statementImpl_(statementImpl),
+    sql_(sql),
+    numAffectedRows_(-1),
+    error_(false),
+    started_(false)
+{
+}
+
+DbStatement::~DbStatement()
+{
+    Finalize();
+}
+
+void DbStatement::Finalize()
+{
+    resultImpl_ = nanodbc::result();
+    statementImpl_.close();
+}
+
+bool DbStatement::Bind(unsigned index, const Variant& value)
+{
+    if (!statementImpl_.open())
+        return false;
+
+    // The values are bound on execute, as nanodbc binds pointers to the value storage
+    if (index >= params_.Size())
+        params_.Resize(index + 1);
+    params_[index] = value;
+    return true;
+}
+
+bool DbStatement::Bind(const VariantVector& values)
+{
+    for (unsigned i = 0; i < values.Size(); ++i)
+    {
+        if (!Bind(i, values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+void DbStatement::ClearBindings()
+{
+    for (unsigned i = 0; i < params_.Size(); ++i)
+        params_[i] = Variant::EMPTY;
+}
+
+bool DbStatement::Start()
+{
+    started_ = true;
+
+    try
+    {
+        // Size the storage up front so the bound pointers stay valid
+        intParams_.Resize(params_.Size());
+        doubleParams_.Resize(params_.Size());
+        stringParams_.Resize(params_.Size());
+
+        statementImpl_.reset_parameters();
+        for (unsigned i = 0; i < params_.Size(); ++i)
+        {
+            const Variant& value = params_[i];
+            short param = (short)i;
+
+            switch (value.GetType())
+            {
+            case VAR_NONE:
+                statementImpl_.bind_null(param);
+                break;
+
+            case VAR_INT:
+            case VAR_BOOL:
+                intParams_[i] = value.GetType() == VAR_BOOL ? (value.GetBool() ? 1 : 0) : value.GetInt();
+                statementImpl_.bind(param, &intParams_[i]);
+                break;
+
+            case VAR_FLOAT:
+            case VAR_DOUBLE:
+                doubleParams_[i] = value.GetDouble();
+                statementImpl_.bind(param, &doubleParams_[i]);
+                break;
+
+            default:
+                stringParams_[i] = value.GetType() == VAR_STRING ? value.GetString() : value.ToString();
+                statementImpl_.bind(param, stringParams_[i].CString());
+                break;
+            }
+        }
+
+        resultImpl_ = statementImpl_.execute();
+        numAffectedRows_ = resultImpl_.columns() ? -1 : resultImpl_.affected_rows();
+    }
+    catch (std::runtime_error& e)
+    {
+        LOGERRORF("Could not execute: %s", e.what());
+        resultImpl_ = nanodbc::result();
+        error_ = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool DbStatement::Next()
+{
+    if (!started_ && !Start())
+        return false;
+    if (!resultImpl_)
+        return false;
+
+    try
+    {
+        return resultImpl_.next();
+    }
+    catch (std::runtime_error& e)
+    {
+        LOGERRORF("Could not fetch: %s", e.what());
+        error_ = true;
+        return false;
+    }
+}
+
+bool DbStatement::Execute()
+{
+    if (started_)
+        return (bool)resultImpl_;
+
+    return Start();
+}
+
+void DbStatement::Reset()
+{
+    resultImpl_ = nanodbc::result();
+    numAffectedRows_ = -1;
+    error_ = false;
+    started_ = false;
+}
+
+unsigned DbStatement::GetNumColumns() const
+{
+    return resultImpl_ ? (unsigned)resultImpl_.columns() : 0;
+}
+
+String DbStatement::GetColumnName(unsigned index) const
+{
+    return resultImpl_ ? String(resultImpl_.column_name((short)index).c_str()) : String::EMPTY;
+}
+
+bool DbStatement::IsNull(unsigned index) const
+{
+    return !resultImpl_ || resultImpl_.is_null((short)index);
+}
+
+int DbStatement::GetInt(unsigned index) const
+{
+    return IsNull(index) ? 0 : resultImpl_.get<int>((short)index);
+}
+
+double DbStatement::GetDouble(unsigned index) const
+{
+    return IsNull(index) ? 0.0 : resultImpl_.get<double>((short)index);
+}
+
+String DbStatement::GetString(unsigned index) const
+{
+    return IsNull(index) ? String::EMPTY : String(resultImpl_.get<nanodbc::string_type>((short)index).c_str());
+}
+
+Variant DbStatement::GetValue(unsigned index) const
+{
+    return resultImpl_ ? GetColumnValue(resultImpl_, index) : Variant::EMPTY;
+}
+
+Variant DbStatement::GetColumnValue(const nanodbc::result& resultImpl, unsigned index)
+{
+    Variant value;
+    short column = (short)index;
+
+    if (resultImpl.is_null(column))
+        return value;
+
+    // We can only bind primitive data type that our Variant class supports
+    switch (resultImpl.column_c_datatype(column))
+    {
+    case SQL_C_LONG:
+        value = resultImpl.get<int>(column);
+        if (resultImpl.column_datatype(column) == SQL_BIT)
+            value = value != 0;
+        break;
+
+    case SQL_C_FLOAT:
+        value = resultImpl.get<float>(column);
+        break;
+
+    case SQL_C_DOUBLE:
+        value = resultImpl.get<double>(column);
+        break;
+
+    default:
+        // All other types are stored using their string representation in the Variant
+        value = resultImpl.get<nanodbc::string_type>(column).c_str();
+        break;
+    }
+
+    return value;
+}
+
+}
@@ -28,10 +28,13 @@
 namespace Urho3D
 {
 
+static const unsigned DEFAULT_STATEMENT_CACHE_SIZE = 64;
+
 DbConnection::DbConnection(Context* context, const String& connectionString) :
     Object(context),
     connectionString_(connectionString),
-    connectionImpl_(0)
+    connectionImpl_(0),
+    statementCacheSize_(DEFAULT_STATEMENT_CACHE_SIZE)
 {
     if (sqlite3_open(connectionString.CString(), &connectionImpl_) != SQLITE_OK)
     {
@@ -55,7 +58,116 @@ DbConnection::~DbConnection()
 
 void DbConnection::Finalize()
 {
-    // TODO
+    // Statements still referenced elsewhere become unusable
+    for (HashMap<String, SharedPtr<DbStatement> >::Iterator i = statements_.Begin(); i != statements_.End(); ++i)
+        i->second_->Finalize();
+    statements_.Clear();
+}
+
+SharedPtr<DbStatement> DbConnection::Prepare(const String& sql)
+{
+    assert(connectionImpl_);
+
+    HashMap<String, SharedPtr<DbStatement> >::Iterator i = statements_.Find(sql);
+    bool cachedInUse = false;
+    if (i != statements_.End())
+    {
+        // Only hand out the cached statement when no one else is stepping through it
+        if (i->second_->Refs() == 1)
+        {
+            i->second_->Reset();
+            i->second_->ClearBindings();
+            return i->second_;
+        }
+        cachedInUse = true;
+    }
+
+    const char* zLeftover = 0;
+    sqlite3_stmt* pStmt = 0;
+    int rc = sqlite3_prepare_v2(connectionImpl_, sql.Trimmed().CString(), -1, &pStmt, &zLeftover);
+    if (rc != SQLITE_OK)
+    {
+        LOGERRORF("Could not prepare: %s", sqlite3_errmsg(connectionImpl_));
+        assert(!pStmt);
+        return SharedPtr<DbStatement>();
+    }
+    if (*zLeftover)
+    {
+        LOGERROR("Could not prepare: only one SQL statement is allowed");
+        sqlite3_finalize(pStmt);
+        return SharedPtr<DbStatement>();
+    }
+
+    // Evict cached statements not referenced elsewhere when the cache is full
+    if (statements_.Size() >= statementCacheSize_)
+    {
+        for (i = statements_.Begin(); i != statements_.End();)
+        {
+            if (i->second_->Refs() == 1)
+                i = statements_.Erase(i);
+            else
+                ++i;
+        }
+    }
+
+    SharedPtr<DbStatement> statement(new DbStatement(pStmt, sql));
+    // A statement prepared while the cached one is in use stays uncached
+    if (statementCacheSize_ && !cachedInUse)
+        statements_[sql] = statement;
+    return statement;
+}
+
+bool DbConnection::ExecuteBatch(const String& sql, const Vector<VariantVector>& rows)
+{
+    SharedPtr<DbStatement> statement = Prepare(sql);
+    if (!statement || !BeginTransaction())
+        return false;
+
+    for (unsigned i = 0; i < rows.Size(); ++i)
+    {
+        statement->Reset();
+        if (!statement->Bind(rows[i]) || !statement->Execute())
+        {
+            RollbackTransaction();
+            return false;
+        }
+    }
+
+    if (!CommitTransaction())
+    {
+        RollbackTransaction();
+        return false;
+    }
+
+    return true;
+}
+
+bool DbConnection::BeginTransaction()
+{
+    return ExecuteImmediate("BEGIN");
+}
+
+bool DbConnection::CommitTransaction()
+{
+    return ExecuteImmediate("COMMIT");
+}
+
+bool DbConnection::RollbackTransaction()
+{
+    return ExecuteImmediate("ROLLBACK");
+}
+
+bool DbConnection::ExecuteImmediate(const char* sql)
+{
+    assert(connectionImpl_);
+
+    if (sqlite3_exec(connectionImpl_, sql, 0, 0, 0) != SQLITE_OK)
+    {
+        LOGERRORF("Could not execute: %s", sqlite3_errmsg(connectionImpl_));
+        return false;
+    }
+
+    return true;
 }
 
 DbResult DbConnection::Execute(const String& sql, bool useCursorEvent)
@@ -93,30 +205,7 @@ DbResult DbConnection::Execute(const String& sql, bool useCursorEvent)
         {
             VariantVector colValues(numCols);
             for (unsigned i = 0; i < numCols; ++i)
-            {
-                int type = sqlite3_column_type(pStmt, i);
-                if (type != SQLITE_NULL)
-                {
-                    // We can only bind primitive data type that our Variant class supports
-                    switch (type)
-                    {
-                    case SQLITE_INTEGER:
-                        colValues[i] = sqlite3_column_int(pStmt, i);
-                        if (String(sqlite3_column_decltype(pStmt, i)).Compare("BOOLEAN", false) == 0)
-                            colValues[i] = colValues[i] != 0;
-                        break;
-
-                    case SQLITE_FLOAT:
-                        colValues[i] = sqlite3_column_double(pStmt, i);
-                        break;
-
-                    default:
-                        // All other types are stored using their string representation in the Variant
-                        colValues[i] = (const char*)sqlite3_column_text(pStmt, i);
-                        break;
-                    }
-                }
-            }
+                colValues[i] = DbStatement::GetColumnValue(pStmt, i);
 
             if (useCursorEvent)
             {
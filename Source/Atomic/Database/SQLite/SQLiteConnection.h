@@ -22,8 +22,10 @@
 
 #pragma once
 
+#include "../../Container/HashMap.h"
 #include "../../Core/Object.h"
 #include "../../Database/DbResult.h"
+#include "../../Database/DbStatement.h"
 
 #include <SQLite/sqlite3.h>
 
@@ -45,6 +47,18 @@ public:
 
     /// Execute an SQL statements immediately. Send E_DBCURSOR event for each row in the resultset when useCursorEvent parameter is set to true.
     DbResult Execute(const String& sql, bool useCursorEvent = false);
+    /// Prepare an SQL statement with ? placeholders for bound parameters, to step through its resultset as a cursor. Statements are cached by their SQL, a cached statement not referenced elsewhere is returned reset with its parameters cleared, otherwise a new uncached statement is prepared. Return null if failed.
+    SharedPtr<DbStatement> Prepare(const String& sql);
+    /// Execute an SQL statement once for each row of bound parameters in a single transaction. Return true if successful, otherwise the transaction is rolled back.
+    bool ExecuteBatch(const String& sql, const Vector<VariantVector>& rows);
+    /// Begin a transaction. Return true if successful.
+    bool BeginTransaction();
+    /// Commit the current transaction. Return true if successful.
+    bool CommitTransaction();
+    /// Roll back the current transaction. Return true if successful.
+    bool RollbackTransaction();
+    /// Set maximum number of cached prepared statements. Statements still referenced outside the cache are not evicted.
+    void SetStatementCacheSize(unsigned size) { statementCacheSize_ = size; }
 
     /// Return database connection string. The connection string for SQLite3 is using the URI format described in https://www.sqlite.org/uri.html, while the connection string for ODBC is using DSN format as per ODBC standard.
     const String& GetConnectionString() const { return connectionString_; }
@@ -55,11 +69,21 @@ public:
     /// Return true when the connection object is connected to the associated database.
     bool IsConnected() const { return connectionImpl_ != 0; }
 
+    /// Return maximum number of cached prepared statements.
+    unsigned GetStatementCacheSize() const { return statementCacheSize_; }
+
 private:
+    /// Execute an SQL statement without a resultset. Return true if successful.
+    bool ExecuteImmediate(const char* sql);
+
     /// The connection string for SQLite3 is using the URI format described in https://www.sqlite.org/uri.html, while the connection string for ODBC is using DSN format as per ODBC standard.
     String connectionString_;
     /// The underlying implementation connection object.
     sqlite3* connectionImpl_;
+    /// Prepared statements by SQL.
+    HashMap<String, SharedPtr<DbStatement> > statements_;
+    /// Maximum number of cached prepared statements.
+    unsigned statementCacheSize_;
 };
 
 }
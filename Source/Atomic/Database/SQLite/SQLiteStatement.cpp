@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Database/DbStatement.h"
+#include "../../IO/Log.h"
+
+namespace Urho3D
+{
+
+DbStatement::DbStatement(sqlite3_stmt* statementImpl, const String& sql) :
+    statementImpl_(statementImpl),
+    sql_(sql),
+    numAffectedRows_(-1),
+    error_(false),
+    done_(false)
+{
+}
+
+DbStatement::~DbStatement()
+{
+    Finalize();
+}
+
+void DbStatement::Finalize()
+{
+    sqlite3_finalize(statementImpl_);
+    statementImpl_ = 0;
+}
+
+bool DbStatement::Bind(unsigned index, const Variant& value)
+{
+    if (!statementImpl_)
+        return false;
+
+    // SQLite parameters are 1-based
+    int param = (int)index + 1;
+    int rc;
+
+    switch (value.GetType())
+    {
+    case VAR_NONE:
+        rc = sqlite3_bind_null(statementImpl_, param);
+        break;
+
+    case VAR_INT:
+        rc = sqlite3_bind_int(statementImpl_, param, value.GetInt());
+        break;
+
+    case VAR_BOOL:
+        rc = sqlite3_bind_int(statementImpl_, param, value.GetBool() ? 1 : 0);
+        break;
+
+    case VAR_FLOAT:
+    case VAR_DOUBLE:
+        rc = sqlite3_bind_double(statementImpl_, param, value.GetDouble());
+        break;
+
+    case VAR_STRING:
+        {
+            const String& str = value.GetString();
+            rc = sqlite3_bind_text(statementImpl_, param, str.CString(), str.Length(), SQLITE_TRANSIENT);
+        }
+        break;
+
+    case VAR_BUFFER:
+        {
+            const PODVector<unsigned char>& buffer = value.GetBuffer();
+            rc = sqlite3_bind_blob(statementImpl_, param, buffer.Size() ? &buffer[0] : 0, buffer.Size(), SQLITE_TRANSIENT);
+        }
+        break;
+
+    default:
+        {
+            String str = value.ToString();
+            rc = sqlite3_bind_text(statementImpl_, param, str.CString(), str.Length(), SQLITE_TRANSIENT);
+        }
+        break;
+    }
+
+    if (rc != SQLITE_OK)
+    {
+        LOGERRORF("Could not bind parameter %u: %s", index, sqlite3_errmsg(sqlite3_db_handle(statementImpl_)));
+        return false;
+    }
+
+    return true;
+}
+
+bool DbStatement::Bind(const VariantVector& values)
+{
+    for (unsigned i = 0; i < values.Size(); ++i)
+    {
+        if (!Bind(i, values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+void DbStatement::ClearBindings()
+{
+    if (statementImpl_)
+        sqlite3_clear_bindings(statementImpl_);
+}
+
+int DbStatement::Step()
+{
+    if (!statementImpl_ || done_)
+        return SQLITE_DONE;
+
+    int rc = sqlite3_step(statementImpl_);
+    if (rc == SQLITE_ROW)
+        return rc;
+
+    done_ = true;
+    if (rc == SQLITE_DONE)
+        numAffectedRows_ = sqlite3_column_count(statementImpl_) ? -1 : sqlite3_changes(sqlite3_db_handle(statementImpl_));
+    else
+    {
+        LOGERRORF("Could not execute: %s", sqlite3_errmsg(sqlite3_db_handle(statementImpl_)));
+        error_ = true;
+    }
+
+    return rc;
+}
+
+bool DbStatement::Next()
+{
+    return Step() == SQLITE_ROW;
+}
+
+bool DbStatement::Execute()
+{
+    int rc;
+    while ((rc = Step()) == SQLITE_ROW)
+    {
+    }
+
+    return statementImpl_ && rc == SQLITE_DONE;
+}
+
+void DbStatement::Reset()
+{
+    if (statementImpl_)
+        sqlite3_reset(statementImpl_);
+
+    numAffectedRows_ = -1;
+    error_ = false;
+    done_ = false;
+}
+
+unsigned DbStatement::GetNumColumns() const
+{
+    return statementImpl_ ? (unsigned)sqlite3_column_count(statementImpl_) : 0;
+}
+
+String DbStatement::GetColumnName(unsigned index) const
+{
+    const char* name = statementImpl_ ? sqlite3_column_name(statementImpl_, index) : 0;
+    return name ? String(name) : String::EMPTY;
+}
+
+bool DbStatement::IsNull(unsigned index) const
+{
+    return !statementImpl_ || sqlite3_column_type(statementImpl_, index) == SQLITE_NULL;
+}
+
+int DbStatement::GetInt(unsigned index) const
+{
+    return statementImpl_ ? sqlite3_column_int(statementImpl_, index) : 0;
+}
+
+double DbStatement::GetDouble(unsigned index) const
+{
+    return statementImpl_ ? sqlite3_column_double(statementImpl_, index) : 0.0;
+}
+
+String DbStatement::GetString(unsigned index) const
+{
+    const char* text = statementImpl_ ? (const char*)sqlite3_column_text(statementImpl_, index) : 0;
+    return text ? String(text) : String::EMPTY;
+}
+
+Variant DbStatement::GetValue(unsigned index) const
+{
+    return statementImpl_ ? GetColumnValue(statementImpl_, index) : Variant::EMPTY;
+}
+
+Variant DbStatement::GetColumnValue(sqlite3_stmt* statementImpl, unsigned index)
+{
+    Variant value;
+
+    // We can only bind primitive data type that our Variant class supports
+    switch (sqlite3_column_type(statementImpl, index))
+    {
+    case SQLITE_NULL:
+        break;
+
+    case SQLITE_INTEGER:
+        value = sqlite3_column_int(statementImpl, index);
+        if (String(sqlite3_column_decltype(statementImpl, index)).Compare("BOOLEAN", false) == 0)
+            value = value != 0;
+        break;
+
+    case SQLITE_FLOAT:
+        value = sqlite3_column_double(statementImpl, index);
+        break;
+
+    default:
+        // All other types are stored using their string representation in the Variant
+        value = (const char*)sqlite3_column_text(statementImpl, index);
+        break;
+    }
+
+    return value;
+}
+
+}
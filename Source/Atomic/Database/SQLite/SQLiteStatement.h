@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../../Container/RefCounted.h"
+#include "../../Core/Variant.h"
+
+#include <SQLite/sqlite3.h>
+
+namespace Urho3D
+{
+
+/// %Database prepared statement with bound parameters, stepped through its resultset as a cursor without materializing the rows.
+class URHO3D_API DbStatement : public RefCounted
+{
+    REFCOUNTED(DbStatement)
+
+    friend class DbConnection;
+
+public:
+    /// Construct from a prepared statement. Use DbConnection::Prepare() to create statements.
+    DbStatement(sqlite3_stmt* statementImpl, const String& sql);
+    /// Destruct. Finalize the statement.
+    ~DbStatement();
+
+    /// Bind a value to a ? placeholder by 0-based index. An empty variant binds NULL. Types without an SQL equivalent are bound using their string representation. Return true if successful.
+    bool Bind(unsigned index, const Variant& value);
+    /// Bind values to the ? placeholders in order. Return true if successful.
+    bool Bind(const VariantVector& values);
+    /// Set all placeholders to NULL.
+    void ClearBindings();
+    /// Execute the statement on the first call and advance to the next row of the resultset. Return true if a row is available, false at the end of the resultset or on error.
+    bool Next();
+    /// Execute the statement, skipping any resultset. Return true if successful.
+    bool Execute();
+    /// Reset the statement to be executed again. Bound values are kept.
+    void Reset();
+
+    /// Return number of columns in the resultset.
+    unsigned GetNumColumns() const;
+    /// Return column name.
+    String GetColumnName(unsigned index) const;
+    /// Return whether the column of the current row is NULL.
+    bool IsNull(unsigned index) const;
+    /// Return column of the current row as an integer.
+    int GetInt(unsigned index) const;
+    /// Return column of the current row as a boolean.
+    bool GetBool(unsigned index) const { return GetInt(index) != 0; }
+    /// Return column of the current row as a double.
+    double GetDouble(unsigned index) const;
+    /// Return column of the current row as a string.
+    String GetString(unsigned index) const;
+    /// Return column of the current row converted to a variant the same way DbConnection::Execute() fetches rows.
+    Variant GetValue(unsigned index) const;
+
+    /// Return number of affected rows by the executed DML statement or -1 if the number of affected rows is not available.
+    long GetNumAffectedRows() const { return numAffectedRows_; }
+    /// Return whether the statement failed to execute or fetch since the last reset.
+    bool HasError() const { return error_; }
+    /// Return the SQL of the statement.
+    const String& GetSQL() const { return sql_; }
+    /// Return the underlying implementation statement object pointer. It is sqlite3_stmt* when using SQLite3 or nanodbc::statement* when using ODBC.
+    const sqlite3_stmt* GetStatementImpl() const { return statementImpl_; }
+
+private:
+    /// Finalize the statement before its connection is closed.
+    void Finalize();
+    /// Step the statement. Return the SQLite result code.
+    int Step();
+
+    /// Return a column of the current row converted to a variant.
+    static Variant GetColumnValue(sqlite3_stmt* statementImpl, unsigned index);
+
+    /// The underlying implementation statement object.
+    sqlite3_stmt* statementImpl_;
+    /// SQL of the statement.
+    String sql_;
+    /// Number of affected rows by the executed DML statement.
+    long numAffectedRows_;
+    /// Whether the statement failed to execute or fetch.
+    bool error_;
+    /// Whether the end of the resultset has been reached.
+    bool done_;
+};
+
+}
@@ -667,15 +667,23 @@ void Engine::Update()
     VariantMap& eventData = GetEventDataMap();
     eventData[P_TIMESTEP] = timeStep_;
     SendEvent(E_UPDATE, eventData);
+    UpdateEvent updateEvent = { timeStep_ };
+    SendTypedEvent(updateEvent);
 
     // Logic post-update event
     SendEvent(E_POSTUPDATE, eventData);
+    PostUpdateEvent postUpdateEvent = { timeStep_ };
+    SendTypedEvent(postUpdateEvent);
 
     // Rendering update event
     SendEvent(E_RENDERUPDATE, eventData);
+    RenderUpdateEvent renderUpdateEvent = { timeStep_ };
+    SendTypedEvent(renderUpdateEvent);
 
     // Post-render update event
     SendEvent(E_POSTRENDERUPDATE, eventData);
+    PostRenderUpdateEvent postRenderUpdateEvent = { timeStep_ };
+    SendTypedEvent(postRenderUpdateEvent);
 }
 
 void Engine::Render()
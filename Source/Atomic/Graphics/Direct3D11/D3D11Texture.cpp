@@ -28,6 +28,7 @@
 #include "../../Graphics/Material.h"
 #include "../../IO/FileSystem.h"
 #include "../../IO/Log.h"
+#include "../../Resource/Image.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Resource/XMLFile.h"
 
@@ -440,4 +441,14 @@ void Texture::CheckTextureBudget(StringHash type)
         cache->ReleaseResources(Material::GetTypeStatic());
 }
 
+void Texture::SetImageSRGB(Image* image, XMLFile* xml)
+{
+    if (!image || !xml)
+        return;
+
+    XMLElement srgbElem = xml->GetRoot().GetChild("srgb");
+    if (srgbElem && srgbElem.GetBool("enable"))
+        image->SetSRGB(true);
+}
+
 }
@@ -33,6 +33,7 @@ namespace Atomic
 
 static const int MAX_TEXTURE_QUALITY_LEVELS = 3;
 
+class Image;
 class XMLElement;
 class XMLFile;
 
@@ -151,6 +152,8 @@ public:
 protected:
     /// Check whether texture memory budget has been exceeded. Free unused materials in that case to release the texture references.
     void CheckTextureBudget(StringHash type);
+    /// Mark an image being loaded as sRGB if the parameters enable sRGB sampling, so that its mip levels are filtered in linear space.
+    void SetImageSRGB(Image* image, XMLFile* xml);
 
     /// Shader resource view.
     void* shaderResourceView_;
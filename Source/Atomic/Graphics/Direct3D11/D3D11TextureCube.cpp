@@ -214,6 +214,10 @@ bool TextureCube::BeginLoad(Deserializer& source)
         }
     }
 
+    // Filter mip levels in linear space if sRGB sampling is enabled
+    for (unsigned i = 0; i < loadImages_.Size(); ++i)
+        SetImageSRGB(loadImages_[i], loadParameters_);
+
     // Precalculate mip levels if async loading
     if (GetAsyncLoadState() == ASYNC_LOADING)
     {
@@ -32,6 +32,7 @@
 #include "../IO/Log.h"
 
 #include <cstdio>
+#include <ctime>
 
 #ifdef ANDROID
 #include <android/log.h>
@@ -54,27 +55,106 @@ const char* logLevelPrefixes[] =
     0
 };
 
+/// File ID of binary structured log files.
+static const char* LOG_BINARY_ID = "ALOG";
+
 static Log* logInstance = 0;
 static bool threadErrorDisplayed = false;
 
+/// Log writer thread. Writes the queued messages so that logging threads do not wait for the console or file output.
+class LogWriterThread : public Thread
+{
+public:
+    /// Construct.
+    LogWriterThread(Log* owner) :
+        owner_(owner)
+    {
+    }
+
+    /// Write queued messages until stopped, then write the remaining messages.
+    virtual void ThreadFunction()
+    {
+        while (shouldRun_)
+        {
+            bool unflushed;
+            {
+                MutexLock lock(owner_->fileMutex_);
+                unflushed = owner_->unflushed_;
+            }
+
+            // Wait for queued messages, or for the flush interval to elapse if the log file has unflushed data
+            if (unflushed)
+                owner_->messagesQueued_.Acquire(owner_->flushInterval_);
+            else
+                owner_->messagesQueued_.Acquire();
+
+            // One pass writes every message queued so far
+            while (owner_->messagesQueued_.TryAcquire())
+            {
+            }
+
+            owner_->ProcessQueuedMessages();
+        }
+
+        owner_->ProcessQueuedMessages();
+    }
+
+    /// Wake up the thread and wait for it to write the remaining messages and exit.
+    void StopWriting()
+    {
+        shouldRun_ = false;
+        owner_->messagesQueued_.Release();
+        Stop();
+    }
+
+private:
+    /// Log subsystem.
+    Log* owner_;
+};
+
 Log::Log(Context* context) :
     Object(context),
+    writerThread_(0),
 #ifdef _DEBUG
     level_(LOG_DEBUG),
 #else
     level_(LOG_INFO),
 #endif
+    flushInterval_(0),
     timeStamp_(true),
     inWrite_(false),
+    writingMessages_(false),
+    unflushed_(false),
+    binaryFormat_(false),
+    fileBinary_(false),
     quiet_(false)
 {
     logInstance = this;
 
+    // If threads are not available, the messages are written by the thread that logs them
+    writerThread_ = new LogWriterThread(this);
+    if (!writerThread_->Run())
+    {
+        delete writerThread_;
+        writerThread_ = 0;
+    }
+
     SubscribeToEvent(E_ENDFRAME, HANDLER(Log, HandleEndFrame));
 }
 
 Log::~Log()
 {
+    // Stop the writer thread, which writes the remaining messages
+    if (writerThread_)
+    {
+        writerThread_->StopWriting();
+        delete writerThread_;
+        writerThread_ = 0;
+    }
+
+    ProcessQueuedMessages();
+    Close();
+
     logInstance = 0;
 }
 
@@ -91,24 +171,44 @@ void Log::Open(const String& fileName)
             Close();
     }
 
-    logFile_ = new File(context_);
-    if (logFile_->Open(fileName, FILE_WRITE))
+    bool success;
+
+    {
+        MutexLock lock(fileMutex_);
+
+        logFile_ = new File(context_);
+        success = logFile_->Open(fileName, FILE_WRITE);
+        if (success)
+        {
+            fileBinary_ = binaryFormat_;
+            if (fileBinary_)
+                logFile_->WriteFileID(LOG_BINARY_ID);
+            flushTimer_.Reset();
+        }
+        else
+            logFile_.Reset();
+    }
+
+    if (success)
         Write(LOG_INFO, "Opened log file " + fileName);
     else
-    {
-        logFile_.Reset();
         Write(LOG_ERROR, "Failed to create log file " + fileName);
-    }
 #endif
 }
 
 void Log::Close()
 {
 #if !defined(ANDROID) && !defined(IOS)
+    // Write the messages logged so far before closing
+    ProcessQueuedMessages();
+
+    MutexLock lock(fileMutex_);
+
     if (logFile_ && logFile_->IsOpen())
     {
         logFile_->Close();
         logFile_.Reset();
+        unflushed_ = false;
     }
 #endif
 }
@@ -130,153 +230,310 @@ void Log::SetQuiet(bool quiet)
     quiet_ = quiet;
 }
 
+void Log::SetFlushInterval(unsigned mSec)
+{
+    flushInterval_ = mSec;
+}
+
+void Log::SetBinaryFormat(bool enable)
+{
+    binaryFormat_ = enable;
+}
+
 void Log::Write(int level, const String& message)
 {
     assert(level >= LOG_DEBUG && level < LOG_NONE);
 
-    // If not in the main thread, store message for later processing
+    // Do not log if message level excluded
+    if (!logInstance || logInstance->level_ > level)
+        return;
+
+    StoredLogMessage stored(message, level, false, Time::GetTimeSinceEpoch());
+
+    // If not in the main thread, queue the message for writing and store it for sending the event later
     if (!Thread::IsMainThread())
     {
-        if (logInstance)
-        {
-            MutexLock lock(logInstance->logMutex_);
-            logInstance->threadMessages_.Push(StoredLogMessage(message, level, false));
-        }
+        logInstance->QueueMessage(stored);
 
+        MutexLock lock(logInstance->logMutex_);
+        logInstance->threadMessages_.Push(stored);
         return;
     }
 
-    // Do not log if message level excluded or if currently sending a log event
-    if (!logInstance || logInstance->level_ > level || logInstance->inWrite_)
+    // Do not log if currently sending a log event
+    if (logInstance->inWrite_)
         return;
 
-    String formattedMessage = logLevelPrefixes[level];
-    formattedMessage += ": " + message;
     logInstance->lastMessage_ = message;
+    logInstance->QueueMessage(stored);
+    logInstance->SendMessageEvent(stored);
+}
+
+void Log::WriteRaw(const String& message, bool error)
+{
+    if (!logInstance)
+        return;
 
-    if (logInstance->timeStamp_)
-        formattedMessage = "[" + Time::GetTimeStamp() + "] " + formattedMessage;
+    StoredLogMessage stored(message, LOG_RAW, error, Time::GetTimeSinceEpoch());
 
-#if defined(ANDROID)
-    int androidLevel = ANDROID_LOG_DEBUG + level;
-    __android_log_print(androidLevel, "Atomic", "%s", message.CString());
-#elif defined(IOS)
-    SDL_IOS_LogMessage(message.CString());
-#else
-    if (logInstance->quiet_)
+    // If not in the main thread, queue the message for writing and store it for sending the event later
+    if (!Thread::IsMainThread())
     {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (level == LOG_ERROR)
-            PrintUnicodeLine(formattedMessage, true);
+        logInstance->QueueMessage(stored);
+
+        MutexLock lock(logInstance->logMutex_);
+        logInstance->threadMessages_.Push(stored);
+        return;
     }
-    else
-        PrintUnicodeLine(formattedMessage, level == LOG_ERROR);
-#endif
 
-    if (logInstance->logFile_)
+    // Prevent recursion during log event
+    if (logInstance->inWrite_)
+        return;
+
+    logInstance->lastMessage_ = message;
+    logInstance->QueueMessage(stored);
+    logInstance->SendMessageEvent(stored);
+}
+
+bool Log::IsLevelEnabled(int level)
+{
+    return logInstance && logInstance->level_ <= level;
+}
+
+String Log::FormatLogMessage(const StoredLogMessage& message, bool timeStamp)
+{
+    if (message.level_ == LOG_RAW)
+        return message.message_;
+
+    String formattedMessage;
+
+    if (timeStamp)
     {
-        logInstance->logFile_->WriteLine(formattedMessage);
-        logInstance->logFile_->Flush();
+        // Use the reentrant variants, as messages are formatted outside the main thread
+        time_t sysTime = (time_t)message.time_;
+        char dateTime[32];
+#ifdef _WIN32
+        if (ctime_s(dateTime, sizeof dateTime, &sysTime))
+            dateTime[0] = 0;
+#else
+        if (!ctime_r(&sysTime, dateTime))
+            dateTime[0] = 0;
+#endif
+        formattedMessage = "[" + String(dateTime).Replaced("\n", "") + "] ";
     }
 
-    logInstance->inWrite_ = true;
+    formattedMessage += logLevelPrefixes[message.level_];
+    formattedMessage += ": ";
+    formattedMessage += message.message_;
+    return formattedMessage;
+}
 
-    using namespace LogMessage;
+bool Log::ReadBinaryLog(Deserializer& source, Vector<StoredLogMessage>& messages)
+{
+    if (source.ReadFileID() != LOG_BINARY_ID)
+        return false;
+
+    while (!source.IsEof())
+    {
+        StoredLogMessage message;
+        message.level_ = source.ReadByte();
+        message.error_ = source.ReadBool();
+        message.time_ = source.ReadUInt();
+        message.message_ = source.ReadString();
 
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = formattedMessage;
-    eventData[P_LEVEL] = level;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+        // Stop at a truncated or corrupt record, for example if the application exited while writing
+        if (message.level_ < LOG_RAW || message.level_ >= LOG_NONE)
+            break;
+
+        messages.Push(message);
+    }
 
-    logInstance->inWrite_ = false;
+    return true;
 }
 
-void Log::WriteRaw(const String& message, bool error)
+void Log::HandleEndFrame(StringHash eventType, VariantMap& eventData)
 {
-    // If not in the main thread, store message for later processing
+    // If the MainThreadID is not valid, processing this loop can potentially be endless
     if (!Thread::IsMainThread())
     {
-        if (logInstance)
+        if (!threadErrorDisplayed)
         {
-            MutexLock lock(logInstance->logMutex_);
-            logInstance->threadMessages_.Push(StoredLogMessage(message, LOG_RAW, error));
+            fprintf(stderr, "Thread::mainThreadID is not setup correctly! Threaded log handling disabled\n");
+            threadErrorDisplayed = true;
         }
-
         return;
     }
 
-    // Prevent recursion during log event
-    if (!logInstance || logInstance->inWrite_)
-        return;
-
-    logInstance->lastMessage_ = message;
+    // Without a writer thread, write the messages queued by other threads
+    if (!writerThread_)
+        ProcessQueuedMessages();
 
-#if defined(ANDROID)
-    if (logInstance->quiet_)
+    // Send the events of messages accumulated from other threads (if any)
+    List<StoredLogMessage> messages;
     {
-        if (error)
-            __android_log_print(ANDROID_LOG_ERROR, "Atomic", message.CString());
+        MutexLock lock(logMutex_);
+        messages.Swap(threadMessages_);
     }
-    else
-        __android_log_print(error ? ANDROID_LOG_ERROR : ANDROID_LOG_INFO, "Atomic", message.CString());
-#elif defined(IOS)
-    SDL_IOS_LogMessage(message.CString());
-#else
-    if (logInstance->quiet_)
+
+    for (List<StoredLogMessage>::ConstIterator i = messages.Begin(); i != messages.End(); ++i)
     {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (error)
-            PrintUnicode(message, true);
+        lastMessage_ = i->message_;
+        SendMessageEvent(*i);
     }
-    else
-        PrintUnicode(message, error);
-#endif
+}
 
-    if (logInstance->logFile_)
+void Log::QueueMessage(const StoredLogMessage& message)
+{
     {
-        logInstance->logFile_->Write(message.CString(), message.Length());
-        logInstance->logFile_->Flush();
+        MutexLock lock(queueMutex_);
+        queuedMessages_.Push(message);
     }
 
-    logInstance->inWrite_ = true;
+    // Write errors before returning so that they reach the log file even if the application crashes right after
+    bool isError = message.level_ == LOG_ERROR || (message.level_ == LOG_RAW && message.error_);
+    if (isError || (!writerThread_ && Thread::IsMainThread()))
+        ProcessQueuedMessages();
+    // Wake up the writer thread. Also done after writing an error, which remains queued if it was logged during a write
+    if (writerThread_)
+        messagesQueued_.Release();
+}
 
-    using namespace LogMessage;
+bool Log::ProcessQueuedMessages()
+{
+    MutexLock fileLock(fileMutex_);
 
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = message;
-    eventData[P_LEVEL] = error ? LOG_ERROR : LOG_INFO;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+    // Writing the log file may log an error, which is queued and written on the next call
+    if (writingMessages_)
+        return false;
 
-    logInstance->inWrite_ = false;
-}
+    {
+        MutexLock lock(queueMutex_);
+        writeMessages_.Swap(queuedMessages_);
+    }
 
-void Log::HandleEndFrame(StringHash eventType, VariantMap& eventData)
-{
-    // If the MainThreadID is not valid, processing this loop can potentially be endless
-    if (!Thread::IsMainThread())
+    // Flush when the interval has elapsed even if no more messages arrive
+    if (writeMessages_.Empty())
     {
-        if (!threadErrorDisplayed)
+        if (unflushed_ && flushTimer_.GetMSec(false) >= flushInterval_)
         {
-            fprintf(stderr, "Thread::mainThreadID is not setup correctly! Threaded log handling disabled\n");
-            threadErrorDisplayed = true;
+            logFile_->Flush();
+            unflushed_ = false;
+            flushTimer_.Reset();
         }
-        return;
+        return false;
     }
 
-    MutexLock lock(logMutex_);
+    writingMessages_ = true;
+
+    bool hasError = false;
+    fileBuffer_.Clear();
 
-    // Process messages accumulated from other threads (if any)
-    while (!threadMessages_.Empty())
+    for (unsigned i = 0; i < writeMessages_.Size(); ++i)
     {
-        const StoredLogMessage& stored = threadMessages_.Front();
+        const StoredLogMessage& message = writeMessages_[i];
+        PrintMessage(message);
 
-        if (stored.level_ != LOG_RAW)
-            Write(stored.level_, stored.message_);
+        if (message.level_ == LOG_ERROR || (message.level_ == LOG_RAW && message.error_))
+            hasError = true;
+
+        if (!logFile_)
+            continue;
+
+        if (fileBinary_)
+        {
+            fileBuffer_.WriteByte((signed char)message.level_);
+            fileBuffer_.WriteBool(message.error_);
+            fileBuffer_.WriteUInt(message.time_);
+            fileBuffer_.WriteString(message.message_);
+        }
+        else if (message.level_ == LOG_RAW)
+            fileBuffer_.Write(message.message_.CString(), message.message_.Length());
         else
-            WriteRaw(stored.message_, stored.error_);
+            fileBuffer_.WriteLine(FormatLogMessage(message, timeStamp_));
+    }
 
-        threadMessages_.PopFront();
+    if (logFile_ && fileBuffer_.GetSize())
+    {
+        logFile_->Write(fileBuffer_.GetData(), fileBuffer_.GetSize());
+        unflushed_ = true;
+
+        if (hasError || flushTimer_.GetMSec(false) >= flushInterval_)
+        {
+            logFile_->Flush();
+            unflushed_ = false;
+            flushTimer_.Reset();
+        }
+    }
+
+    writeMessages_.Clear();
+    writingMessages_ = false;
+    return true;
+}
+
+void Log::PrintMessage(const StoredLogMessage& message)
+{
+    if (message.level_ != LOG_RAW)
+    {
+#if defined(ANDROID)
+        int androidLevel = ANDROID_LOG_DEBUG + message.level_;
+        __android_log_print(androidLevel, "Atomic", "%s", message.message_.CString());
+#elif defined(IOS)
+        SDL_IOS_LogMessage(message.message_.CString());
+#else
+        if (quiet_)
+        {
+            // If in quiet mode, still print the error message to the standard error stream
+            if (message.level_ == LOG_ERROR)
+                PrintUnicodeLine(FormatLogMessage(message, timeStamp_), true);
+        }
+        else
+            PrintUnicodeLine(FormatLogMessage(message, timeStamp_), message.level_ == LOG_ERROR);
+#endif
+    }
+    else
+    {
+#if defined(ANDROID)
+        if (quiet_)
+        {
+            if (message.error_)
+                __android_log_print(ANDROID_LOG_ERROR, "Atomic", message.message_.CString());
+        }
+        else
+            __android_log_print(message.error_ ? ANDROID_LOG_ERROR : ANDROID_LOG_INFO, "Atomic", message.message_.CString());
+#elif defined(IOS)
+        SDL_IOS_LogMessage(message.message_.CString());
+#else
+        if (quiet_)
+        {
+            // If in quiet mode, still print the error message to the standard error stream
+            if (message.error_)
+                PrintUnicode(message.message_, true);
+        }
+        else
+            PrintUnicode(message.message_, message.error_);
+#endif
     }
 }
 
+void Log::SendMessageEvent(const StoredLogMessage& message)
+{
+    // Skip formatting the message if nobody is listening
+    if (inWrite_ || !HasEventReceivers(E_LOGMESSAGE))
+        return;
+
+    inWrite_ = true;
+
+    using namespace LogMessage;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_MESSAGE] = FormatLogMessage(message, timeStamp_);
+    if (message.level_ != LOG_RAW)
+        eventData[P_LEVEL] = message.level_;
+    else
+        eventData[P_LEVEL] = message.error_ ? LOG_ERROR : LOG_INFO;
+    SendEvent(E_LOGMESSAGE, eventData);
+
+    inWrite_ = false;
+}
+
 }
@@ -25,7 +25,10 @@
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
+#include "../Core/Semaphore.h"
 #include "../Core/StringUtils.h"
+#include "../Core/Timer.h"
+#include "../IO/VectorBuffer.h"
 
 namespace Atomic
 {
@@ -43,9 +46,11 @@ static const int LOG_ERROR = 3;
 /// Disable all log messages.
 static const int LOG_NONE = 4;
 
+class Deserializer;
 class File;
+class LogWriterThread;
 
-/// Stored log message from another thread.
+/// Stored log message waiting to be written or sent as an event.
 struct StoredLogMessage
 {
     /// Construct undefined.
@@ -54,10 +59,11 @@ struct StoredLogMessage
     }
 
     /// Construct with parameters.
-    StoredLogMessage(const String& message, int level, bool error) :
+    StoredLogMessage(const String& message, int level, bool error, unsigned time = 0) :
         message_(message),
         level_(level),
-        error_(error)
+        error_(error),
+        time_(time)
     {
     }
 
@@ -67,6 +73,8 @@ struct StoredLogMessage
     int level_;
     /// Error flag for raw messages.
     bool error_;
+    /// Time the message was logged as seconds since 1.1.1970.
+    unsigned time_;
 };
 
 /// Logging subsystem.
@@ -74,6 +82,8 @@ class ATOMIC_API Log : public Object
 {
     OBJECT(Log);
 
+    friend class LogWriterThread;
+
 public:
     /// Construct.
     Log(Context* context);
@@ -90,6 +100,10 @@ public:
     void SetTimeStamp(bool enable);
     /// Set quiet mode ie. only print error entries to standard error stream (which is normally redirected to console also). Output to log file is not affected by this mode.
     void SetQuiet(bool quiet);
+    /// Set minimum interval in milliseconds between log file flushes. Zero flushes after every batch of written messages. Errors are always flushed immediately.
+    void SetFlushInterval(unsigned mSec);
+    /// Set whether to write the log file in the binary structured format instead of text. Takes effect when the next log file is opened.
+    void SetBinaryFormat(bool enable);
 
     /// Return logging level.
     int GetLevel() const { return level_; }
@@ -103,43 +117,89 @@ public:
     /// Return whether log is in quiet mode (only errors printed to standard error stream).
     bool IsQuiet() const { return quiet_; }
 
+    /// Return log file flush interval in milliseconds.
+    unsigned GetFlushInterval() const { return flushInterval_; }
+
+    /// Return whether the log file is written in the binary structured format.
+    bool GetBinaryFormat() const { return binaryFormat_; }
+
     /// Write to the log. If logging level is higher than the level of the message, the message is ignored.
     static void Write(int level, const String& message);
     /// Write raw output to the log.
     static void WriteRaw(const String& message, bool error = false);
+    /// Return whether a message of the given level would be logged. Used to skip formatting filtered messages.
+    static bool IsLevelEnabled(int level);
+    /// Format a stored message as a text log line, optionally with a timestamp.
+    static String FormatLogMessage(const StoredLogMessage& message, bool timeStamp);
+    /// Read all messages from a binary structured log. Return false if the data is not a binary log.
+    static bool ReadBinaryLog(Deserializer& source, Vector<StoredLogMessage>& messages);
 
 private:
-    /// Handle end of frame. Process the threaded log messages.
+    /// Handle end of frame. Send the log message events of other threads and write their messages if there is no writer thread.
     void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Queue a message for output. Errors are written immediately by the logging thread, other messages immediately on the main thread if there is no writer thread.
+    void QueueMessage(const StoredLogMessage& message);
+    /// Write the queued messages to the console and the log file. Return true if any messages were written.
+    bool ProcessQueuedMessages();
+    /// Print a message to the console or the platform log.
+    void PrintMessage(const StoredLogMessage& message);
+    /// Send the log message event.
+    void SendMessageEvent(const StoredLogMessage& message);
 
     /// Mutex for threaded operation.
     Mutex logMutex_;
-    /// Log messages from other threads.
+    /// Log messages from other threads waiting to be sent as events.
     List<StoredLogMessage> threadMessages_;
+    /// Mutex for the output queue.
+    Mutex queueMutex_;
+    /// Messages waiting to be written.
+    Vector<StoredLogMessage> queuedMessages_;
+    /// Messages being written. Swapped with the queue so that producers are not blocked by the writes.
+    Vector<StoredLogMessage> writeMessages_;
+    /// Wakes up the writer thread when messages are queued or when it should stop.
+    Semaphore messagesQueued_;
+    /// Mutex for the log file and the write buffer.
+    Mutex fileMutex_;
     /// Log file.
     SharedPtr<File> logFile_;
+    /// Buffer for writing a batch of messages to the log file at once.
+    VectorBuffer fileBuffer_;
+    /// Timer for the log file flush interval.
+    Timer flushTimer_;
+    /// Writer thread.
+    LogWriterThread* writerThread_;
     /// Last log message.
     String lastMessage_;
     /// Logging level.
     int level_;
+    /// Log file flush interval in milliseconds.
+    unsigned flushInterval_;
     /// Timestamp log messages flag.
     bool timeStamp_;
     /// In write flag to prevent recursion.
     bool inWrite_;
+    /// Writing queued messages flag to prevent recursion.
+    bool writingMessages_;
+    /// Log file has data which has not been flushed.
+    bool unflushed_;
+    /// Binary structured log file flag.
+    bool binaryFormat_;
+    /// Binary format of the currently open log file.
+    bool fileBinary_;
     /// Quiet mode flag.
     bool quiet_;
 };
 
 #ifdef ATOMIC_LOGGING
-#define LOGDEBUG(message) Atomic::Log::Write(Atomic::LOG_DEBUG, message)
-#define LOGINFO(message) Atomic::Log::Write(Atomic::LOG_INFO, message)
-#define LOGWARNING(message) Atomic::Log::Write(Atomic::LOG_WARNING, message)
-#define LOGERROR(message) Atomic::Log::Write(Atomic::LOG_ERROR, message)
+#define LOGDEBUG(message) (Atomic::Log::IsLevelEnabled(Atomic::LOG_DEBUG) ? Atomic::Log::Write(Atomic::LOG_DEBUG, message) : (void)0)
+#define LOGINFO(message) (Atomic::Log::IsLevelEnabled(Atomic::LOG_INFO) ? Atomic::Log::Write(Atomic::LOG_INFO, message) : (void)0)
+#define LOGWARNING(message) (Atomic::Log::IsLevelEnabled(Atomic::LOG_WARNING) ? Atomic::Log::Write(Atomic::LOG_WARNING, message) : (void)0)
+#define LOGERROR(message) (Atomic::Log::IsLevelEnabled(Atomic::LOG_ERROR) ? Atomic::Log::Write(Atomic::LOG_ERROR, message) : (void)0)
 #define LOGRAW(message) Atomic::Log::WriteRaw(message)
-#define LOGDEBUGF(format, ...) Atomic::Log::Write(Atomic::LOG_DEBUG, Atomic::ToString(format, ##__VA_ARGS__))
-#define LOGINFOF(format, ...) Atomic::Log::Write(Atomic::LOG_INFO, Atomic::ToString(format, ##__VA_ARGS__))
-#define LOGWARNINGF(format, ...) Atomic::Log::Write(Atomic::LOG_WARNING, Atomic::ToString(format, ##__VA_ARGS__))
-#define LOGERRORF(format, ...) Atomic::Log::Write(Atomic::LOG_ERROR, Atomic::ToString(format, ##__VA_ARGS__))
+#define LOGDEBUGF(format, ...) (Atomic::Log::IsLevelEnabled(Atomic::LOG_DEBUG) ? Atomic::Log::Write(Atomic::LOG_DEBUG, Atomic::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define LOGINFOF(format, ...) (Atomic::Log::IsLevelEnabled(Atomic::LOG_INFO) ? Atomic::Log::Write(Atomic::LOG_INFO, Atomic::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define LOGWARNINGF(format, ...) (Atomic::Log::IsLevelEnabled(Atomic::LOG_WARNING) ? Atomic::Log::Write(Atomic::LOG_WARNING, Atomic::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define LOGERRORF(format, ...) (Atomic::Log::IsLevelEnabled(Atomic::LOG_ERROR) ? Atomic::Log::Write(Atomic::LOG_ERROR, Atomic::ToString(format, ##__VA_ARGS__)) : (void)0)
 #define LOGRAWF(format, ...) Atomic::Log::WriteRaw(Atomic::ToString(format, ##__VA_ARGS__))
 #else
 #define LOGDEBUG(message) ((void)0)
@@ -37,7 +37,8 @@ namespace Atomic
 {
 
 IPC::IPC(Context* context) : Object(context),
-    workerChannelID_(0)
+    workerChannelID_(0),
+    sharedMemorySize_(0)
 {
     SubscribeToEvent(E_UPDATE, HANDLER(IPC, HandleUpdate));
 }
@@ -55,7 +56,7 @@ IPC::~IPC()
     worker_ = 0;
 }
 
-bool IPC::InitWorker(unsigned id, IPCHandle fd1, IPCHandle fd2)
+bool IPC::InitWorker(unsigned id, IPCHandle fd1, IPCHandle fd2, IPCHandle sharedMemory)
 {
     workerChannelID_ = id;
 
@@ -63,6 +64,13 @@ bool IPC::InitWorker(unsigned id, IPCHandle fd1, IPCHandle fd2)
     // close server fd
     close(fd1);
 	worker_ = new IPCWorker(context_, fd2, id);
+
+    if (sharedMemory != INVALID_IPCHANDLE_VALUE && !worker_->OpenSharedMemory(sharedMemory))
+    {
+        LOGERRORF("Unable to open IPC shared memory fd = %i", sharedMemory);
+        worker_ = 0;
+        return false;
+    }
 #else
 	worker_ = new IPCWorker(context_, fd1, fd2, id);
 #endif
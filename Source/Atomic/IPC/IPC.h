@@ -55,12 +55,18 @@ public:
     // queues an event from a worker or broker receiving thread
     void QueueEvent(unsigned id, StringHash eventType, VariantMap& eventData);
 
-    // for a child worker process
-    bool InitWorker(unsigned id, IPCHandle fd1, IPCHandle fd2);
+    // for a child worker process, sharedMemory is given when the broker enabled shared memory
+    bool InitWorker(unsigned id, IPCHandle fd1, IPCHandle fd2, IPCHandle sharedMemory = INVALID_IPCHANDLE_VALUE);
 
     // spawn a worker process
     IPCBroker* SpawnWorker(const String& command, const Vector<String>& args, const String& initialDirectory = "");
 
+    // set ring size in bytes for each direction of shared memory between brokers and workers spawned afterwards,
+    // zero sends messages through the pipe (default). Large payloads avoid the pipe's copies and syscalls.
+    // Not supported on Windows
+    void SetSharedMemorySize(unsigned size) { sharedMemorySize_ = size; }
+    unsigned GetSharedMemorySize() const { return sharedMemorySize_; }
+
     // worker -> broker
     void SendEventToBroker(StringHash eventType);
     void SendEventToBroker(StringHash eventType, VariantMap& eventData);
@@ -70,6 +76,9 @@ private:
     // if non-zero we're a worked and this is out broker's channel id
     unsigned workerChannelID_;
 
+    // shared memory ring size for spawned workers, zero for the pipe
+    unsigned sharedMemorySize_;
+
     // processes queued events
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
 
@@ -93,6 +93,14 @@ bool IPCBroker::SpawnWorker(const String& command, const Vector<String>& args, c
 #else
     otherProcess_ = new IPCProcess(context_, pp_.fd1(), pp_.fd2());
     transport_.OpenServer(pp_.fd1());
+
+    // messages go through shared memory when enabled, the pipe then only wakes a waiting receiver
+    unsigned sharedMemorySize = ipc_.NotNull() ? ipc_->GetSharedMemorySize() : 0;
+    if (sharedMemorySize && sharedMemory_.Create(sharedMemorySize))
+    {
+        otherProcess_->SetInheritedFD(sharedMemory_.GetFD());
+        SetSharedRings(&sharedMemory_.GetBrokerRing(), &sharedMemory_.GetWorkerRing());
+    }
 #endif
 
     // copy args
@@ -121,6 +129,9 @@ bool IPCBroker::SpawnWorker(const String& command, const Vector<String>& args, c
 #else
     pargs.Push(ToString("--ipc-server=%i", pp_.fd1()));
     pargs.Push(ToString("--ipc-client=%i", pp_.fd2()));
+
+    if (sharedMemory_.GetFD() != -1)
+        pargs.Push(ToString("--ipc-shm=%i", sharedMemory_.GetFD()));
 #endif
 
     pargs.Push(ToString("--ipc-id=%i", id_));
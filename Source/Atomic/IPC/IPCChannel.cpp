@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
 
 #include "IPCChannel.h"
@@ -29,6 +30,10 @@ namespace Atomic
 
 IPCChannel::IPCChannel(Context* context, unsigned id) : Object(context),
     id_(id)
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    , sendRing_(0),
+    receiveRing_(0)
+#endif
 {
     ipc_ = GetSubsystem<IPC>();
     currentHeader_.messageType_ = IPC_MESSAGE_UNDEFINED;
@@ -42,11 +47,36 @@ IPCChannel::~IPCChannel()
 void IPCChannel::PostMessage(StringHash eventType, VariantMap &eventData)
 {
     IPCMessageEvent msgEvent;
-    msgEvent.DoSend(transport_, id_, eventType, eventData);
+
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    if (sendRing_)
+    {
+        msgEvent.DoWrite(sendBuffer_, id_, eventType, eventData);
+        WriteShared(sendBuffer_.GetData(), sendBuffer_.GetSize());
+        return;
+    }
+#endif
+
+    msgEvent.DoSend(transport_, sendBuffer_, id_, eventType, eventData);
+}
+
+void IPCChannel::QueueMessage(MemoryBuffer& buffer)
+{
+    IPCMessageEvent event;
+    StringHash eventType;
+    VariantMap eventData;
+    unsigned id;
+    event.DoRead(buffer, id, eventType, eventData);
+    ipc_->QueueEvent(id, eventType, eventData);
 }
 
 bool IPCChannel::Receive()
 {
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    if (receiveRing_)
+        return ReceiveShared();
+#endif
+
     size_t sz = 0;
     const char* data = transport_.Receive(&sz);
 
@@ -82,12 +112,7 @@ bool IPCChannel::Receive()
             dataBuffer_.Seek( dataBuffer_.GetPosition() + currentHeader_.messageSize_);
             currentHeader_.messageType_ = IPC_MESSAGE_UNDEFINED;
 
-            IPCMessageEvent event;
-            StringHash eventType;
-            VariantMap eventData;
-            unsigned id;
-            event.DoRead(buffer, id, eventType, eventData);
-            ipc_->QueueEvent(id, eventType, eventData);
+            QueueMessage(buffer);
         }
 
         if (dataBuffer_.IsEof())
@@ -108,5 +133,107 @@ bool IPCChannel::Receive()
 
 }
 
+#ifndef ATOMIC_PLATFORM_WINDOWS
+
+void IPCChannel::SetSharedRings(IPCSharedRing* sendRing, IPCSharedRing* receiveRing)
+{
+    sendRing_ = sendRing;
+    receiveRing_ = receiveRing;
+}
+
+void IPCChannel::WriteShared(const unsigned char* data, unsigned size)
+{
+    // messages larger than the free space are streamed as the receiver consumes the ring
+    while (size)
+    {
+        unsigned written = sendRing_->Write(data, size);
+        data += written;
+        size -= written;
+
+        if (written && sendRing_->IsReaderWaiting())
+        {
+            char signal = 0;
+            transport_.Write(&signal, 1);
+        }
+
+        if (size)
+        {
+            if (otherProcess_.Null() || !otherProcess_->IsRunning())
+                return;
+
+            Time::Sleep(1);
+        }
+    }
+}
+
+bool IPCChannel::ReceiveShared()
+{
+    if (!receiveRing_->GetReadable())
+    {
+        receiveRing_->SetReaderWaiting(true);
+
+        // check again once flagged, a sender either wrote before this or sees the flag and signals
+        if (!receiveRing_->GetReadable())
+        {
+            // times out, so the thread can check whether to keep running
+            size_t sz = 0;
+            if (!transport_.Receive(&sz))
+            {
+                receiveRing_->SetReaderWaiting(false);
+                return false;
+            }
+        }
+
+        receiveRing_->SetReaderWaiting(false);
+        return true;
+    }
+
+    while (true)
+    {
+        if (currentHeader_.messageType_ == IPC_MESSAGE_UNDEFINED)
+        {
+            if (receiveRing_->GetReadable() < sizeof(IPCMessageHeader))
+                return true;
+
+            receiveRing_->Read(&currentHeader_, sizeof(IPCMessageHeader));
+        }
+
+        unsigned messageSize = currentHeader_.messageSize_;
+        unsigned readable = receiveRing_->GetReadable();
+
+        if (dataBuffer_.GetSize() == 0 && readable >= messageSize && receiveRing_->GetContiguous() >= messageSize)
+        {
+            // the message is read in place from the ring
+            MemoryBuffer buffer(receiveRing_->GetReadData(), messageSize);
+            QueueMessage(buffer);
+            receiveRing_->Consume(messageSize);
+        }
+        else
+        {
+            // messages wrapping around the end of the ring or larger than it are assembled in the data buffer
+            unsigned received = dataBuffer_.GetSize();
+            unsigned count = messageSize - received;
+            if (count > readable)
+                count = readable;
+
+            if (!count)
+                return true;
+
+            dataBuffer_.Resize(received + count);
+            receiveRing_->Read(dataBuffer_.GetModifiableData() + received, count);
+
+            if (dataBuffer_.GetSize() < messageSize)
+                continue;
+
+            MemoryBuffer buffer(dataBuffer_.GetData(), messageSize);
+            QueueMessage(buffer);
+            dataBuffer_.Clear();
+        }
+
+        currentHeader_.messageType_ = IPC_MESSAGE_UNDEFINED;
+    }
+}
+
+#endif
 
 }
@@ -30,6 +30,7 @@
 #include "IPC.h"
 #include "IPCMessage.h"
 #include "IPCUnix.h"
+#include "IPCSharedMemory.h"
 
 #ifdef ATOMIC_PLATFORM_WINDOWS
 
@@ -58,8 +59,18 @@ public:
 
     void PostMessage(StringHash eventType, VariantMap& eventData);
 
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    /// Return whether messages go through shared memory rings instead of the pipe.
+    bool IsSharedMemory() const { return sendRing_ != 0; }
+#endif
+
 protected:
 
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    /// Send and receive messages through shared memory rings. The pipe then only wakes a receiving thread waiting for data. Call before the thread is started.
+    void SetSharedRings(IPCSharedRing* sendRing, IPCSharedRing* receiveRing);
+#endif
+
     unsigned id_;
 
     // for access from thread
@@ -73,6 +84,28 @@ protected:
     IPCMessageHeader currentHeader_;
     VectorBuffer dataBuffer_;
 
+    // reused for serializing posted messages
+    VectorBuffer sendBuffer_;
+
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    // created by the broker and inherited by the worker process
+    IPCSharedMemory sharedMemory_;
+    IPCSharedRing* sendRing_;
+    IPCSharedRing* receiveRing_;
+#endif
+
+private:
+
+    // read a received message and queue its event for the main thread
+    void QueueMessage(MemoryBuffer& buffer);
+
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    // write to the send ring, waiting for space when full
+    void WriteShared(const unsigned char* data, unsigned size);
+    // receive messages from the receive ring, waiting on the pipe while it is empty
+    bool ReceiveShared();
+#endif
+
 };
 
 }
@@ -58,21 +58,29 @@ public:
         return true;
     }
 
-    bool DoSend(PipeTransport& transport, unsigned id, const StringHash& eventType, const VariantMap& eventData)
+    /// Write the message header and event to a buffer, which is cleared first so it can be reused between messages.
+    void DoWrite(VectorBuffer& buffer, unsigned id, const StringHash& eventType, const VariantMap& eventData)
     {
-        VectorBuffer buffer;
+        IPCMessageHeader header;
+        header.messageType_ = IPC_MESSAGE_EVENT;
+        header.messageSize_ = 0;
+
+        buffer.Clear();
+        buffer.Write(&header, sizeof(IPCMessageHeader));
         buffer.WriteUInt(id);
         buffer.WriteStringHash(eventType);
         buffer.WriteVariantMap(eventData);
 
-        IPCMessageHeader header;
-        header.messageType_ = IPC_MESSAGE_EVENT;
-        header.messageSize_ = buffer.GetSize();
+        header.messageSize_ = buffer.GetSize() - sizeof(IPCMessageHeader);
+        memcpy(buffer.GetModifiableData(), &header, sizeof(IPCMessageHeader));
+    }
 
-        transport.Write(&header, sizeof(IPCMessageHeader));
-        transport.Write(buffer.GetData(), header.messageSize_);
+    bool DoSend(PipeTransport& transport, VectorBuffer& buffer, unsigned id, const StringHash& eventType, const VariantMap& eventData)
+    {
+        DoWrite(buffer, id, eventType, eventData);
 
-        return true;
+        // header and event in a single write
+        return transport.Write(buffer.GetData(), buffer.GetSize());
     }
 };
 
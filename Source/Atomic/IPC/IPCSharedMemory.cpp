@@ -0,0 +1,275 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef ATOMIC_PLATFORM_WINDOWS
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../Core/StringUtils.h"
+#include "../IO/Log.h"
+#include "../Math/MathDefs.h"
+
+#include "IPCSharedMemory.h"
+
+// full barrier between the ring data and position accesses of the two processes
+#define IPC_MEMORY_BARRIER() __sync_synchronize()
+
+namespace Atomic
+{
+
+static const unsigned IPC_SHAREDMEMORY_ID = 0x4d534941; // "AISM"
+
+/// Header at the start of the mapping, followed by the ring headers and the ring data.
+struct IPCSharedMemoryHeader
+{
+    /// Identifier.
+    unsigned id_;
+    /// Capacity of each ring.
+    unsigned ringCapacity_;
+    unsigned pad_[14];
+};
+
+IPCSharedRing::IPCSharedRing() :
+    header_(0),
+    data_(0),
+    capacity_(0)
+{
+}
+
+void IPCSharedRing::Attach(IPCRingHeader* header, unsigned char* data, unsigned capacity)
+{
+    header_ = header;
+    data_ = data;
+    capacity_ = capacity;
+}
+
+unsigned IPCSharedRing::Write(const void* data, unsigned size)
+{
+    unsigned writePos = header_->writePos_;
+    unsigned space = capacity_ - (writePos - header_->readPos_);
+    // the consumer is done with the space it released before the bytes are overwritten
+    IPC_MEMORY_BARRIER();
+
+    unsigned count = size < space ? size : space;
+    if (!count)
+        return 0;
+
+    unsigned offset = writePos & (capacity_ - 1);
+    unsigned first = count < capacity_ - offset ? count : capacity_ - offset;
+
+    memcpy(data_ + offset, data, first);
+    if (first < count)
+        memcpy(data_, (const unsigned char*) data + first, count - first);
+
+    IPC_MEMORY_BARRIER();
+    header_->writePos_ = writePos + count;
+
+    return count;
+}
+
+bool IPCSharedRing::IsReaderWaiting() const
+{
+    // pairs with the barrier in SetReaderWaiting, so either the consumer sees the write or the producer sees it waiting
+    IPC_MEMORY_BARRIER();
+    return header_->readerWaiting_ != 0;
+}
+
+unsigned IPCSharedRing::GetReadable() const
+{
+    unsigned readable = header_->writePos_ - header_->readPos_;
+    IPC_MEMORY_BARRIER();
+    return readable;
+}
+
+unsigned IPCSharedRing::GetContiguous() const
+{
+    return capacity_ - (header_->readPos_ & (capacity_ - 1));
+}
+
+const unsigned char* IPCSharedRing::GetReadData() const
+{
+    return data_ + (header_->readPos_ & (capacity_ - 1));
+}
+
+void IPCSharedRing::Read(void* dest, unsigned size)
+{
+    unsigned contiguous = GetContiguous();
+    unsigned first = size < contiguous ? size : contiguous;
+
+    memcpy(dest, GetReadData(), first);
+    if (first < size)
+        memcpy((unsigned char*) dest + first, data_, size - first);
+
+    Consume(size);
+}
+
+void IPCSharedRing::Consume(unsigned size)
+{
+    IPC_MEMORY_BARRIER();
+    header_->readPos_ += size;
+}
+
+void IPCSharedRing::SetReaderWaiting(bool waiting)
+{
+    header_->readerWaiting_ = waiting ? 1 : 0;
+    IPC_MEMORY_BARRIER();
+}
+
+IPCSharedMemory::IPCSharedMemory() :
+    fd_(-1),
+    memory_(0),
+    size_(0)
+{
+}
+
+IPCSharedMemory::~IPCSharedMemory()
+{
+    Close();
+}
+
+bool IPCSharedMemory::Create(unsigned ringCapacity)
+{
+    Close();
+
+    ringCapacity = NextPowerOfTwo(ringCapacity < 4096 ? 4096 : ringCapacity);
+
+    // the name is unlinked right away, the memory lives as long as the descriptor or a mapping
+    String name = ToString("/atomic-ipc-%u-%u", (unsigned) getpid(), ringCapacity);
+    for (unsigned i = 0; fd_ < 0 && i < 16; ++i)
+    {
+        String uniqueName = name + ToString("-%u", i);
+        fd_ = shm_open(uniqueName.CString(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd_ >= 0)
+            shm_unlink(uniqueName.CString());
+    }
+
+    if (fd_ < 0)
+    {
+        LOGERROR("Unable to create IPC shared memory");
+        return false;
+    }
+
+    // shm_open descriptors are closed on exec, the worker process needs to inherit it
+    fcntl(fd_, F_SETFD, fcntl(fd_, F_GETFD) & ~FD_CLOEXEC);
+
+    size_ = sizeof(IPCSharedMemoryHeader) + 2 * sizeof(IPCRingHeader) + 2 * ringCapacity;
+
+    if (ftruncate(fd_, size_) != 0)
+    {
+        LOGERROR("Unable to size IPC shared memory");
+        Close();
+        return false;
+    }
+
+    memory_ = mmap(0, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory_ == MAP_FAILED)
+    {
+        memory_ = 0;
+        LOGERROR("Unable to map IPC shared memory");
+        Close();
+        return false;
+    }
+
+    // ftruncate zero fills, so only the header needs to be written
+    IPCSharedMemoryHeader* header = (IPCSharedMemoryHeader*) memory_;
+    header->id_ = IPC_SHAREDMEMORY_ID;
+    header->ringCapacity_ = ringCapacity;
+
+    return AttachRings();
+}
+
+bool IPCSharedMemory::Open(int fd)
+{
+    Close();
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(IPCSharedMemoryHeader))
+    {
+        LOGERRORF("Invalid IPC shared memory fd = %i", fd);
+        close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    size_ = (unsigned) info.st_size;
+
+    memory_ = mmap(0, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory_ == MAP_FAILED)
+    {
+        memory_ = 0;
+        LOGERROR("Unable to map IPC shared memory");
+        Close();
+        return false;
+    }
+
+    return AttachRings();
+}
+
+void IPCSharedMemory::Close()
+{
+    brokerRing_.Attach(0, 0, 0);
+    workerRing_.Attach(0, 0, 0);
+
+    if (memory_)
+    {
+        munmap(memory_, size_);
+        memory_ = 0;
+    }
+
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+
+    size_ = 0;
+}
+
+bool IPCSharedMemory::AttachRings()
+{
+    IPCSharedMemoryHeader* header = (IPCSharedMemoryHeader*) memory_;
+    unsigned ringCapacity = header->ringCapacity_;
+
+    if (header->id_ != IPC_SHAREDMEMORY_ID || !IsPowerOfTwo(ringCapacity) ||
+        size_ != sizeof(IPCSharedMemoryHeader) + 2 * sizeof(IPCRingHeader) + 2 * ringCapacity)
+    {
+        LOGERROR("Invalid IPC shared memory layout");
+        Close();
+        return false;
+    }
+
+    IPCRingHeader* ringHeaders = (IPCRingHeader*) (header + 1);
+    unsigned char* ringData = (unsigned char*) (ringHeaders + 2);
+
+    brokerRing_.Attach(&ringHeaders[0], ringData, ringCapacity);
+    workerRing_.Attach(&ringHeaders[1], ringData + ringCapacity, ringCapacity);
+
+    return true;
+}
+
+}
+
+#endif
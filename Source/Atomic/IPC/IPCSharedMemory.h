@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef ATOMIC_PLATFORM_WINDOWS
+
+#pragma once
+
+#include "../Container/Str.h"
+
+namespace Atomic
+{
+
+/// Shared header of a ring. The positions count bytes and wrap at 2^32, and are kept on separate cache lines.
+struct IPCRingHeader
+{
+    /// Total bytes written by the producer.
+    volatile unsigned writePos_;
+    unsigned pad0_[15];
+    /// Total bytes consumed by the consumer.
+    volatile unsigned readPos_;
+    /// Nonzero while the consumer is blocked waiting for the producer to signal it.
+    volatile unsigned readerWaiting_;
+    unsigned pad1_[14];
+};
+
+/// Single producer, single consumer byte ring in shared memory.
+class IPCSharedRing
+{
+public:
+    /// Construct unattached.
+    IPCSharedRing();
+
+    /// Attach to a ring header and power of two sized data in a mapping.
+    void Attach(IPCRingHeader* header, unsigned char* data, unsigned capacity);
+
+    /// Write as many bytes as fit. Return number of bytes written.
+    unsigned Write(const void* data, unsigned size);
+    /// Return whether the consumer is waiting to be signalled, after making the written bytes visible to it.
+    bool IsReaderWaiting() const;
+
+    /// Return number of bytes available for reading.
+    unsigned GetReadable() const;
+    /// Return number of bytes that can be read from GetReadData() without wrapping.
+    unsigned GetContiguous() const;
+    /// Return pointer to the next byte to read.
+    const unsigned char* GetReadData() const;
+    /// Copy bytes out and consume them. The bytes must be available.
+    void Read(void* dest, unsigned size);
+    /// Consume bytes, releasing their space to the producer.
+    void Consume(unsigned size);
+    /// Set whether the consumer is waiting to be signalled.
+    void SetReaderWaiting(bool waiting);
+
+    /// Return capacity in bytes.
+    unsigned GetCapacity() const { return capacity_; }
+    /// Return whether attached to a ring.
+    bool IsAttached() const { return header_ != 0; }
+
+private:
+    /// Shared header.
+    IPCRingHeader* header_;
+    /// Shared data.
+    unsigned char* data_;
+    /// Capacity in bytes.
+    unsigned capacity_;
+};
+
+/// Shared memory mapping holding a ring for each direction between a broker and a worker process.
+class IPCSharedMemory
+{
+public:
+    /// Construct.
+    IPCSharedMemory();
+    /// Destruct. Unmap and close the file descriptor.
+    ~IPCSharedMemory();
+
+    /// Create the mapping with the given ring capacity, rounded up to a power of two. The file descriptor is inherited by launched processes.
+    bool Create(unsigned ringCapacity);
+    /// Map memory created by the broker from an inherited file descriptor.
+    bool Open(int fd);
+    /// Unmap and close the file descriptor.
+    void Close();
+
+    /// Return file descriptor, or -1 if not created.
+    int GetFD() const { return fd_; }
+    /// Return the broker to worker ring.
+    IPCSharedRing& GetBrokerRing() { return brokerRing_; }
+    /// Return the worker to broker ring.
+    IPCSharedRing& GetWorkerRing() { return workerRing_; }
+
+private:
+    /// Attach the rings to the mapping.
+    bool AttachRings();
+
+    /// File descriptor.
+    int fd_;
+    /// Mapping.
+    void* memory_;
+    /// Mapping size.
+    unsigned size_;
+    /// Broker to worker ring.
+    IPCSharedRing brokerRing_;
+    /// Worker to broker ring.
+    IPCSharedRing workerRing_;
+};
+
+}
+
+#endif
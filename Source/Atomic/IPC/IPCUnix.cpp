@@ -162,7 +162,8 @@ char* PipeTransport::Receive(size_t* size) {
 IPCProcess::IPCProcess(Context* context, int fd1, int fd2, int pid) : Object(context),
     pid_(pid),
     fd1_(fd1),
-    fd2_(fd2)
+    fd2_(fd2),
+    inheritedFD_(-1)
 {
 }
 
@@ -231,11 +232,11 @@ bool IPCProcess::Launch(const String& command, const Vector<String>& args, const
             }
         }
 
-        // close all open file descriptors other than stdin, stdout, stderr
-        // and the IPC child fd
+        // close all open file descriptors other than stdin, stdout, stderr,
+        // the IPC child fd and the inherited fd
         for (int i = 3; i < getdtablesize(); ++i)
         {
-            if (i != fd2())
+            if (i != fd2() && i != inheritedFD_)
                 close(i);
         }
 
@@ -89,11 +89,15 @@ class IPCProcess : public Object
 
     bool Launch(const String& command, const Vector<String>& args, const String& initialDirectory);
 
+    // an additional descriptor the launched process keeps open, such as IPC shared memory
+    void SetInheritedFD(int fd) { inheritedFD_ = fd; }
+
 private:
 
     int pid_;
     int fd1_;
     int fd2_;
+    int inheritedFD_;
 };
 
 
@@ -82,6 +82,18 @@ IPCWorker::~IPCWorker()
 
 }
 
+#ifndef ATOMIC_PLATFORM_WINDOWS
+bool IPCWorker::OpenSharedMemory(IPCHandle fd)
+{
+    if (!sharedMemory_.Open(fd))
+        return false;
+
+    SetSharedRings(&sharedMemory_.GetWorkerRing(), &sharedMemory_.GetBrokerRing());
+
+    return true;
+}
+#endif
+
 bool IPCWorker::Update()
 {
     if (otherProcess_.Null())
@@ -47,6 +47,11 @@ public:
 
     bool Update();
 
+#ifndef ATOMIC_PLATFORM_WINDOWS
+    /// Map the shared memory created by the broker and use it for messages. Call before running the thread.
+    bool OpenSharedMemory(IPCHandle fd);
+#endif
+
 private:
 
 	// on unix will be the same
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../Navigation/CrowdAgent.h"
@@ -45,12 +46,67 @@ extern const char* NAVIGATION_CATEGORY;
 
 static const unsigned DEFAULT_MAX_AGENTS = 512;
 static const float DEFAULT_MAX_AGENT_RADIUS = 0.f;
+static const int MIN_AGENTS_PER_BATCH = 32;
+
+/// Range of agents for one phase of the crowd update.
+struct CrowdUpdateBatch
+{
+    /// Detour crowd task.
+    dtCrowdTask task_;
+    /// Detour crowd task data.
+    void* taskData_;
+    /// First agent index.
+    int begin_;
+    /// Agent index one past the last.
+    int end_;
+};
 
 void CrowdAgentUpdateCallback(dtCrowdAgent* ag, float dt)
 {
     static_cast<CrowdAgent*>(ag->params.userData)->OnCrowdUpdate(ag, dt);
 }
 
+void CrowdUpdateBatchWork(const WorkItem* item, unsigned threadIndex)
+{
+    const CrowdUpdateBatch* batch = reinterpret_cast<const CrowdUpdateBatch*>(item->start_);
+    batch->task_(batch->taskData_, batch->begin_, batch->end_, threadIndex);
+}
+
+void CrowdParallelForCallback(void* userData, int count, dtCrowdTask task, void* taskData)
+{
+    WorkQueue* queue = static_cast<WorkQueue*>(userData);
+
+    // Small crowds are not worth the synchronization
+    int numBatches = count / MIN_AGENTS_PER_BATCH;
+    if (numBatches > (int)queue->GetNumThreads() + 1)
+        numBatches = (int)queue->GetNumThreads() + 1;
+    if (numBatches <= 1)
+    {
+        task(taskData, 0, count, 0);
+        return;
+    }
+
+    PODVector<CrowdUpdateBatch> batches(numBatches);
+    int agentsPerBatch = (count + numBatches - 1) / numBatches;
+
+    for (int i = 0; i < numBatches; ++i)
+    {
+        CrowdUpdateBatch& batch = batches[i];
+        batch.task_ = task;
+        batch.taskData_ = taskData;
+        batch.begin_ = i * agentsPerBatch;
+        batch.end_ = Min(batch.begin_ + agentsPerBatch, count);
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = CrowdUpdateBatchWork;
+        item->start_ = &batch;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
 CrowdManager::CrowdManager(Context* context) :
     Component(context),
     crowd_(0),
@@ -59,7 +115,8 @@ CrowdManager::CrowdManager(Context* context) :
     maxAgents_(DEFAULT_MAX_AGENTS),
     maxAgentRadius_(DEFAULT_MAX_AGENT_RADIUS),
     numQueryFilterTypes_(0),
-    numObstacleAvoidanceTypes_(0)
+    numObstacleAvoidanceTypes_(0),
+    threadedUpdate_(true)
 {
     // The actual buffer is allocated inside dtCrowd, we only track the number of "slots" being configured explicitly
     numAreas_.Reserve(DT_CROWD_MAX_QUERY_FILTER_TYPE);
@@ -556,6 +613,8 @@ bool CrowdManager::CreateCrowd()
         return false;
     }
 
+    ApplyThreadedUpdate();
+
     if (recreate)
     {
         // Reconfigure the newly initialized crowd
@@ -591,6 +650,31 @@ int CrowdManager::AddAgent(CrowdAgent* agent, const Vector3& pos)
     return crowd_->addAgent(pos.Data(), &params);
 }
 
+void CrowdManager::SetThreadedUpdate(bool enable)
+{
+    threadedUpdate_ = enable;
+    ApplyThreadedUpdate();
+}
+
+void CrowdManager::ApplyThreadedUpdate()
+{
+    if (!crowd_)
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (threadedUpdate_ && queue && queue->GetNumThreads())
+    {
+        // The agent update callback writes to the scene nodes, so the crowd calls it on the main thread after the threaded phases
+        if (!crowd_->setParallelFor(CrowdParallelForCallback, queue, queue->GetNumThreads() + 1))
+        {
+            LOGERROR("Could not initialize DetourCrowd for threaded update");
+            crowd_->setParallelFor(0, 0, 1);
+        }
+    }
+    else
+        crowd_->setParallelFor(0, 0, 1);
+}
+
 void CrowdManager::RemoveAgent(CrowdAgent* agent)
 {
     if (!crowd_ || !agent)
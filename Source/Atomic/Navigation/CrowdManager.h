@@ -101,6 +101,8 @@ public:
     void SetObstacleAvoidanceTypesAttr(const VariantVector& value);
     /// Set the params for the specified obstacle avoidance type.
     void SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, const CrowdObstacleAvoidanceParams& params);
+    /// Set whether to split the crowd update across the work queue threads. Default true.
+    void SetThreadedUpdate(bool enable);
 
     /// Get all the crowd agent components in the specified node hierarchy. If the node is not specified then use scene node. When inCrowdFilter is set to true then only get agents that are in the crowd.
     PODVector<CrowdAgent*> GetAgents(Node* node = 0, bool inCrowdFilter = true) const;
@@ -128,6 +130,9 @@ public:
     /// Get the Navigation mesh assigned to the crowd.
     NavigationMesh* GetNavigationMesh() const { return navigationMesh_; }
 
+    /// Return whether the crowd update is split across the work queue threads.
+    bool GetThreadedUpdate() const { return threadedUpdate_; }
+
     /// Get the number of configured query filter types.
     unsigned GetNumQueryFilterTypes() const { return numQueryFilterTypes_; }
 
@@ -157,6 +162,8 @@ protected:
     int AddAgent(CrowdAgent* agent, const Vector3& pos);
     /// Removes the detour crowd agent.
     void RemoveAgent(CrowdAgent* agent);
+    /// Pass the work queue to the internal Detour crowd object for threaded update, or remove it.
+    void ApplyThreadedUpdate();
 
 protected:
     /// Handle scene being assigned.
@@ -193,6 +200,8 @@ private:
     PODVector<unsigned> numAreas_;
     /// Number of obstacle avoidance types configured in the crowd. Limit to DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS.
     unsigned numObstacleAvoidanceTypes_;
+    /// Threaded update flag.
+    bool threadedUpdate_;
 };
 
 }
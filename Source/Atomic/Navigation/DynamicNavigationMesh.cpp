@@ -25,6 +25,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
@@ -57,12 +58,8 @@ namespace Atomic
 extern const char* NAVIGATION_CATEGORY;
 
 static const int DEFAULT_MAX_OBSTACLES = 1024;
-
-struct DynamicNavigationMesh::TileCacheData
-{
-    unsigned char* data;
-    int dataSize;
-};
+/// Time budget per frame for updating tiles touched by obstacle changes, after the first update.
+static const long long TILE_CACHE_UPDATE_BUDGET_USEC = 1000;
 
 struct TileCompressor : public dtTileCacheCompressor
 {
@@ -341,29 +338,7 @@ bool DynamicNavigationMesh::Build()
         }
 
         // Build each tile
-        unsigned numTiles = 0;
-
-        for (int z = 0; z < numTilesZ_; ++z)
-        {
-            for (int x = 0; x < numTilesX_; ++x)
-            {
-                TileCacheData tiles[TILECACHE_MAXLAYERS];
-                int layerCt = BuildTile(geometryList, x, z, tiles);
-                for (int i = 0; i < layerCt; ++i)
-                {
-                    dtCompressedTileRef tileRef;
-                    int status = tileCache_->addTile(tiles[i].data, tiles[i].dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
-                    if (dtStatusFailed((dtStatus)status))
-                    {
-                        dtFree(tiles[i].data);
-                        tiles[i].data = 0x0;
-                    }
-                }
-                ++numTiles;
-            }
-            for (int x = 0; x < numTilesX_; ++x)
-                tileCache_->buildNavMeshTilesAt(x, z, navMesh_);
-        }
+        unsigned numTiles = BuildTiles(geometryList, 0, 0, numTilesX_ - 1, numTilesZ_ - 1);
 
         // For a full build it's necessary to update the nav mesh
         // not doing so will cause dependent components to crash, like CrowdManager
@@ -407,6 +382,9 @@ bool DynamicNavigationMesh::Build(const BoundingBox& boundingBox)
         return false;
     }
 
+    // Keep the order of rebuilds
+    FinishRebuild(true);
+
     if (!node_->GetWorldScale().Equals(Vector3::ONE))
         LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
 
@@ -422,40 +400,7 @@ bool DynamicNavigationMesh::Build(const BoundingBox& boundingBox)
     int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
     int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
 
-    unsigned numTiles = 0;
-
-    for (int z = sz; z <= ez; ++z)
-    {
-        for (int x = sx; x <= ex; ++x)
-        {
-            dtCompressedTileRef existing[TILECACHE_MAXLAYERS];
-            const int existingCt = tileCache_->getTilesAt(x, z, existing, TILECACHE_MAXLAYERS);
-            for (int i = 0; i < existingCt; ++i)
-            {
-                unsigned char* data = 0x0;
-                if (!dtStatusFailed(tileCache_->removeTile(existing[i], &data, 0)) && data != 0x0)
-                    dtFree(data);
-            }
-
-            TileCacheData tiles[TILECACHE_MAXLAYERS];
-            int layerCt = BuildTile(geometryList, x, z, tiles);
-            for (int i = 0; i < layerCt; ++i)
-            {
-                dtCompressedTileRef tileRef;
-                int status = tileCache_->addTile(tiles[i].data, tiles[i].dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
-                if (dtStatusFailed((dtStatus)status))
-                {
-                    dtFree(tiles[i].data);
-                    tiles[i].data = 0x0;
-                }
-                else
-                {
-                    tileCache_->buildNavMeshTile(tileRef, navMesh_);
-                    ++numTiles;
-                }
-            }
-        }
-    }
+    unsigned numTiles = BuildTiles(geometryList, sx, sz, ex, ez);
 
     LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
     return true;
@@ -661,22 +606,11 @@ PODVector<unsigned char> DynamicNavigationMesh::GetNavigationDataAttr() const
     return ret.GetBuffer();
 }
 
-int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles)
+bool DynamicNavigationMesh::BuildTileData(Vector<NavigationGeometryInfo>& geometryList, NavigationTileData& tile)
 {
     PROFILE(BuildNavigationMeshTile);
 
-    tileCache_->removeTile(navMesh_->getTileRefAt(x, z, 0), 0, 0);
-
-    float tileEdgeLength = (float)tileSize_ * cellSize_;
-
-    BoundingBox tileBoundingBox(Vector3(
-            boundingBox_.min_.x_ + tileEdgeLength * (float)x,
-            boundingBox_.min_.y_,
-            boundingBox_.min_.z_ + tileEdgeLength * (float)z),
-        Vector3(
-            boundingBox_.min_.x_ + tileEdgeLength * (float)(x + 1),
-            boundingBox_.max_.y_,
-            boundingBox_.min_.z_ + tileEdgeLength * (float)(z + 1)));
+    BoundingBox tileBoundingBox = GetTileBoundingBox(tile.x_, tile.z_);
 
     DynamicNavBuildData build(allocator_);
 
@@ -708,23 +642,23 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    GetTileGeometry(&build, geometryList, tile, expandedBox);
 
     if (build.vertices_.Empty() || build.indices_.Empty())
-        return 0; // Nothing to do
+        return true; // Nothing to do
 
     build.heightField_ = rcAllocHeightfield();
     if (!build.heightField_)
     {
         LOGERROR("Could not allocate heightfield");
-        return 0;
+        return false;
     }
 
     if (!rcCreateHeightfield(build.ctx_, *build.heightField_, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs,
         cfg.ch))
     {
         LOGERROR("Could not create heightfield");
-        return 0;
+        return false;
     }
 
     unsigned numTriangles = build.indices_.Size() / 3;
@@ -744,18 +678,18 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
     if (!build.compactHeightField_)
     {
         LOGERROR("Could not allocate create compact heightfield");
-        return 0;
+        return false;
     }
     if (!rcBuildCompactHeightfield(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_,
         *build.compactHeightField_))
     {
         LOGERROR("Could not build compact heightfield");
-        return 0;
+        return false;
     }
     if (!rcErodeWalkableArea(build.ctx_, cfg.walkableRadius, *build.compactHeightField_))
     {
         LOGERROR("Could not erode compact heightfield");
-        return 0;
+        return false;
     }
 
     // area volumes
@@ -768,13 +702,13 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         if (!rcBuildDistanceField(build.ctx_, *build.compactHeightField_))
         {
             LOGERROR("Could not build distance field");
-            return 0;
+            return false;
         }
         if (!rcBuildRegions(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea,
             cfg.mergeRegionArea))
         {
             LOGERROR("Could not build regions");
-            return 0;
+            return false;
         }
     }
     else
@@ -782,7 +716,7 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         if (!rcBuildRegionsMonotone(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
         {
             LOGERROR("Could not build monotone regions");
-            return 0;
+            return false;
         }
     }
 
@@ -790,24 +724,23 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
     if (!build.heightFieldLayers_)
     {
         LOGERROR("Could not allocate height field layer set");
-        return 0;
+        return false;
     }
 
     if (!rcBuildHeightfieldLayers(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.walkableHeight,
         *build.heightFieldLayers_))
     {
         LOGERROR("Could not build height field layers");
-        return 0;
+        return false;
     }
 
-    int retCt = 0;
     for (int i = 0; i < build.heightFieldLayers_->nlayers; ++i)
     {
         dtTileCacheLayerHeader header;
         header.magic = DT_TILECACHE_MAGIC;
         header.version = DT_TILECACHE_VERSION;
-        header.tx = x;
-        header.ty = z;
+        header.tx = tile.x_;
+        header.ty = tile.z_;
         header.tlayer = i;
 
         rcHeightfieldLayer* layer = &build.heightFieldLayers_->layers[i];
@@ -824,19 +757,59 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         header.hmin = (unsigned short)layer->hmin;
         header.hmax = (unsigned short)layer->hmax;
 
+        unsigned char* data = 0;
+        int dataSize = 0;
         if (dtStatusFailed(
             dtBuildTileCacheLayer(compressor_/*compressor*/, &header, layer->heights, layer->areas/*areas*/, layer->cons,
-                &(tiles[retCt].data), &tiles[retCt].dataSize)))
+                &data, &dataSize)))
         {
             LOGERROR("Failed to build tile cache layers");
-            return 0;
+            return false;
+        }
+
+        tile.data_.Push(data);
+        tile.dataSizes_.Push(dataSize);
+    }
+
+    return true;
+}
+
+bool DynamicNavigationMesh::AddTileData(NavigationTileData& tile)
+{
+    // Remove the previous layers of the tile (if any)
+    dtCompressedTileRef existing[TILECACHE_MAXLAYERS];
+    const int existingCt = tileCache_->getTilesAt(tile.x_, tile.z_, existing, TILECACHE_MAXLAYERS);
+    for (int i = 0; i < existingCt; ++i)
+    {
+        unsigned char* data = 0x0;
+        if (!dtStatusFailed(tileCache_->removeTile(existing[i], &data, 0)) && data != 0x0)
+            dtFree(data);
+    }
+
+    bool success = tile.success_;
+    for (unsigned i = 0; i < tile.data_.Size(); ++i)
+    {
+        dtCompressedTileRef tileRef;
+        if (!success)
+            dtFree(tile.data_[i]);
+        else if (dtStatusFailed(tileCache_->addTile(tile.data_[i], tile.dataSizes_[i], DT_COMPRESSEDTILE_FREE_DATA, &tileRef)))
+        {
+            dtFree(tile.data_[i]);
+            success = false;
         }
         else
-            ++retCt;
+            tileCache_->buildNavMeshTile(tileRef, navMesh_);
     }
 
+    bool hasData = !tile.data_.Empty();
+    tile.data_.Clear();
+    tile.dataSizes_.Clear();
+
     // Send a notification of the rebuild of this tile to anyone interested
+    if (success && hasData)
     {
+        BoundingBox tileBoundingBox = GetTileBoundingBox(tile.x_, tile.z_);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -846,7 +819,7 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
 
-    return retCt;
+    return success;
 }
 
 PODVector<OffMeshConnection*> DynamicNavigationMesh::CollectOffMeshConnections(const BoundingBox& bounds)
@@ -875,6 +848,7 @@ void DynamicNavigationMesh::ReleaseNavigationMesh()
 
 void DynamicNavigationMesh::ReleaseTileCache()
 {
+    dirtyObstacles_.Clear();
     dtFreeTileCache(tileCache_);
     tileCache_ = 0;
 }
@@ -926,15 +900,16 @@ void DynamicNavigationMesh::AddObstacle(Obstacle* obstacle, bool silent)
 
 void DynamicNavigationMesh::ObstacleChanged(Obstacle* obstacle)
 {
-    if (tileCache_)
-    {
-        RemoveObstacle(obstacle, true);
-        AddObstacle(obstacle, true);
-    }
+    // Re-add the obstacle only once per frame, however many times it changes. A disabled obstacle is added with its
+    // current size when enabled
+    if (tileCache_ && obstacle->IsEnabledEffective())
+        dirtyObstacles_.Insert(obstacle);
 }
 
 void DynamicNavigationMesh::RemoveObstacle(Obstacle* obstacle, bool silent)
 {
+    dirtyObstacles_.Erase(obstacle);
+
     if (tileCache_ && obstacle->obstacleId_ > 0)
     {
         // Because dtTileCache doesn't process obstacle requests while updating tiles
@@ -968,7 +943,31 @@ void DynamicNavigationMesh::HandleSceneSubsystemUpdate(StringHash eventType, Var
     using namespace SceneSubsystemUpdate;
 
     if (tileCache_ && navMesh_ && IsEnabledEffective())
-        tileCache_->update(eventData[P_TIMESTEP].GetFloat(), navMesh_);
+    {
+        if (dirtyObstacles_.Size())
+        {
+            PODVector<Obstacle*> obstacles;
+            for (HashSet<Obstacle*>::ConstIterator i = dirtyObstacles_.Begin(); i != dirtyObstacles_.End(); ++i)
+                obstacles.Push(*i);
+            dirtyObstacles_.Clear();
+
+            for (unsigned i = 0; i < obstacles.Size(); ++i)
+            {
+                Obstacle* obstacle = obstacles[i];
+                RemoveObstacle(obstacle, true);
+                // Do not add back an obstacle that was disabled or detached from its node after changing
+                if (obstacle->IsEnabledEffective())
+                    AddObstacle(obstacle, true);
+            }
+        }
+
+        // Rebuild tiles touched by the obstacle changes within a time budget, at least one tile per frame
+        float timeStep = eventData[P_TIMESTEP].GetFloat();
+        HiresTimer timer;
+        do
+            tileCache_->update(timeStep, navMesh_);
+        while (!tileCache_->isUpToDate() && timer.GetUSec(false) < TILE_CACHE_UPDATE_BUDGET_USEC);
+    }
 }
 
 }
@@ -81,7 +81,6 @@ public:
     bool GetDrawObstacles() const { return drawObstacles_; }
 
 protected:
-    struct TileCacheData;
 
     /// Subscribe to events when assigned to a scene.
     virtual void OnSceneSet(Scene* scene);
@@ -90,13 +89,15 @@ protected:
 
     /// Used by Obstacle class to add itself to the tile cache, if 'silent' an event will not be raised.
     void AddObstacle(Obstacle* obstacle, bool silent = false);
-    /// Used by Obstacle class to update itself.
+    /// Used by Obstacle class to mark itself changed. The changes of a frame are applied together in the scene subsystem update.
     void ObstacleChanged(Obstacle* obstacle);
     /// Used by Obstacle class to remove itself from the tile cache, if 'silent' an event will not be raised.
     void RemoveObstacle(Obstacle*, bool silent = false);
 
-    /// Build one tile of the navigation mesh. Return true if successful.
-    int BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData*);
+    /// Build the compressed layers of one tile without modifying the tile cache. Called from worker threads. Return true if successful.
+    virtual bool BuildTileData(Vector<NavigationGeometryInfo>& geometryList, NavigationTileData& tile);
+    /// Replace the layers of a tile in the tile cache with built data and rebuild the navigation mesh tiles. The data is taken over, or freed on failure. Return true if successful.
+    virtual bool AddTileData(NavigationTileData& tile);
     /// Off-mesh connections to be rebuilt in the mesh processor.
     PODVector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
@@ -118,6 +119,8 @@ private:
     unsigned maxObstacles_;
     /// Debug draw Obstacles.
     bool drawObstacles_;
+    /// Obstacles changed since the last tile cache update.
+    HashSet<Obstacle*> dirtyObstacles_;
 };
 
 }
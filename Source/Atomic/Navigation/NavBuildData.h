@@ -84,6 +84,32 @@ struct ATOMIC_API NavBuildData
     PODVector<NavAreaStub> navAreas_;
 };
 
+/// Navigation mesh tile data built in a worker thread, to be added to the navigation mesh in the main thread.
+struct ATOMIC_API NavigationTileData
+{
+    /// Construct.
+    NavigationTileData() :
+        x_(0),
+        z_(0),
+        geometry_(0),
+        success_(false)
+    {
+    }
+
+    /// Tile X coordinate.
+    int x_;
+    /// Tile Z coordinate.
+    int z_;
+    /// Geometry collected in the main thread for a background rebuild, or null to collect it when building.
+    const NavBuildData* geometry_;
+    /// Built data blocks, allocated with dtAlloc: a Detour tile, or the compressed layers of a tile cache tile.
+    PODVector<unsigned char*> data_;
+    /// Sizes of the data blocks.
+    PODVector<int> dataSizes_;
+    /// Build success flag.
+    bool success_;
+};
+
 struct SimpleNavBuildData : public NavBuildData
 {
     /// Constructor.
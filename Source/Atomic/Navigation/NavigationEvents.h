@@ -43,6 +43,16 @@ EVENT(E_NAVIGATION_AREA_REBUILT, NavigationAreaRebuilt)
     PARAM(P_BOUNDSMAX, BoundsMax); // Vector3
 }
 
+/// Asynchronous path request finished.
+EVENT(E_NAVIGATION_PATH_FOUND, NavigationPathFound)
+{
+    PARAM(P_NODE, Node); // Node pointer
+    PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    PARAM(P_REQUEST, Request); // unsigned
+    PARAM(P_SUCCESS, Success); // bool
+    PARAM(P_PATH, Path); // VariantVector of Vector3 world space points
+}
+
 /// Crowd agent formation.
 EVENT(E_CROWD_AGENT_FORMATION, CrowdAgentFormation)
 {
@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -45,6 +47,7 @@
 #include "../Physics/CollisionShape.h"
 #endif
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/include/DetourNavMesh.h>
@@ -81,6 +84,7 @@ static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
 
 static const int MAX_POLYS = 2048;
+static const unsigned DEFAULT_PATH_ITERATION_BUDGET = 512;
 
 
 /// Temporary data for finding a path.
@@ -98,12 +102,79 @@ struct FindPathData
     unsigned char pathAreras_[MAX_POLYS];
 };
 
+/// Navigation mesh query with its own temporary path data, used by one thread at a time.
+struct NavigationPathQuery
+{
+    /// Construct.
+    NavigationPathQuery() :
+        query_(dtAllocNavMeshQuery())
+    {
+    }
+
+    /// Destruct.
+    ~NavigationPathQuery()
+    {
+        dtFreeNavMeshQuery(query_);
+        query_ = 0;
+    }
+
+    /// Detour navigation mesh query.
+    dtNavMeshQuery* query_;
+    /// Temporary data for finding a path.
+    FindPathData data_;
+};
+
+/// Convert a polygon corridor to world space path points.
+static void GetStraightPath(PODVector<Vector3>& dest, dtNavMeshQuery* query, FindPathData& data, int numPolys, dtPolyRef endRef,
+    const Vector3& localStart, const Vector3& localEnd, const Matrix3x4& transform)
+{
+    if (!numPolys)
+        return;
+
+    Vector3 actualLocalEnd = localEnd;
+
+    // If full path was not found, clamp end point to the end polygon
+    if (data.polys_[numPolys - 1] != endRef)
+        query->closestPointOnPoly(data.polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, 0);
+
+    int numPathPoints = 0;
+    query->findStraightPath(&localStart.x_, &actualLocalEnd.x_, data.polys_, numPolys,
+        &data.pathPoints_[0].x_, data.pathFlags_, data.pathPolys_, &numPathPoints, MAX_POLYS);
+
+    // Transform path result back to world space
+    for (int i = 0; i < numPathPoints; ++i)
+        dest.Push(transform * data.pathPoints_[i]);
+}
+
+void BuildNavigationTileWork(const WorkItem* item, unsigned threadIndex)
+{
+    Pair<NavigationMesh*, Vector<NavigationGeometryInfo>*>* workData =
+        reinterpret_cast<Pair<NavigationMesh*, Vector<NavigationGeometryInfo>*>*>(item->aux_);
+    NavigationTileData* tile = reinterpret_cast<NavigationTileData*>(item->start_);
+    tile->success_ = workData->first_->BuildTileData(*workData->second_, *tile);
+}
+
+void RebuildNavigationTileWork(const WorkItem* item, unsigned threadIndex)
+{
+    NavigationMesh* navMesh = reinterpret_cast<NavigationMesh*>(item->aux_);
+    NavigationTileData* tile = reinterpret_cast<NavigationTileData*>(item->start_);
+    // The geometry has been collected in the main thread, so the scene is not accessed here
+    Vector<NavigationGeometryInfo> geometryList;
+    tile->success_ = navMesh->BuildTileData(geometryList, *tile);
+    // Releasing the semaphore also publishes the tile data to the main thread
+    navMesh->rebuildCompleted_.Release();
+}
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(0),
     navMeshQuery_(0),
     queryFilter_(new dtQueryFilter()),
     pathData_(new FindPathData()),
+    requestQuery_(0),
+    nextPathRequestId_(1),
+    pathIterationBudget_(DEFAULT_PATH_ITERATION_BUDGET),
+    numRebuiltTiles_(0),
     tileSize_(DEFAULT_TILE_SIZE),
     cellSize_(DEFAULT_CELL_SIZE),
     cellHeight_(DEFAULT_CELL_HEIGHT),
@@ -407,16 +478,7 @@ bool NavigationMesh::Build()
         }
 
         // Build each tile
-        unsigned numTiles = 0;
-
-        for (int z = 0; z < numTilesZ_; ++z)
-        {
-            for (int x = 0; x < numTilesX_; ++x)
-            {
-                if (BuildTile(geometryList, x, z))
-                    ++numTiles;
-            }
-        }
+        unsigned numTiles = BuildTiles(geometryList, 0, 0, numTilesX_ - 1, numTilesZ_ - 1);
 
         LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
 
@@ -446,6 +508,9 @@ bool NavigationMesh::Build(const BoundingBox& boundingBox)
         return false;
     }
 
+    // Keep the order of rebuilds
+    FinishRebuild(true);
+
     if (!node_->GetWorldScale().Equals(Vector3::ONE))
         LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
 
@@ -461,16 +526,7 @@ bool NavigationMesh::Build(const BoundingBox& boundingBox)
     int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
     int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
 
-    unsigned numTiles = 0;
-
-    for (int z = sz; z <= ez; ++z)
-    {
-        for (int x = sx; x <= ex; ++x)
-        {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
-        }
-    }
+    unsigned numTiles = BuildTiles(geometryList, sx, sz, ex, ez);
 
     LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
     return true;
@@ -529,9 +585,14 @@ void NavigationMesh::FindPath(PODVector<Vector3>& dest, const Vector3& start, co
 
     dest.Clear();
 
-    if (!InitializeQuery())
+    // Use a pooled query instead of the shared one, so that paths can also be found from worker threads
+    NavigationPathQuery* pathQuery = AcquirePathQuery();
+    if (!pathQuery)
         return;
 
+    dtNavMeshQuery* query = pathQuery->query_;
+    FindPathData& data = pathQuery->data_;
+
     // Navigation data is in local space. Transform path points from world to local
     const Matrix3x4& transform = node_->GetWorldTransform();
     Matrix3x4 inverse = transform.Inverse();
@@ -540,34 +601,82 @@ void NavigationMesh::FindPath(PODVector<Vector3>& dest, const Vector3& start, co
     Vector3 localEnd = inverse * end;
 
     const dtQueryFilter* queryFilter = filter ? filter : queryFilter_;
-    dtPolyRef startRef;
-    dtPolyRef endRef;
-    navMeshQuery_->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, 0);
-    navMeshQuery_->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, 0);
+    dtPolyRef startRef = 0;
+    dtPolyRef endRef = 0;
+    query->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, 0);
+    query->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, 0);
 
-    if (!startRef || !endRef)
-        return;
+    if (startRef && endRef)
+    {
+        int numPolys = 0;
+        query->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, data.polys_, &numPolys, MAX_POLYS);
+        GetStraightPath(dest, query, data, numPolys, endRef, localStart, localEnd, transform);
+    }
 
-    int numPolys = 0;
-    int numPathPoints = 0;
+    ReleasePathQuery(pathQuery);
+}
 
-    navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData_->polys_, &numPolys,
-        MAX_POLYS);
-    if (!numPolys)
-        return;
+unsigned NavigationMesh::RequestPath(const Vector3& start, const Vector3& end, const Vector3& extents)
+{
+    Scene* scene = GetScene();
+    if (!scene)
+    {
+        LOGERROR("Can not request a path from a navigation mesh which is not in a scene");
+        return 0;
+    }
 
-    Vector3 actualLocalEnd = localEnd;
+    // Points within the same cell would produce the same path, so merge with such a pending request
+    float maxDistanceSquared = cellSize_ * cellSize_;
+    for (Vector<NavigationPathRequest>::ConstIterator i = pathRequests_.Begin(); i != pathRequests_.End(); ++i)
+    {
+        if ((i->start_ - start).LengthSquared() <= maxDistanceSquared && (i->end_ - end).LengthSquared() <= maxDistanceSquared &&
+            i->extents_ == extents)
+            return i->id_;
+    }
 
-    // If full path was not found, clamp end point to the end polygon
-    if (pathData_->polys_[numPolys - 1] != endRef)
-        navMeshQuery_->closestPointOnPoly(pathData_->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, 0);
+    NavigationPathRequest request;
+    request.id_ = nextPathRequestId_++;
+    if (!nextPathRequestId_)
+        nextPathRequestId_ = 1;
+    request.start_ = start;
+    request.end_ = end;
+    request.extents_ = extents;
+    request.endRef_ = 0;
+    request.started_ = false;
+    pathRequests_.Push(request);
 
-    navMeshQuery_->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData_->polys_, numPolys,
-        &pathData_->pathPoints_[0].x_, pathData_->pathFlags_, pathData_->pathPolys_, &numPathPoints, MAX_POLYS);
+    SubscribeToPostUpdate();
 
-    // Transform path result back to world space
-    for (int i = 0; i < numPathPoints; ++i)
-        dest.Push(transform * pathData_->pathPoints_[i]);
+    return request.id_;
+}
+
+void NavigationMesh::CancelPathRequest(unsigned id)
+{
+    // The sliced search state of a cancelled request is simply overwritten by the next request
+    for (Vector<NavigationPathRequest>::Iterator i = pathRequests_.Begin(); i != pathRequests_.End(); ++i)
+    {
+        if (i->id_ == id)
+        {
+            pathRequests_.Erase(i);
+            return;
+        }
+    }
+}
+
+void NavigationMesh::SetPathIterationBudget(unsigned iterations)
+{
+    pathIterationBudget_ = iterations ? iterations : 1;
+}
+
+bool NavigationMesh::IsPathRequestPending(unsigned id) const
+{
+    for (Vector<NavigationPathRequest>::ConstIterator i = pathRequests_.Begin(); i != pathRequests_.End(); ++i)
+    {
+        if (i->id_ == id)
+            return true;
+    }
+
+    return false;
 }
 
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
@@ -1112,14 +1221,83 @@ void NavigationMesh::AddTriMeshGeometry(NavBuildData* build, Geometry* geometry,
 
 bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z)
 {
-    PROFILE(BuildNavigationMeshTile);
+    NavigationTileData tile;
+    tile.x_ = x;
+    tile.z_ = z;
+    tile.success_ = BuildTileData(geometryList, tile);
+    return AddTileData(tile);
+}
 
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), 0, 0);
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, int sx, int sz, int ex, int ez)
+{
+    Vector<NavigationTileData> tiles;
+    for (int z = sz; z <= ez; ++z)
+    {
+        for (int x = sx; x <= ex; ++x)
+        {
+            NavigationTileData tile;
+            tile.x_ = x;
+            tile.z_ = z;
+            tiles.Push(tile);
+        }
+    }
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads() && tiles.Size() > 1)
+    {
+        PROFILE(BuildNavigationMeshTilesThreaded);
+
+        // Update the cached world transforms read by GetTileGeometry() now, so that the worker threads only read them
+        node_->GetWorldTransform();
+        for (unsigned i = 0; i < geometryList.Size(); ++i)
+        {
+            Component* component = geometryList[i].component_;
+            component->GetNode()->GetWorldTransform();
+            if (component->GetType() == OffMeshConnection::GetTypeStatic())
+            {
+                Node* endPoint = static_cast<OffMeshConnection*>(component)->GetEndPoint();
+                if (endPoint)
+                    endPoint->GetWorldTransform();
+            }
+        }
 
+        // Rasterize and build the tiles in the worker threads, one work item per tile since tile costs vary a lot
+        Pair<NavigationMesh*, Vector<NavigationGeometryInfo>*> workData(this, &geometryList);
+        for (unsigned i = 0; i < tiles.Size(); ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = BuildNavigationTileWork;
+            item->aux_ = &workData;
+            item->start_ = &tiles[i];
+            item->end_ = 0;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < tiles.Size(); ++i)
+            tiles[i].success_ = BuildTileData(geometryList, tiles[i]);
+    }
+
+    // Add the tiles to the navigation mesh in the main thread
+    unsigned numTiles = 0;
+    for (unsigned i = 0; i < tiles.Size(); ++i)
+    {
+        if (AddTileData(tiles[i]))
+            ++numTiles;
+    }
+
+    return numTiles;
+}
+
+BoundingBox NavigationMesh::GetTileBoundingBox(int x, int z) const
+{
     float tileEdgeLength = (float)tileSize_ * cellSize_;
 
-    BoundingBox tileBoundingBox(Vector3(
+    return BoundingBox(Vector3(
             boundingBox_.min_.x_ + tileEdgeLength * (float)x,
             boundingBox_.min_.y_,
             boundingBox_.min_.z_ + tileEdgeLength * (float)z
@@ -1129,6 +1307,13 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
             boundingBox_.max_.y_,
             boundingBox_.min_.z_ + tileEdgeLength * (float)(z + 1)
         ));
+}
+
+bool NavigationMesh::BuildTileData(Vector<NavigationGeometryInfo>& geometryList, NavigationTileData& tile)
+{
+    PROFILE(BuildNavigationMeshTile);
+
+    BoundingBox tileBoundingBox = GetTileBoundingBox(tile.x_, tile.z_);
 
     SimpleNavBuildData build;
 
@@ -1160,7 +1345,7 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    GetTileGeometry(&build, geometryList, tile, expandedBox);
 
     if (build.vertices_.Empty() || build.indices_.Empty())
         return true; // Nothing to do
@@ -1304,8 +1489,8 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     params.walkableHeight = agentHeight_;
     params.walkableRadius = agentRadius_;
     params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
+    params.tileX = tile.x_;
+    params.tileY = tile.z_;
     rcVcopy(params.bmin, build.polyMesh_->bmin);
     rcVcopy(params.bmax, build.polyMesh_->bmax);
     params.cs = cfg.cs;
@@ -1329,15 +1514,38 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         return false;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, 0)))
+    tile.data_.Push(navData);
+    tile.dataSizes_.Push(navDataSize);
+    return true;
+}
+
+bool NavigationMesh::AddTileData(NavigationTileData& tile)
+{
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(tile.x_, tile.z_, 0), 0, 0);
+
+    bool success = tile.success_;
+    for (unsigned i = 0; i < tile.data_.Size(); ++i)
     {
-        LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
-        return false;
+        if (!success)
+            dtFree(tile.data_[i]);
+        else if (dtStatusFailed(navMesh_->addTile(tile.data_[i], tile.dataSizes_[i], DT_TILE_FREE_DATA, 0, 0)))
+        {
+            LOGERROR("Failed to add navigation mesh tile");
+            dtFree(tile.data_[i]);
+            success = false;
+        }
     }
 
+    bool hasData = !tile.data_.Empty();
+    tile.data_.Clear();
+    tile.dataSizes_.Clear();
+
     // Send a notification of the rebuild of this tile to anyone interested
+    if (success && hasData)
     {
+        BoundingBox tileBoundingBox = GetTileBoundingBox(tile.x_, tile.z_);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -1346,7 +1554,8 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
-    return true;
+
+    return success;
 }
 
 bool NavigationMesh::InitializeQuery()
@@ -1378,15 +1587,354 @@ void NavigationMesh::ReleaseNavigationMesh()
     dtFreeNavMesh(navMesh_);
     navMesh_ = 0;
 
+    CancelRebuild();
+
     dtFreeNavMeshQuery(navMeshQuery_);
     navMeshQuery_ = 0;
 
+    ClearPathQueries();
+
     numTilesX_ = 0;
     numTilesZ_ = 0;
     boundingBox_.min_ = boundingBox_.max_ = Vector3::ZERO;
     boundingBox_.defined_ = false;
 }
 
+NavigationPathQuery* NavigationMesh::AcquirePathQuery()
+{
+    MutexLock lock(pathQueryMutex_);
+
+    if (!navMesh_ || !node_)
+        return 0;
+
+    if (pathQueries_.Size())
+    {
+        NavigationPathQuery* pathQuery = pathQueries_.Back();
+        pathQueries_.Pop();
+        return pathQuery;
+    }
+
+    NavigationPathQuery* pathQuery = new NavigationPathQuery();
+    if (!pathQuery->query_ || dtStatusFailed(pathQuery->query_->init(navMesh_, MAX_POLYS)))
+    {
+        LOGERROR("Could not init navigation mesh query");
+        delete pathQuery;
+        return 0;
+    }
+
+    return pathQuery;
+}
+
+void NavigationMesh::ReleasePathQuery(NavigationPathQuery* pathQuery)
+{
+    MutexLock lock(pathQueryMutex_);
+    pathQueries_.Push(pathQuery);
+}
+
+void NavigationMesh::ClearPathQueries()
+{
+    MutexLock lock(pathQueryMutex_);
+
+    for (unsigned i = 0; i < pathQueries_.Size(); ++i)
+        delete pathQueries_[i];
+    pathQueries_.Clear();
+
+    // The sliced search in progress refers to the old navigation mesh, so start it again with the next query
+    delete requestQuery_;
+    requestQuery_ = 0;
+    for (Vector<NavigationPathRequest>::Iterator i = pathRequests_.Begin(); i != pathRequests_.End(); ++i)
+        i->started_ = false;
+}
+
+void NavigationMesh::ProcessPathRequests()
+{
+    PROFILE(ProcessPathRequests);
+
+    int budget = (int)pathIterationBudget_;
+
+    while (pathRequests_.Size() && budget > 0)
+    {
+        if (!requestQuery_)
+        {
+            requestQuery_ = AcquirePathQuery();
+            // Without a navigation mesh no pending request can succeed
+            if (!requestQuery_)
+            {
+                if (!FinishPathRequest(false, PODVector<Vector3>()))
+                    return;
+                continue;
+            }
+        }
+
+        NavigationPathRequest& request = pathRequests_.Front();
+        dtNavMeshQuery* query = requestQuery_->query_;
+
+        if (!request.started_)
+        {
+            Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+            request.localStart_ = inverse * request.start_;
+            request.localEnd_ = inverse * request.end_;
+
+            dtPolyRef startRef = 0;
+            request.endRef_ = 0;
+            query->findNearestPoly(&request.localStart_.x_, &request.extents_.x_, queryFilter_, &startRef, 0);
+            query->findNearestPoly(&request.localEnd_.x_, &request.extents_.x_, queryFilter_, &request.endRef_, 0);
+
+            if (!startRef || !request.endRef_ || dtStatusFailed(query->initSlicedFindPath(startRef, request.endRef_,
+                &request.localStart_.x_, &request.localEnd_.x_, queryFilter_)))
+            {
+                if (!FinishPathRequest(false, PODVector<Vector3>()))
+                    return;
+                continue;
+            }
+
+            request.started_ = true;
+            --budget;
+        }
+
+        int iterations = 0;
+        dtStatus status = query->updateSlicedFindPath(budget, &iterations);
+        budget -= iterations;
+        if (dtStatusInProgress(status))
+            break;
+
+        PODVector<Vector3> path;
+        if (dtStatusSucceed(status))
+        {
+            int numPolys = 0;
+            query->finalizeSlicedFindPath(requestQuery_->data_.polys_, &numPolys, MAX_POLYS);
+            GetStraightPath(path, query, requestQuery_->data_, numPolys, request.endRef_, request.localStart_, request.localEnd_,
+                node_->GetWorldTransform());
+        }
+
+        if (!FinishPathRequest(path.Size() > 0, path))
+            return;
+    }
+
+    if (pathRequests_.Empty())
+    {
+        if (requestQuery_)
+        {
+            ReleasePathQuery(requestQuery_);
+            requestQuery_ = 0;
+        }
+    }
+}
+
+bool NavigationMesh::FinishPathRequest(bool success, const PODVector<Vector3>& path)
+{
+    // Remove the request first so that the event handler is free to make new requests
+    unsigned id = pathRequests_.Front().id_;
+    pathRequests_.Erase(pathRequests_.Begin());
+
+    VariantVector points;
+    points.Resize(path.Size());
+    for (unsigned i = 0; i < path.Size(); ++i)
+        points[i] = path[i];
+
+    using namespace NavigationPathFound;
+    VariantMap& eventData = GetContext()->GetEventDataMap();
+    eventData[P_NODE] = node_;
+    eventData[P_MESH] = this;
+    eventData[P_REQUEST] = id;
+    eventData[P_SUCCESS] = success;
+    eventData[P_PATH] = points;
+
+    WeakPtr<NavigationMesh> self(this);
+    SendEvent(E_NAVIGATION_PATH_FOUND, eventData);
+    return !self.Expired();
+}
+
+void NavigationMesh::MarkDirty(const BoundingBox& boundingBox)
+{
+    if (!navMesh_ || !node_)
+        return;
+
+    BoundingBox localSpaceBox = boundingBox.Transformed(node_->GetWorldTransform().Inverse());
+
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+
+    int sx = Clamp((int)((localSpaceBox.min_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
+    int sz = Clamp((int)((localSpaceBox.min_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
+    int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
+    int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
+
+    for (int z = sz; z <= ez; ++z)
+    {
+        for (int x = sx; x <= ex; ++x)
+            dirtyTiles_.Insert(((unsigned)z << 16) | (unsigned)x);
+    }
+
+    SubscribeToPostUpdate();
+}
+
+void NavigationMesh::GetTileGeometry(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList,
+    const NavigationTileData& tile, BoundingBox& box)
+{
+    if (tile.geometry_)
+    {
+        build->vertices_ = tile.geometry_->vertices_;
+        build->indices_ = tile.geometry_->indices_;
+        build->offMeshVertices_ = tile.geometry_->offMeshVertices_;
+        build->offMeshRadii_ = tile.geometry_->offMeshRadii_;
+        build->offMeshFlags_ = tile.geometry_->offMeshFlags_;
+        build->offMeshAreas_ = tile.geometry_->offMeshAreas_;
+        build->offMeshDir_ = tile.geometry_->offMeshDir_;
+        build->navAreas_ = tile.geometry_->navAreas_;
+    }
+    else
+        GetTileGeometry(build, geometryList, box);
+}
+
+void NavigationMesh::StartRebuild()
+{
+    if (dirtyTiles_.Empty() || !rebuildTiles_.Empty())
+        return;
+
+    PROFILE(StartNavigationMeshRebuild);
+
+    Vector<NavigationGeometryInfo> geometryList;
+    CollectGeometries(geometryList);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (!queue || !queue->GetNumThreads())
+    {
+        for (HashSet<unsigned>::ConstIterator i = dirtyTiles_.Begin(); i != dirtyTiles_.End(); ++i)
+            BuildTile(geometryList, *i & 0xffff, *i >> 16);
+        dirtyTiles_.Clear();
+        return;
+    }
+
+    // Collect the geometry in the main thread, so that the scene may change while the tiles are being built.
+    // Pad the tile bounding box the same way as BuildTileData() does
+    float border = (float)((int)ceilf(agentRadius_ / cellSize_) + 3) * cellSize_;
+
+    rebuildTiles_.Resize(dirtyTiles_.Size());
+    rebuildGeometry_.Resize(dirtyTiles_.Size());
+
+    unsigned index = 0;
+    for (HashSet<unsigned>::ConstIterator i = dirtyTiles_.Begin(); i != dirtyTiles_.End(); ++i, ++index)
+    {
+        NavigationTileData& tile = rebuildTiles_[index];
+        tile.x_ = *i & 0xffff;
+        tile.z_ = *i >> 16;
+
+        BoundingBox expandedBox = GetTileBoundingBox(tile.x_, tile.z_);
+        expandedBox.min_.x_ -= border;
+        expandedBox.min_.z_ -= border;
+        expandedBox.max_.x_ += border;
+        expandedBox.max_.z_ += border;
+
+        NavBuildData* geometry = new NavBuildData();
+        GetTileGeometry(geometry, geometryList, expandedBox);
+        rebuildGeometry_[index] = geometry;
+        tile.geometry_ = geometry;
+    }
+
+    dirtyTiles_.Clear();
+
+    // Low priority, so that the work queue does not wait for the tiles when completing per-frame work
+    for (unsigned i = 0; i < rebuildTiles_.Size(); ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = 0;
+        item->workFunction_ = RebuildNavigationTileWork;
+        item->aux_ = this;
+        item->start_ = &rebuildTiles_[i];
+        item->end_ = 0;
+        queue->AddWorkItem(item);
+    }
+}
+
+bool NavigationMesh::FinishRebuild(bool wait)
+{
+    if (rebuildTiles_.Empty())
+        return true;
+
+    while (numRebuiltTiles_ < rebuildTiles_.Size() && rebuildCompleted_.TryAcquire())
+        ++numRebuiltTiles_;
+
+    if (numRebuiltTiles_ < rebuildTiles_.Size())
+    {
+        if (!wait)
+            return false;
+        WaitForRebuild();
+    }
+
+    PROFILE(FinishNavigationMeshRebuild);
+
+    // Replace all the rebuilt tiles at once
+    unsigned numTiles = 0;
+    for (unsigned i = 0; i < rebuildTiles_.Size(); ++i)
+    {
+        if (AddTileData(rebuildTiles_[i]))
+            ++numTiles;
+        delete rebuildGeometry_[i];
+    }
+
+    rebuildTiles_.Clear();
+    rebuildGeometry_.Clear();
+    numRebuiltTiles_ = 0;
+
+    LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh in the background");
+    return true;
+}
+
+void NavigationMesh::CancelRebuild()
+{
+    dirtyTiles_.Clear();
+
+    // The worker threads refer to this navigation mesh, so wait for them
+    WaitForRebuild();
+
+    for (unsigned i = 0; i < rebuildTiles_.Size(); ++i)
+    {
+        NavigationTileData& tile = rebuildTiles_[i];
+        for (unsigned j = 0; j < tile.data_.Size(); ++j)
+            dtFree(tile.data_[j]);
+        delete rebuildGeometry_[i];
+    }
+
+    rebuildTiles_.Clear();
+    rebuildGeometry_.Clear();
+    numRebuiltTiles_ = 0;
+}
+
+void NavigationMesh::WaitForRebuild()
+{
+    while (numRebuiltTiles_ < rebuildTiles_.Size())
+    {
+        rebuildCompleted_.Acquire();
+        ++numRebuiltTiles_;
+    }
+}
+
+void NavigationMesh::SubscribeToPostUpdate()
+{
+    Scene* scene = GetScene();
+    if (scene && !HasSubscribedToEvent(scene, E_SCENEPOSTUPDATE))
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(NavigationMesh, HandleScenePostUpdate));
+}
+
+void NavigationMesh::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // Start rebuilding the tiles marked dirty during the frame only after the previous rebuild has been added
+    if (FinishRebuild(false))
+        StartRebuild();
+
+    if (pathRequests_.Size())
+    {
+        WeakPtr<NavigationMesh> self(this);
+        ProcessPathRequests();
+        // A path event handler may have removed this component
+        if (self.Expired())
+            return;
+    }
+
+    if (pathRequests_.Empty() && !IsRebuildPending())
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
 void NavigationMesh::SetPartitionType(NavmeshPartitionType ptype)
 {
     partitionType_ = ptype;
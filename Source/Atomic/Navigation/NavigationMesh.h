@@ -24,6 +24,8 @@
 
 #include "../Container/ArrayPtr.h"
 #include "../Container/HashSet.h"
+#include "../Core/Mutex.h"
+#include "../Core/Semaphore.h"
 #include "../Math/BoundingBox.h"
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Component.h"
@@ -51,6 +53,30 @@ class Geometry;
 
 struct FindPathData;
 struct NavBuildData;
+struct NavigationPathQuery;
+struct NavigationTileData;
+struct WorkItem;
+
+/// Asynchronous path request.
+struct NavigationPathRequest
+{
+    /// Request ID.
+    unsigned id_;
+    /// Start point in world space.
+    Vector3 start_;
+    /// End point in world space.
+    Vector3 end_;
+    /// How far off the navigation mesh the points can be.
+    Vector3 extents_;
+    /// Start point in navigation mesh local space.
+    Vector3 localStart_;
+    /// End point in navigation mesh local space.
+    Vector3 localEnd_;
+    /// End polygon.
+    dtPolyRef endRef_;
+    /// Whether the sliced path search has been initialized.
+    bool started_;
+};
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -70,6 +96,9 @@ class ATOMIC_API NavigationMesh : public Component
 {
     OBJECT(NavigationMesh);
 
+    friend void BuildNavigationTileWork(const WorkItem* item, unsigned threadIndex);
+    friend void RebuildNavigationTileWork(const WorkItem* item, unsigned threadIndex);
+
     friend class CrowdManager;
 
 public:
@@ -117,6 +146,8 @@ public:
     virtual bool Build();
     /// Rebuild part of the navigation mesh contained by the world-space bounding box. Return true if successful.
     virtual bool Build(const BoundingBox& boundingBox);
+    /// Mark part of the navigation mesh contained by the world-space bounding box for rebuilding. The tiles marked during a frame are rebuilt together at the end of the frame, in the background if the work queue has threads, and replaced at once when all are finished. Geometry and transform changes are not tracked automatically, call this for the bounds of what changed, before and after moving it.
+    void MarkDirty(const BoundingBox& boundingBox);
     /// Find the nearest point on the navigation mesh to a given point. Extents specifies how far out from the specified point to check along each axis.
     Vector3 FindNearestPoint
         (const Vector3& point, const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = 0, dtPolyRef* nearestRef = 0);
@@ -126,6 +157,12 @@ public:
     /// Find a path between world space points. Return non-empty list of points if successful. Extents specifies how far off the navigation mesh the points can be.
     void FindPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
         const dtQueryFilter* filter = 0);
+    /// Request a path between world space points to be found over several frames. Identical pending requests are merged and share the ID. E_NAVIGATION_PATH_FOUND is sent when finished. Return request ID, or 0 if the component is not in a scene.
+    unsigned RequestPath(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE);
+    /// Cancel a pending path request.
+    void CancelPathRequest(unsigned id);
+    /// Set maximum number of pathfinding iterations per frame spent on path requests.
+    void SetPathIterationBudget(unsigned iterations);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = 0, dtPolyRef* randomRef = 0);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -229,6 +266,18 @@ public:
     /// Return whether to draw NavArea components.
     bool GetDrawNavAreas() const { return drawNavAreas_; }
 
+    /// Return maximum number of pathfinding iterations per frame spent on path requests.
+    unsigned GetPathIterationBudget() const { return pathIterationBudget_; }
+
+    /// Return number of pending path requests.
+    unsigned GetNumPathRequests() const { return pathRequests_.Size(); }
+
+    /// Return whether a path request is pending.
+    bool IsPathRequestPending(unsigned id) const;
+
+    /// Return whether tiles marked dirty are waiting to be rebuilt or being rebuilt.
+    bool IsRebuildPending() const { return !dirtyTiles_.Empty() || !rebuildTiles_.Empty(); }
+
 protected:
     /// Collect geometry from under Navigable components.
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList);
@@ -240,11 +289,44 @@ protected:
     /// Add a triangle mesh to the geometry data.
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
     /// Build one tile of the navigation mesh. Return true if successful.
-    virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// Build a rectangle of tiles, in parallel if the work queue has worker threads. Return number of tiles built.
+    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, int sx, int sz, int ex, int ez);
+    /// Build the data of one tile without modifying the navigation mesh. Called from worker threads. Return true if successful.
+    virtual bool BuildTileData(Vector<NavigationGeometryInfo>& geometryList, NavigationTileData& tile);
+    /// Get geometry data of a tile within a bounding box, either collected beforehand or from the geometry list.
+    void GetTileGeometry(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList, const NavigationTileData& tile,
+        BoundingBox& box);
+    /// Start rebuilding the dirty tiles in the background.
+    void StartRebuild();
+    /// Add the tiles rebuilt in the background to the navigation mesh once all are finished, optionally waiting for them. Return true if no background rebuild remains.
+    bool FinishRebuild(bool wait);
+    /// Wait for the background rebuild to finish and discard its results.
+    void CancelRebuild();
+    /// Wait until every tile of the background rebuild is finished.
+    void WaitForRebuild();
+    /// Replace a tile of the navigation mesh with built data. The data is taken over, or freed on failure. Return true if successful.
+    virtual bool AddTileData(NavigationTileData& tile);
+    /// Return bounding box of a tile relative to the navigation mesh root node.
+    BoundingBox GetTileBoundingBox(int x, int z) const;
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
     /// Release the navigation mesh and the query.
     virtual void ReleaseNavigationMesh();
+    /// Take a navigation mesh query with temporary path data from the pool, creating one if necessary. Thread-safe. Return null if there is no navigation mesh.
+    NavigationPathQuery* AcquirePathQuery();
+    /// Return a navigation mesh query to the pool. Thread-safe.
+    void ReleasePathQuery(NavigationPathQuery* pathQuery);
+    /// Free all pooled navigation mesh queries and restart the path request in progress.
+    void ClearPathQueries();
+    /// Advance pending path requests within the iteration budget.
+    void ProcessPathRequests();
+    /// Remove the oldest path request and send the completion event. Return false if the event handler removed this component.
+    bool FinishPathRequest(bool success, const PODVector<Vector3>& path);
+    /// Subscribe to the scene post-update event for processing path requests and dirty tiles.
+    void SubscribeToPostUpdate();
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
 
     /// Identifying name for this navigation mesh.
     String meshName_;
@@ -256,6 +338,28 @@ protected:
     dtQueryFilter* queryFilter_;
     /// Temporary data for finding a path.
     FindPathData* pathData_;
+    /// Pooled navigation mesh queries for finding paths.
+    PODVector<NavigationPathQuery*> pathQueries_;
+    /// Mutex for the navigation mesh query pool.
+    Mutex pathQueryMutex_;
+    /// Navigation mesh query used by the path requests.
+    NavigationPathQuery* requestQuery_;
+    /// Pending path requests in order of submission.
+    Vector<NavigationPathRequest> pathRequests_;
+    /// Next path request ID.
+    unsigned nextPathRequestId_;
+    /// Maximum pathfinding iterations per frame for path requests.
+    unsigned pathIterationBudget_;
+    /// Tiles marked dirty since the last rebuild was started, as Z coordinate << 16 | X coordinate.
+    HashSet<unsigned> dirtyTiles_;
+    /// Tiles being rebuilt in the background.
+    Vector<NavigationTileData> rebuildTiles_;
+    /// Geometry collected for the tiles being rebuilt in the background.
+    PODVector<NavBuildData*> rebuildGeometry_;
+    /// Released by the worker threads once per tile rebuilt in the background.
+    Semaphore rebuildCompleted_;
+    /// Number of tiles of the background rebuild known to be finished.
+    unsigned numRebuiltTiles_;
     /// Tile size.
     int tileSize_;
     /// Cell size.
@@ -47,7 +47,8 @@ Obstacle::Obstacle(Context* context) :
 
 Obstacle::~Obstacle()
 {
-    if (obstacleId_ > 0 && ownerMesh_)
+    // Also forgets a pending change, so remove even if not in the tile cache
+    if (ownerMesh_)
         ownerMesh_->RemoveObstacle(this);
 }
 
@@ -102,7 +103,7 @@ void Obstacle::OnSceneSet(Scene* scene)
     }
     else
     {
-        if (obstacleId_ > 0 && ownerMesh_)
+        if (ownerMesh_)
             ownerMesh_->RemoveObstacle(this);
     }
 }
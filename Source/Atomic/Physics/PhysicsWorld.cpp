@@ -25,6 +25,8 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Atomic3D/Model.h"
 #include "../IO/Log.h"
@@ -35,6 +37,7 @@
 #include "../Physics/PhysicsUtils.h"
 #include "../Physics/PhysicsWorld.h"
 #include "../Physics/RigidBody.h"
+#include "../Physics/ThreadedDynamicsWorld.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
@@ -44,7 +47,7 @@
 #include <Bullet/src/BulletCollision/CollisionShapes/btBoxShape.h>
 #include <Bullet/src/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/src/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
-#include <Bullet/src/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/src/LinearMath/btQuickprof.h>
 
 extern ContactAddedCallback gContactAddedCallback;
 
@@ -57,12 +60,66 @@ extern const char* SUBSYSTEM_CATEGORY;
 static const int MAX_SOLVER_ITERATIONS = 256;
 static const int DEFAULT_FPS = 60;
 static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
+static const unsigned MIN_QUERIES_PER_BATCH = 32;
 
 static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const PhysicsRaycastResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
 }
 
+static bool CompareContactPairs(const PhysicsContactPair& lhs, const PhysicsContactPair& rhs)
+{
+    // Order the bodies within the pair by pointer, so that the manifold's body order does not matter
+    RigidBody* lhsFirst = lhs.bodyA_ < lhs.bodyB_ ? lhs.bodyA_ : lhs.bodyB_;
+    RigidBody* rhsFirst = rhs.bodyA_ < rhs.bodyB_ ? rhs.bodyA_ : rhs.bodyB_;
+    if (lhsFirst != rhsFirst)
+        return lhsFirst < rhsFirst;
+
+    RigidBody* lhsSecond = lhs.bodyA_ < lhs.bodyB_ ? lhs.bodyB_ : lhs.bodyA_;
+    RigidBody* rhsSecond = rhs.bodyA_ < rhs.bodyB_ ? rhs.bodyB_ : rhs.bodyA_;
+    return lhsSecond < rhsSecond;
+}
+
+static bool IsSameContactPair(const PhysicsContactPair& lhs, const PhysicsContactPair& rhs)
+{
+    return (lhs.bodyA_ == rhs.bodyA_ && lhs.bodyB_ == rhs.bodyB_) || (lhs.bodyA_ == rhs.bodyB_ && lhs.bodyB_ == rhs.bodyA_);
+}
+
+static bool IsCollisionReported(RigidBody* bodyA, RigidBody* bodyB)
+{
+    // Skip collision event signaling if both objects are static, or if collision event mode does not match
+    if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
+        !bodyA->IsActive() && !bodyB->IsActive())
+        return false;
+    return true;
+}
+
+static void ClearContactPairs(PODVector<PhysicsContactPair>& pairs, RigidBody* body)
+{
+    for (unsigned i = 0; i < pairs.Size(); ++i)
+    {
+        if (pairs[i].bodyA_ == body || pairs[i].bodyB_ == body)
+            pairs[i].bodyA_ = pairs[i].bodyB_ = 0;
+    }
+}
+
+static void WriteContacts(VectorBuffer& buffer, const PhysicsContact* contacts, unsigned numContacts, bool flipNormals)
+{
+    buffer.Clear();
+
+    for (unsigned i = 0; i < numContacts; ++i)
+    {
+        buffer.WriteVector3(contacts[i].position_);
+        buffer.WriteVector3(flipNormals ? -contacts[i].normal_ : contacts[i].normal_);
+        buffer.WriteFloat(contacts[i].distance_);
+        buffer.WriteFloat(contacts[i].impulse_);
+    }
+}
+
 void InternalPreTickCallback(btDynamicsWorld* world, btScalar timeStep)
 {
     static_cast<PhysicsWorld*>(world->getWorldUserInfo())->PreStep(timeStep);
@@ -114,6 +171,81 @@ struct PhysicsQueryCallback : public btCollisionWorld::ContactResultCallback
     unsigned collisionMask_;
 };
 
+/// Broadphase tree callback for a batch query. Does the same as Bullet's world ray and sweep tests, which share a traversal stack and can not run in parallel.
+struct PhysicsQueryTester : public btDbvt::ICollide
+{
+    /// Construct for a raycast.
+    PhysicsQueryTester(btCollisionWorld::RayResultCallback& callback, const btTransform& from, const btTransform& to) :
+        rayCallback_(&callback),
+        convexCallback_(0),
+        castShape_(0),
+        from_(from),
+        to_(to)
+    {
+    }
+
+    /// Construct for a convex sweep.
+    PhysicsQueryTester(btCollisionWorld::ConvexResultCallback& callback, const btConvexShape* castShape, const btTransform& from,
+        const btTransform& to) :
+        rayCallback_(0),
+        convexCallback_(&callback),
+        castShape_(castShape),
+        from_(from),
+        to_(to)
+    {
+    }
+
+    /// Test a collision object whose bounding box the ray or sweep overlaps.
+    virtual void Process(const btDbvtNode* leaf)
+    {
+        btCollisionObject* object = static_cast<btCollisionObject*>(static_cast<btDbvtProxy*>(leaf->data)->m_clientObject);
+
+        if (rayCallback_)
+        {
+            if (rayCallback_->m_closestHitFraction > 0.0f && rayCallback_->needsCollision(object->getBroadphaseHandle()))
+                btCollisionWorld::rayTestSingle(from_, to_, object, object->getCollisionShape(), object->getWorldTransform(), *rayCallback_);
+        }
+        else
+        {
+            if (convexCallback_->m_closestHitFraction > 0.0f && convexCallback_->needsCollision(object->getBroadphaseHandle()))
+            {
+                btCollisionWorld::objectQuerySingle(castShape_, from_, to_, object, object->getCollisionShape(), object->getWorldTransform(),
+                    *convexCallback_, 0.0f);
+            }
+        }
+    }
+
+    /// Raycast result callback.
+    btCollisionWorld::RayResultCallback* rayCallback_;
+    /// Convex sweep result callback.
+    btCollisionWorld::ConvexResultCallback* convexCallback_;
+    /// Swept shape.
+    const btConvexShape* castShape_;
+    /// Start transform.
+    btTransform from_;
+    /// End transform.
+    btTransform to_;
+};
+
+/// Range of batch queries processed by one work item.
+struct PhysicsQueryBatch
+{
+    /// Physics world.
+    PhysicsWorld* world_;
+    /// First result.
+    PhysicsRaycastResult* results_;
+    /// First query.
+    const PhysicsRaycastQuery* queries_;
+    /// Number of queries.
+    unsigned numQueries_;
+};
+
+void PhysicsQueryBatchWork(const WorkItem* item, unsigned threadIndex)
+{
+    const PhysicsQueryBatch* batch = reinterpret_cast<const PhysicsQueryBatch*>(item->start_);
+    batch->world_->ProcessRaycastQueries(batch->results_, batch->queries_, batch->numQueries_, threadIndex);
+}
+
 PhysicsWorld::PhysicsWorld(Context* context) :
     Component(context),
     collisionConfiguration_(0),
@@ -128,16 +260,23 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     interpolation_(true),
     internalEdge_(true),
     applyingTransforms_(false),
+    threaded_(false),
+    deterministic_(false),
     debugRenderer_(0),
     debugMode_(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawConstraints | btIDebugDraw::DBG_DrawConstraintLimits)
 {
     gContactAddedCallback = CustomMaterialCombinerCallback;
+#ifndef BT_NO_PROFILE
+    // Bullet's profiler is not thread-safe, so only the main thread records samples
+    btSetProfileThreadCheck(Thread::IsMainThread);
+#endif
 
     collisionConfiguration_ = new btDefaultCollisionConfiguration();
-    collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
+    ThreadedCollisionDispatcher* dispatcher = new ThreadedCollisionDispatcher(collisionConfiguration_);
+    collisionDispatcher_ = dispatcher;
     broadphase_ = new btDbvtBroadphase();
     solver_ = new btSequentialImpulseConstraintSolver();
-    world_ = new btDiscreteDynamicsWorld(collisionDispatcher_, broadphase_, solver_, collisionConfiguration_);
+    world_ = new ThreadedDynamicsWorld(dispatcher, broadphase_, solver_, collisionConfiguration_);
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
@@ -176,6 +315,10 @@ PhysicsWorld::~PhysicsWorld()
 
     delete collisionConfiguration_;
     collisionConfiguration_ = 0;
+
+    for (unsigned i = 0; i < queryStacks_.Size(); ++i)
+        delete queryStacks_[i];
+    queryStacks_.Clear();
 }
 
 void PhysicsWorld::RegisterObject(Context* context)
@@ -190,6 +333,8 @@ void PhysicsWorld::RegisterObject(Context* context)
     ATTRIBUTE("Interpolation", bool, interpolation_, true, AM_FILE);
     ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Threaded", GetThreaded, SetThreaded, bool, false, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Deterministic", GetDeterministic, SetDeterministic, bool, false, AM_DEFAULT);
 }
 
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
@@ -332,6 +477,22 @@ void PhysicsWorld::SetSplitImpulse(bool enable)
     MarkNetworkUpdate();
 }
 
+void PhysicsWorld::SetThreaded(bool enable)
+{
+    threaded_ = enable;
+    static_cast<ThreadedDynamicsWorld*>(world_)->SetWorkQueue(enable ? GetSubsystem<WorkQueue>() : 0);
+
+    MarkNetworkUpdate();
+}
+
+void PhysicsWorld::SetDeterministic(bool enable)
+{
+    deterministic_ = enable;
+    static_cast<ThreadedDynamicsWorld*>(world_)->SetDeterministic(enable);
+
+    MarkNetworkUpdate();
+}
+
 void PhysicsWorld::SetMaxNetworkAngularVelocity(float velocity)
 {
     maxNetworkAngularVelocity_ = Clamp(velocity, 1.0f, 32767.0f);
@@ -518,6 +679,52 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, btCollisionShape* sh
     }
 }
 
+void PhysicsWorld::RaycastSingleBatch(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries)
+{
+    PROFILE(PhysicsRaycastBatch);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+    while (queryStacks_.Size() < numThreads + 1)
+        queryStacks_.Push(new btAlignedObjectArray<const btDbvtNode*>());
+
+    unsigned numBatches = numQueries / MIN_QUERIES_PER_BATCH;
+    if (numBatches > numThreads + 1)
+        numBatches = numThreads + 1;
+    if (numBatches <= 1)
+    {
+        ProcessRaycastQueries(results, queries, numQueries, 0);
+        return;
+    }
+
+    PODVector<PhysicsQueryBatch> batches(numBatches);
+
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        PhysicsQueryBatch& batch = batches[i];
+        unsigned start = i * numQueries / numBatches;
+        batch.world_ = this;
+        batch.results_ = results + start;
+        batch.queries_ = queries + start;
+        batch.numQueries_ = (i + 1) * numQueries / numBatches - start;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = PhysicsQueryBatchWork;
+        item->start_ = &batch;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+void PhysicsWorld::RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries)
+{
+    results.Resize(queries.Size());
+    if (queries.Size())
+        RaycastSingleBatch(&results[0], &queries[0], queries.Size());
+}
+
 void PhysicsWorld::RemoveCachedGeometry(Model* model)
 {
     for (HashMap<Pair<Model*, unsigned>, SharedPtr<CollisionGeometryData> >::Iterator i = triMeshCache_.Begin();
@@ -581,13 +788,16 @@ void PhysicsWorld::GetRigidBodies(PODVector<RigidBody*>& result, const RigidBody
 
     result.Clear();
 
-    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*>::Iterator i = currentCollisions_.Begin();
-         i != currentCollisions_.End(); ++i)
+    for (unsigned i = 0; i < currentPairs_.Size(); ++i)
     {
-        if (i->first_.first_ == body)
-            result.Push(i->first_.second_);
-        else if (i->first_.second_ == body)
-            result.Push(i->first_.first_);
+        const PhysicsContactPair& pair = currentPairs_[i];
+        if (!pair.bodyA_ || !pair.bodyB_)
+            continue;
+
+        if (pair.bodyA_ == body)
+            result.Push(pair.bodyB_);
+        else if (pair.bodyB_ == body)
+            result.Push(pair.bodyA_);
     }
 }
 
@@ -616,6 +826,10 @@ void PhysicsWorld::RemoveRigidBody(RigidBody* body)
     rigidBodies_.Remove(body);
     // Remove possible dangling pointer from the delayedWorldTransforms structure
     delayedWorldTransforms_.Erase(body);
+    // Clear the body from the contact pairs. They may be iterated while sending collision events, so they are not erased here
+    ClearContactPairs(currentPairs_, body);
+    ClearContactPairs(previousPairs_, body);
+    ClearContactPairs(endedPairs_, body);
 }
 
 void PhysicsWorld::AddCollisionShape(CollisionShape* shape)
@@ -707,6 +921,11 @@ void PhysicsWorld::PreStep(float timeStep)
     eventData[P_TIMESTEP] = timeStep;
     SendEvent(E_PHYSICSPRESTEP, eventData);
 
+    // Call batched fixed timestep logic updates
+    Scene* scene = GetScene();
+    if (scene)
+        scene->GetComponentUpdateManager().Update(COMPONENT_FIXEDUPDATE, timeStep);
+
     // Start profiling block for the actual simulation step
 #ifdef ATOMIC_PROFILING
     Profiler* profiler = GetSubsystem<Profiler>();
@@ -732,215 +951,357 @@ void PhysicsWorld::PostStep(float timeStep)
     eventData[P_WORLD] = this;
     eventData[P_TIMESTEP] = timeStep;
     SendEvent(E_PHYSICSPOSTSTEP, eventData);
+
+    Scene* scene = GetScene();
+    if (scene)
+        scene->GetComponentUpdateManager().Update(COMPONENT_FIXEDPOSTUPDATE, timeStep);
 }
 
-void PhysicsWorld::SendCollisionEvents()
+void PhysicsWorld::ProcessRaycastQueries(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries,
+    unsigned threadIndex)
 {
-    PROFILE(SendCollisionEvents);
+    btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(broadphase_);
+    btAlignedObjectArray<const btDbvtNode*>& stack = *queryStacks_[threadIndex];
 
-    currentCollisions_.Clear();
-    physicsCollisionData_.Clear();
-    nodeCollisionData_.Clear();
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        const PhysicsRaycastQuery& query = queries[i];
+        PhysicsRaycastResult& result = results[i];
+        result.body_ = 0;
+        result.position_ = Vector3::ZERO;
+        result.normal_ = Vector3::ZERO;
+        result.distance_ = M_INFINITY;
 
-    int numManifolds = collisionDispatcher_->getNumManifolds();
+        if (query.maxDistance_ <= 0.0f || query.maxDistance_ >= M_INFINITY)
+            continue;
 
-    if (numManifolds)
-    {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
+        btVector3 from = ToBtVector3(query.ray_.origin_);
+        btVector3 to = ToBtVector3(query.ray_.origin_ + query.maxDistance_ * query.ray_.direction_);
+        btTransform fromTransform(btQuaternion::getIdentity(), from);
+        btTransform toTransform(btQuaternion::getIdentity(), to);
 
-        for (int i = 0; i < numManifolds; ++i)
+        btVector3 rayDir = (to - from).normalized();
+        btVector3 rayDirInverse(rayDir.x() == 0.0f ? BT_LARGE_FLOAT : 1.0f / rayDir.x(),
+            rayDir.y() == 0.0f ? BT_LARGE_FLOAT : 1.0f / rayDir.y(), rayDir.z() == 0.0f ? BT_LARGE_FLOAT : 1.0f / rayDir.z());
+        unsigned signs[3] = { rayDirInverse.x() < 0.0f, rayDirInverse.y() < 0.0f, rayDirInverse.z() < 0.0f };
+        btScalar lambdaMax = rayDir.dot(to - from);
+
+        if (query.radius_ <= 0.0f)
         {
-            btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
-            // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
-            if (!contactManifold->getNumContacts())
-                continue;
+            btCollisionWorld::ClosestRayResultCallback rayCallback(from, to);
+            rayCallback.m_collisionFilterGroup = (short)0xffff;
+            rayCallback.m_collisionFilterMask = (short)query.collisionMask_;
 
-            const btCollisionObject* objectA = contactManifold->getBody0();
-            const btCollisionObject* objectB = contactManifold->getBody1();
+            PhysicsQueryTester tester(rayCallback, fromTransform, toTransform);
+            btVector3 zero(0.0f, 0.0f, 0.0f);
+            for (unsigned j = 0; j < 2; ++j)
+                broadphase->m_sets[j].rayTestInternal(broadphase->m_sets[j].m_root, from, to, rayDirInverse, signs, lambdaMax, zero, zero,
+                    stack, tester);
 
-            RigidBody* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
-            RigidBody* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
-            // If it's not a rigidbody, maybe a ghost object
-            if (!bodyA || !bodyB)
-                continue;
+            if (rayCallback.hasHit())
+            {
+                result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
+                result.position_ = ToVector3(rayCallback.m_hitPointWorld);
+                result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
+                result.distance_ = (result.position_ - query.ray_.origin_).Length();
+            }
+        }
+        else
+        {
+            btSphereShape shape(query.radius_);
+            btVector3 aabbMin, aabbMax;
+            shape.getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
 
-            // Skip collision event signaling if both objects are static, or if collision event mode does not match
-            if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                !bodyA->IsActive() && !bodyB->IsActive())
-                continue;
+            btCollisionWorld::ClosestConvexResultCallback convexCallback(from, to);
+            convexCallback.m_collisionFilterGroup = (short)0xffff;
+            convexCallback.m_collisionFilterMask = (short)query.collisionMask_;
+
+            PhysicsQueryTester tester(convexCallback, &shape, fromTransform, toTransform);
+            for (unsigned j = 0; j < 2; ++j)
+                broadphase->m_sets[j].rayTestInternal(broadphase->m_sets[j].m_root, from, to, rayDirInverse, signs, lambdaMax, aabbMin,
+                    aabbMax, stack, tester);
+
+            if (convexCallback.hasHit())
+            {
+                result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+                result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+                result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+                result.distance_ = (result.position_ - query.ray_.origin_).Length();
+            }
+        }
+    }
+}
+
+void PhysicsWorld::SendCollisionEvents()
+{
+    PROFILE(SendCollisionEvents);
 
-            WeakPtr<RigidBody> bodyWeakA(bodyA);
-            WeakPtr<RigidBody> bodyWeakB(bodyB);
+    // Keep the previous step's pairs whose bodies still exist. They remain sorted
+    previousPairs_.Swap(currentPairs_);
+    unsigned numPrevious = 0;
+    for (unsigned i = 0; i < previousPairs_.Size(); ++i)
+    {
+        if (previousPairs_[i].bodyA_ && previousPairs_[i].bodyB_)
+            previousPairs_[numPrevious++] = previousPairs_[i];
+    }
+    previousPairs_.Resize(numPrevious);
 
-            Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> > bodyPair;
-            if (bodyA < bodyB)
-                bodyPair = MakePair(bodyWeakA, bodyWeakB);
-            else
-                bodyPair = MakePair(bodyWeakB, bodyWeakA);
+    currentPairs_.Clear();
+    endedPairs_.Clear();
+    contactStream_.Clear();
 
-            // First only store the collision pair as weak pointers and the manifold pointer, so user code can safely destroy
-            // objects during collision event handling
-            currentCollisions_[bodyPair] = contactManifold;
+    int numManifolds = collisionDispatcher_->getNumManifolds();
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
+        if (!contactManifold->getNumContacts())
+            continue;
+
+        RigidBody* bodyA = static_cast<RigidBody*>(contactManifold->getBody0()->getUserPointer());
+        RigidBody* bodyB = static_cast<RigidBody*>(contactManifold->getBody1()->getUserPointer());
+        // If it's not a rigidbody, maybe a ghost object
+        if (!bodyA || !bodyB || !IsCollisionReported(bodyA, bodyB))
+            continue;
+
+        PhysicsContactPair pair;
+        pair.bodyA_ = bodyA;
+        pair.bodyB_ = bodyB;
+        pair.manifold_ = contactManifold;
+        pair.contactStart_ = 0;
+        pair.numContacts_ = 0;
+        pair.newCollision_ = false;
+        pair.trigger_ = bodyA->IsTrigger() || bodyB->IsTrigger();
+        currentPairs_.Push(pair);
+    }
+
+    // Sort the pairs to find the manifolds of the same body pair and to compare against the previous step without hashing
+    Sort(currentPairs_.Begin(), currentPairs_.End(), CompareContactPairs);
+
+    unsigned numPairs = 0;
+    for (unsigned i = 0; i < currentPairs_.Size(); ++i)
+    {
+        PhysicsContactPair pair = currentPairs_[i];
+        if (!numPairs || !IsSameContactPair(currentPairs_[numPairs - 1], pair))
+        {
+            pair.contactStart_ = contactStream_.Size();
+            currentPairs_[numPairs++] = pair;
         }
 
-        for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*>::Iterator i = currentCollisions_.Begin();
-             i != currentCollisions_.End(); ++i)
+        // A compound shape may produce several manifolds for the same pair, so append the contacts of all
+        PhysicsContactPair& dest = currentPairs_[numPairs - 1];
+        btPersistentManifold* contactManifold = pair.manifold_;
+        bool flip = static_cast<RigidBody*>(contactManifold->getBody0()->getUserPointer()) != dest.bodyA_;
+        for (int j = 0; j < contactManifold->getNumContacts(); ++j)
         {
-            RigidBody* bodyA = i->first_.first_;
-            RigidBody* bodyB = i->first_.second_;
-            if (!bodyA || !bodyB)
-                continue;
+            btManifoldPoint& point = contactManifold->getContactPoint(j);
+            PhysicsContact contact;
+            contact.position_ = ToVector3(flip ? point.m_positionWorldOnA : point.m_positionWorldOnB);
+            contact.normal_ = flip ? -ToVector3(point.m_normalWorldOnB) : ToVector3(point.m_normalWorldOnB);
+            contact.distance_ = point.m_distance1;
+            contact.impulse_ = point.m_appliedImpulse;
+            contactStream_.Push(contact);
+        }
+        dest.numContacts_ = contactStream_.Size() - dest.contactStart_;
+    }
+    currentPairs_.Resize(numPairs);
 
-            btPersistentManifold* contactManifold = i->second_;
+    // Both lists are sorted, so new and ended collisions are found in one pass
+    unsigned j = 0;
+    for (unsigned i = 0; i < currentPairs_.Size(); ++i)
+    {
+        while (j < previousPairs_.Size() && CompareContactPairs(previousPairs_[j], currentPairs_[i]))
+            endedPairs_.Push(previousPairs_[j++]);
+
+        if (j < previousPairs_.Size() && IsSameContactPair(previousPairs_[j], currentPairs_[i]))
+            ++j;
+        else
+            currentPairs_[i].newCollision_ = true;
+    }
+    while (j < previousPairs_.Size())
+        endedPairs_.Push(previousPairs_[j++]);
+
+    for (unsigned i = 0; i < endedPairs_.Size(); ++i)
+    {
+        endedPairs_[i].manifold_ = 0;
+        endedPairs_[i].contactStart_ = 0;
+        endedPairs_[i].numContacts_ = 0;
+        endedPairs_[i].newCollision_ = false;
+    }
+
+    SendContactPairEvents();
+}
 
-            Node* nodeA = bodyA->GetNode();
-            Node* nodeB = bodyB->GetNode();
-            WeakPtr<Node> nodeWeakA(nodeA);
-            WeakPtr<Node> nodeWeakB(nodeB);
+void PhysicsWorld::SendContactPairEvents()
+{
+    // Check the listeners before building any event data. Subscribing during the event handling takes effect on the next step
+    bool worldStart = HasEventReceivers(E_PHYSICSCOLLISIONSTART);
+    bool worldCollision = HasEventReceivers(E_PHYSICSCOLLISION);
+    bool worldEnd = HasEventReceivers(E_PHYSICSCOLLISIONEND);
 
-            bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
-            bool newCollision = !previousCollisions_.Contains(i->first_);
+    physicsCollisionData_.Clear();
+    nodeCollisionData_.Clear();
 
+    // Check the pair entries after each event: removing a body in an event handler clears its pointers
+    for (unsigned i = 0; i < currentPairs_.Size(); ++i)
+    {
+        const PhysicsContactPair& pair = currentPairs_[i];
+        RigidBody* bodyA = pair.bodyA_;
+        RigidBody* bodyB = pair.bodyB_;
+        if (!bodyA || !bodyB)
+            continue;
+
+        Node* nodeA = bodyA->GetNode();
+        Node* nodeB = bodyB->GetNode();
+        bool newCollision = pair.newCollision_;
+        bool sendWorldStart = newCollision && worldStart;
+        bool sendNodeAStart = newCollision && nodeA->HasEventReceivers(E_NODECOLLISIONSTART);
+        bool sendNodeBStart = newCollision && nodeB->HasEventReceivers(E_NODECOLLISIONSTART);
+        bool sendNodeA = nodeA->HasEventReceivers(E_NODECOLLISION);
+        bool sendNodeB = nodeB->HasEventReceivers(E_NODECOLLISION);
+        if (!sendWorldStart && !worldCollision && !sendNodeAStart && !sendNodeA && !sendNodeBStart && !sendNodeB)
+            continue;
+
+        WeakPtr<Node> nodeWeakA(nodeA);
+        WeakPtr<Node> nodeWeakB(nodeB);
+        bool trigger = pair.trigger_;
+        const PhysicsContact* contacts = pair.numContacts_ ? &contactStream_[pair.contactStart_] : 0;
+        unsigned numContacts = pair.numContacts_;
+
+        WriteContacts(contacts_, contacts, numContacts, false);
+
+        if (sendWorldStart || worldCollision)
+        {
+            physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
             physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
             physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
             physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
             physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
             physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
-            contacts_.Clear();
-
-            for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-            {
-                btManifoldPoint& point = contactManifold->getContactPoint(j);
-                contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                contacts_.WriteFloat(point.m_distance1);
-                contacts_.WriteFloat(point.m_appliedImpulse);
-            }
-
             physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
 
             // Send separate collision start event if collision is new
-            if (newCollision)
+            if (sendWorldStart)
             {
                 SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                if (!nodeWeakA || !nodeWeakB || !currentPairs_[i].bodyA_ || !currentPairs_[i].bodyB_)
                     continue;
             }
 
             // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                continue;
+            if (worldCollision)
+            {
+                SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
+                if (!nodeWeakA || !nodeWeakB || !currentPairs_[i].bodyA_ || !currentPairs_[i].bodyB_)
+                    continue;
+            }
+        }
 
+        if (sendNodeAStart || sendNodeA)
+        {
             nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
             nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
             nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
             nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
             nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
 
-            if (newCollision)
+            if (sendNodeAStart)
             {
                 nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                if (!nodeWeakA || !nodeWeakB || !currentPairs_[i].bodyA_ || !currentPairs_[i].bodyB_)
                     continue;
             }
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                continue;
-
-            contacts_.Clear();
-            for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+            if (sendNodeA)
             {
-                btManifoldPoint& point = contactManifold->getContactPoint(j);
-                contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                contacts_.WriteFloat(point.m_distance1);
-                contacts_.WriteFloat(point.m_appliedImpulse);
+                nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+                if (!nodeWeakA || !nodeWeakB || !currentPairs_[i].bodyA_ || !currentPairs_[i].bodyB_)
+                    continue;
             }
+        }
+
+        if (sendNodeBStart || sendNodeB)
+        {
+            WriteContacts(contacts_, contacts, numContacts, true);
 
             nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
             nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
             nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
+            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
             nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
 
-            if (newCollision)
+            if (sendNodeBStart)
             {
                 nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                if (!nodeWeakA || !nodeWeakB || !currentPairs_[i].bodyA_ || !currentPairs_[i].bodyB_)
                     continue;
             }
 
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            if (sendNodeB)
+                nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
         }
     }
 
     // Send collision end events as applicable
+    for (unsigned i = 0; i < endedPairs_.Size(); ++i)
     {
-        physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
-
-        for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*>::Iterator
-                 i = previousCollisions_.Begin(); i != previousCollisions_.End(); ++i)
+        const PhysicsContactPair& pair = endedPairs_[i];
+        RigidBody* bodyA = pair.bodyA_;
+        RigidBody* bodyB = pair.bodyB_;
+        if (!bodyA || !bodyB || !IsCollisionReported(bodyA, bodyB))
+            continue;
+
+        Node* nodeA = bodyA->GetNode();
+        Node* nodeB = bodyB->GetNode();
+        bool sendNodeA = nodeA->HasEventReceivers(E_NODECOLLISIONEND);
+        bool sendNodeB = nodeB->HasEventReceivers(E_NODECOLLISIONEND);
+        if (!worldEnd && !sendNodeA && !sendNodeB)
+            continue;
+
+        WeakPtr<Node> nodeWeakA(nodeA);
+        WeakPtr<Node> nodeWeakB(nodeB);
+        bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
+
+        if (worldEnd)
         {
-            if (!currentCollisions_.Contains(i->first_))
-            {
-                RigidBody* bodyA = i->first_.first_;
-                RigidBody* bodyB = i->first_.second_;
-                if (!bodyA || !bodyB)
-                    continue;
-
-                bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
-
-                // Skip collision event signaling if both objects are static, or if collision event mode does not match
-                if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                    !bodyA->IsActive() && !bodyB->IsActive())
-                    continue;
-
-                Node* nodeA = bodyA->GetNode();
-                Node* nodeB = bodyB->GetNode();
-                WeakPtr<Node> nodeWeakA(nodeA);
-                WeakPtr<Node> nodeWeakB(nodeB);
-
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+            physicsCollisionData_.Clear();
+            physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
+            physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
+            physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
+            physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
+            physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
+            physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+
+            SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
+            // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+            if (!nodeWeakA || !nodeWeakB || !endedPairs_[i].bodyA_ || !endedPairs_[i].bodyB_)
+                continue;
+        }
 
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
+        nodeCollisionData_.Clear();
+        nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+        if (sendNodeA)
+        {
+            nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
+            nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
+            nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
 
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
+            nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+            if (!nodeWeakA || !nodeWeakB || !endedPairs_[i].bodyA_ || !endedPairs_[i].bodyB_)
+                continue;
+        }
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+        if (sendNodeB)
+        {
+            nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
+            nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
+            nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
 
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-            }
+            nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
         }
     }
-
-    previousCollisions_ = currentCollisions_;
 }
 
 void RegisterPhysicsLibrary(Context* context)
@@ -25,6 +25,7 @@
 #include "../Container/HashSet.h"
 #include "../IO/VectorBuffer.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Ray.h"
 #include "../Math/Sphere.h"
 #include "../Math/Vector3.h"
 #include "../Scene/Component.h"
@@ -39,6 +40,9 @@ class btDiscreteDynamicsWorld;
 class btDispatcher;
 class btDynamicsWorld;
 class btPersistentManifold;
+struct btDbvtNode;
+
+template <typename T> class btAlignedObjectArray;
 
 namespace Atomic
 {
@@ -48,13 +52,13 @@ class Deserializer;
 class Constraint;
 class Model;
 class Node;
-class Ray;
 class RigidBody;
 class Scene;
 class Serializer;
 class XMLElement;
 
 struct CollisionGeometryData;
+struct WorkItem;
 
 /// Physics raycast hit.
 struct ATOMIC_API PhysicsRaycastResult
@@ -81,6 +85,68 @@ struct ATOMIC_API PhysicsRaycastResult
     RigidBody* body_;
 };
 
+/// Physics raycast or sphere cast query for batch queries.
+struct ATOMIC_API PhysicsRaycastQuery
+{
+    /// Construct with defaults.
+    PhysicsRaycastQuery() :
+        maxDistance_(0.0f),
+        radius_(0.0f),
+        collisionMask_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Construct with ray, maximum distance, sphere radius and collision mask.
+    PhysicsRaycastQuery(const Ray& ray, float maxDistance, float radius = 0.0f, unsigned collisionMask = M_MAX_UNSIGNED) :
+        ray_(ray),
+        maxDistance_(maxDistance),
+        radius_(radius),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Ray in worldspace.
+    Ray ray_;
+    /// Maximum distance along the ray.
+    float maxDistance_;
+    /// Radius of the swept sphere, or 0 for a raycast.
+    float radius_;
+    /// Collision mask.
+    unsigned collisionMask_;
+};
+
+/// Contact point in the physics contact stream.
+struct PhysicsContact
+{
+    /// Worldspace position on body B.
+    Vector3 position_;
+    /// Worldspace normal on body B.
+    Vector3 normal_;
+    /// Distance, negative when penetrating.
+    float distance_;
+    /// Impulse applied by the constraint solver.
+    float impulse_;
+};
+
+/// Colliding rigid body pair in the physics contact stream.
+struct PhysicsContactPair
+{
+    /// First rigid body. Null if removed after the simulation step.
+    RigidBody* bodyA_;
+    /// Second rigid body. Null if removed after the simulation step.
+    RigidBody* bodyB_;
+    /// First Bullet contact manifold of the pair. Null for ended pairs.
+    btPersistentManifold* manifold_;
+    /// Index of the first contact in the contact stream.
+    unsigned contactStart_;
+    /// Number of contacts.
+    unsigned numContacts_;
+    /// Whether the collision started on the last simulation step.
+    bool newCollision_;
+    /// Whether either body is a trigger.
+    bool trigger_;
+};
+
 /// Delayed world transform assignment for parented rigidbodies.
 struct DelayedWorldTransform
 {
@@ -103,6 +169,7 @@ class ATOMIC_API PhysicsWorld : public Component, public btIDebugDraw
 
     friend void InternalPreTickCallback(btDynamicsWorld* world, btScalar timeStep);
     friend void InternalTickCallback(btDynamicsWorld* world, btScalar timeStep);
+    friend void PhysicsQueryBatchWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -153,6 +220,10 @@ public:
     void SetSplitImpulse(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
+    /// Set whether to run the narrowphase and solve the simulation islands in the work queue threads. Disabled by default.
+    void SetThreaded(bool enable);
+    /// Set whether the threaded simulation should give the same result regardless of thread timing. Costs a sort of the contacts per island. Disabled by default.
+    void SetDeterministic(bool enable);
     /// Perform a physics world raycast and return all hits.
     void Raycast
         (PODVector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -167,6 +238,10 @@ public:
     /// Perform a physics world swept convex test using a user-supplied Bullet collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, btCollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of raycasts and sphere casts and return the closest hit of each to the preallocated result array. Large batches are split to the work queue threads.
+    void RaycastSingleBatch(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries);
+    /// Perform a batch of raycasts and sphere casts and return the closest hit of each, in query order.
+    void RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries);
     /// Invalidate cached collision geometry for a model.
     void RemoveCachedGeometry(Model* model);
     /// Return rigid bodies by a sphere query.
@@ -200,6 +275,21 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
+    /// Return the colliding body pairs of the last simulation step, including new collisions.
+    const PODVector<PhysicsContactPair>& GetContactPairs() const { return currentPairs_; }
+
+    /// Return the body pairs which stopped colliding on the last simulation step. These have no contacts.
+    const PODVector<PhysicsContactPair>& GetEndedContactPairs() const { return endedPairs_; }
+
+    /// Return the contacts of the last simulation step. Indexed by the contact pairs.
+    const PODVector<PhysicsContact>& GetContacts() const { return contactStream_; }
+
+    /// Return whether the simulation uses the work queue threads.
+    bool GetThreaded() const { return threaded_; }
+
+    /// Return whether the threaded simulation result is deterministic.
+    bool GetDeterministic() const { return deterministic_; }
+
     /// Add a rigid body to keep track of. Called by RigidBody.
     void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
@@ -250,8 +340,12 @@ private:
     void PreStep(float timeStep);
     /// Trigger update after each physics simulation step.
     void PostStep(float timeStep);
-    /// Send accumulated collision events.
+    /// Collect the contact pairs of the simulation step and send the collision events.
     void SendCollisionEvents();
+    /// Send the collision events of the contact pairs which have receivers.
+    void SendContactPairEvents();
+    /// Process a range of batch queries. Called from the work queue threads.
+    void ProcessRaycastQueries(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries, unsigned threadIndex);
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_;
@@ -271,10 +365,14 @@ private:
     PODVector<CollisionShape*> collisionShapes_;
     /// Constraints in the world.
     PODVector<Constraint*> constraints_;
-    /// Collision pairs on this frame.
-    HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*> currentCollisions_;
-    /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
-    HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*> previousCollisions_;
+    /// Collision pairs on this step, sorted by body pointers.
+    PODVector<PhysicsContactPair> currentPairs_;
+    /// Collision pairs on the previous step. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
+    PODVector<PhysicsContactPair> previousPairs_;
+    /// Collision pairs which ended on this step.
+    PODVector<PhysicsContactPair> endedPairs_;
+    /// Contacts of the collision pairs on this step.
+    PODVector<PhysicsContact> contactStream_;
     /// Delayed (parented) world transform assignments.
     HashMap<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
     /// Cache for trimesh geometry data by model and LOD level.
@@ -287,6 +385,8 @@ private:
     VariantMap nodeCollisionData_;
     /// Preallocated buffer for physics collision contact data.
     VectorBuffer contacts_;
+    /// Broadphase traversal stacks for batch queries per thread. Index 0 is the main thread.
+    PODVector<btAlignedObjectArray<const btDbvtNode*>*> queryStacks_;
     /// Simulation substeps per second.
     unsigned fps_;
     /// Maximum number of simulation substeps per frame. 0 (default) unlimited, or negative values for adaptive timestep.
@@ -301,6 +401,10 @@ private:
     bool internalEdge_;
     /// Applying transforms flag.
     bool applyingTransforms_;
+    /// Threaded simulation flag.
+    bool threaded_;
+    /// Deterministic threaded simulation flag.
+    bool deterministic_;
     /// Debug renderer.
     DebugRenderer* debugRenderer_;
     /// Debug draw flags.
@@ -0,0 +1,373 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/Sort.h"
+#include "../Core/WorkQueue.h"
+#include "../Physics/ThreadedDynamicsWorld.h"
+
+#include <Bullet/src/BulletCollision/BroadphaseCollision/btOverlappingPairCache.h>
+#include <Bullet/src/BulletCollision/CollisionDispatch/btSimulationIslandManager.h>
+#include <Bullet/src/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <Bullet/src/BulletDynamics/ConstraintSolver/btTypedConstraint.h>
+#include <Bullet/src/LinearMath/btQuickprof.h>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Minimum number of overlapping pairs per narrowphase work item.
+static const int MIN_PAIRS_PER_BATCH = 64;
+/// Number of narrowphase work items per thread, to even out the load.
+static const int PAIR_BATCHES_PER_THREAD = 4;
+
+/// Range of overlapping pairs processed by one work item.
+struct CollisionPairBatch
+{
+    /// Collision dispatcher.
+    ThreadedCollisionDispatcher* dispatcher_;
+    /// Dispatch info.
+    const btDispatcherInfo* dispatchInfo_;
+    /// First pair.
+    btBroadphasePair* pairs_;
+    /// Number of pairs.
+    int numPairs_;
+};
+
+/// Island manager callback which collects the awake islands to the threaded world.
+class ThreadedIslandCallback : public btSimulationIslandManager::IslandCallback
+{
+public:
+    /// Construct.
+    ThreadedIslandCallback(ThreadedDynamicsWorld* world) :
+        world_(world)
+    {
+    }
+
+    /// Collect an island.
+    virtual void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId)
+    {
+        world_->AddIsland(bodies, numBodies, manifolds, numManifolds, islandId);
+    }
+
+private:
+    /// Dynamics world.
+    ThreadedDynamicsWorld* world_;
+};
+
+static inline int GetConstraintIslandId(const btTypedConstraint* constraint)
+{
+    int islandId = constraint->getRigidBodyA().getIslandTag();
+    return islandId >= 0 ? islandId : constraint->getRigidBodyB().getIslandTag();
+}
+
+static bool CompareConstraintIslands(btTypedConstraint* lhs, btTypedConstraint* rhs)
+{
+    return GetConstraintIslandId(lhs) < GetConstraintIslandId(rhs);
+}
+
+static bool CompareManifolds(btPersistentManifold* lhs, btPersistentManifold* rhs)
+{
+    // Broadphase ids depend only on the order the bodies were added to the world. Compound shapes may produce several
+    // manifolds for the same body pair, so order those by the child shape index of their first contact
+    int lhsId0 = lhs->getBody0()->getBroadphaseHandle()->m_uniqueId;
+    int rhsId0 = rhs->getBody0()->getBroadphaseHandle()->m_uniqueId;
+    if (lhsId0 != rhsId0)
+        return lhsId0 < rhsId0;
+
+    int lhsId1 = lhs->getBody1()->getBroadphaseHandle()->m_uniqueId;
+    int rhsId1 = rhs->getBody1()->getBroadphaseHandle()->m_uniqueId;
+    if (lhsId1 != rhsId1)
+        return lhsId1 < rhsId1;
+
+    int lhsIndex0 = lhs->getNumContacts() ? lhs->getContactPoint(0).m_index0 : -1;
+    int rhsIndex0 = rhs->getNumContacts() ? rhs->getContactPoint(0).m_index0 : -1;
+    if (lhsIndex0 != rhsIndex0)
+        return lhsIndex0 < rhsIndex0;
+
+    int lhsIndex1 = lhs->getNumContacts() ? lhs->getContactPoint(0).m_index1 : -1;
+    int rhsIndex1 = rhs->getNumContacts() ? rhs->getContactPoint(0).m_index1 : -1;
+    return lhsIndex1 < rhsIndex1;
+}
+
+void ProcessCollisionPairsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const CollisionPairBatch* batch = reinterpret_cast<const CollisionPairBatch*>(item->start_);
+    ThreadedCollisionDispatcher& dispatcher = *batch->dispatcher_;
+    btNearCallback nearCallback = dispatcher.getNearCallback();
+
+    for (int i = 0; i < batch->numPairs_; ++i)
+        nearCallback(batch->pairs_[i], dispatcher, *batch->dispatchInfo_);
+}
+
+void SolvePhysicsBatchWork(const WorkItem* item, unsigned threadIndex)
+{
+    ThreadedDynamicsWorld* world = reinterpret_cast<ThreadedDynamicsWorld*>(item->aux_);
+    world->SolveBatch(*reinterpret_cast<const PhysicsSolverBatch*>(item->start_), threadIndex);
+}
+
+ThreadedCollisionDispatcher::ThreadedCollisionDispatcher(btCollisionConfiguration* collisionConfiguration) :
+    btCollisionDispatcher(collisionConfiguration),
+    workQueue_(0)
+{
+}
+
+btPersistentManifold* ThreadedCollisionDispatcher::getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1)
+{
+    MutexLock lock(poolMutex_);
+    return btCollisionDispatcher::getNewManifold(b0, b1);
+}
+
+void ThreadedCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
+{
+    MutexLock lock(poolMutex_);
+    btCollisionDispatcher::releaseManifold(manifold);
+}
+
+void* ThreadedCollisionDispatcher::allocateCollisionAlgorithm(int size)
+{
+    MutexLock lock(poolMutex_);
+    return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+}
+
+void ThreadedCollisionDispatcher::freeCollisionAlgorithm(void* ptr)
+{
+    MutexLock lock(poolMutex_);
+    btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+}
+
+void ThreadedCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo,
+    btDispatcher* dispatcher)
+{
+    int numPairs = pairCache->getNumOverlappingPairs();
+    int numBatches = 0;
+
+    // Continuous dispatch accumulates the time of impact to the dispatch info, so it is always processed in the calling thread
+    if (workQueue_ && workQueue_->GetNumThreads() && dispatchInfo.m_dispatchFunc == btDispatcherInfo::DISPATCH_DISCRETE)
+        numBatches = Min(numPairs / MIN_PAIRS_PER_BATCH, (int)(workQueue_->GetNumThreads() + 1) * PAIR_BATCHES_PER_THREAD);
+
+    if (numBatches <= 1)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+        return;
+    }
+
+    BT_PROFILE("dispatchAllCollisionPairs");
+
+    btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+    int pairsPerBatch = (numPairs + numBatches - 1) / numBatches;
+    PODVector<CollisionPairBatch> batches(numBatches);
+
+    for (int i = 0; i < numBatches; ++i)
+    {
+        CollisionPairBatch& batch = batches[i];
+        batch.dispatcher_ = this;
+        batch.dispatchInfo_ = &dispatchInfo;
+        batch.pairs_ = pairs + i * pairsPerBatch;
+        batch.numPairs_ = Min(pairsPerBatch, numPairs - i * pairsPerBatch);
+
+        SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ProcessCollisionPairsWork;
+        item->start_ = &batch;
+        workQueue_->AddWorkItem(item);
+    }
+
+    workQueue_->Complete(M_MAX_UNSIGNED);
+}
+
+ThreadedDynamicsWorld::ThreadedDynamicsWorld(ThreadedCollisionDispatcher* dispatcher, btBroadphaseInterface* broadphase,
+    btConstraintSolver* solver, btCollisionConfiguration* collisionConfiguration) :
+    btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration),
+    threadedDispatcher_(dispatcher),
+    workQueue_(0),
+    nextConstraint_(0),
+    solverInfo_(0),
+    deterministic_(false)
+{
+}
+
+ThreadedDynamicsWorld::~ThreadedDynamicsWorld()
+{
+    for (unsigned i = 0; i < solvers_.Size(); ++i)
+        delete solvers_[i];
+    solvers_.Clear();
+}
+
+void ThreadedDynamicsWorld::SetWorkQueue(WorkQueue* queue)
+{
+    workQueue_ = queue;
+    threadedDispatcher_->SetWorkQueue(queue);
+}
+
+void ThreadedDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
+{
+    // Unsplit islands are solved as a single group, which gains nothing from threads
+    if (!workQueue_ || !m_islandManager->getSplitIslands())
+    {
+        btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+        return;
+    }
+
+    BT_PROFILE("solveConstraints");
+
+    islandConstraints_.Resize(m_constraints.size());
+    for (unsigned i = 0; i < islandConstraints_.Size(); ++i)
+        islandConstraints_[i] = m_constraints[i];
+    Sort(islandConstraints_.Begin(), islandConstraints_.End(), CompareConstraintIslands);
+
+    nextConstraint_ = 0;
+    batchBodies_.Clear();
+    batchManifolds_.Clear();
+    batchConstraints_.Clear();
+    batches_.Clear();
+    sharedBodies_.Clear();
+    sharedManifolds_.Clear();
+    sharedConstraints_.Clear();
+    currentBatch_.bodyStart_ = currentBatch_.numBodies_ = 0;
+    currentBatch_.manifoldStart_ = currentBatch_.numManifolds_ = 0;
+    currentBatch_.constraintStart_ = currentBatch_.numConstraints_ = 0;
+    solverInfo_ = &solverInfo;
+
+    // Collect the awake islands to batches. The batches depend only on the islands, not on the number of threads
+    ThreadedIslandCallback callback(this);
+    m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(), getCollisionWorld(), &callback);
+    EndBatch();
+
+    // The solver writes to the kinematic bodies it touches, so all islands touching them are solved in the same batch
+    if (sharedManifolds_.Size() || sharedConstraints_.Size())
+    {
+        batchBodies_.Push(sharedBodies_);
+        batchManifolds_.Push(sharedManifolds_);
+        batchConstraints_.Push(sharedConstraints_);
+        currentBatch_.numBodies_ = sharedBodies_.Size();
+        currentBatch_.numManifolds_ = sharedManifolds_.Size();
+        currentBatch_.numConstraints_ = sharedConstraints_.Size();
+        EndBatch();
+    }
+
+    if (batches_.Empty())
+        return;
+
+    unsigned numThreads = workQueue_->GetNumThreads();
+    while (solvers_.Size() < numThreads + 1)
+        solvers_.Push(new btSequentialImpulseConstraintSolver());
+
+    if (!numThreads || batches_.Size() == 1)
+    {
+        for (unsigned i = 0; i < batches_.Size(); ++i)
+            SolveBatch(batches_[i], 0);
+        return;
+    }
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+    {
+        SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = SolvePhysicsBatchWork;
+        item->aux_ = this;
+        item->start_ = &batches_[i];
+        workQueue_->AddWorkItem(item);
+    }
+
+    workQueue_->Complete(M_MAX_UNSIGNED);
+}
+
+void ThreadedDynamicsWorld::AddIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+    int islandId)
+{
+    // The islands are reported in ascending id order, so the constraints of this island follow the previous island's
+    while (nextConstraint_ < islandConstraints_.Size() && GetConstraintIslandId(islandConstraints_[nextConstraint_]) < islandId)
+        ++nextConstraint_;
+    unsigned constraintStart = nextConstraint_;
+    while (nextConstraint_ < islandConstraints_.Size() && GetConstraintIslandId(islandConstraints_[nextConstraint_]) == islandId)
+        ++nextConstraint_;
+    unsigned numConstraints = nextConstraint_ - constraintStart;
+
+    // Nothing to solve in an island without contacts or constraints
+    if (!numManifolds && !numConstraints)
+        return;
+
+    bool shared = false;
+    for (int i = 0; i < numManifolds && !shared; ++i)
+        shared = manifolds[i]->getBody0()->isKinematicObject() || manifolds[i]->getBody1()->isKinematicObject();
+    for (unsigned i = constraintStart; i < nextConstraint_ && !shared; ++i)
+    {
+        btTypedConstraint* constraint = islandConstraints_[i];
+        shared = constraint->getRigidBodyA().isKinematicObject() || constraint->getRigidBodyB().isKinematicObject();
+    }
+
+    // The island manager reuses its body and manifold arrays for each island, so copy them
+    PODVector<btCollisionObject*>& destBodies = shared ? sharedBodies_ : batchBodies_;
+    PODVector<btPersistentManifold*>& destManifolds = shared ? sharedManifolds_ : batchManifolds_;
+    PODVector<btTypedConstraint*>& destConstraints = shared ? sharedConstraints_ : batchConstraints_;
+
+    unsigned manifoldStart = destManifolds.Size();
+    for (int i = 0; i < numBodies; ++i)
+        destBodies.Push(bodies[i]);
+    for (int i = 0; i < numManifolds; ++i)
+        destManifolds.Push(manifolds[i]);
+    for (unsigned i = constraintStart; i < nextConstraint_; ++i)
+        destConstraints.Push(islandConstraints_[i]);
+
+    // The narrowphase creates the manifolds in a timing-dependent order when threaded
+    if (deterministic_ && numManifolds > 1)
+        Sort(destManifolds.Begin() + manifoldStart, destManifolds.End(), CompareManifolds);
+
+    if (!shared)
+    {
+        currentBatch_.numBodies_ += numBodies;
+        currentBatch_.numManifolds_ += numManifolds;
+        currentBatch_.numConstraints_ += numConstraints;
+        if (currentBatch_.numManifolds_ + currentBatch_.numConstraints_ > (unsigned)solverInfo_->m_minimumSolverBatchSize)
+            EndBatch();
+    }
+}
+
+void ThreadedDynamicsWorld::EndBatch()
+{
+    if (currentBatch_.numManifolds_ || currentBatch_.numConstraints_)
+        batches_.Push(currentBatch_);
+
+    currentBatch_.bodyStart_ = batchBodies_.Size();
+    currentBatch_.numBodies_ = 0;
+    currentBatch_.manifoldStart_ = batchManifolds_.Size();
+    currentBatch_.numManifolds_ = 0;
+    currentBatch_.constraintStart_ = batchConstraints_.Size();
+    currentBatch_.numConstraints_ = 0;
+}
+
+void ThreadedDynamicsWorld::SolveBatch(const PhysicsSolverBatch& batch, unsigned threadIndex)
+{
+    btCollisionObject** bodies = batch.numBodies_ ? &batchBodies_[batch.bodyStart_] : 0;
+    btPersistentManifold** manifolds = batch.numManifolds_ ? &batchManifolds_[batch.manifoldStart_] : 0;
+    btTypedConstraint** constraints = batch.numConstraints_ ? &batchConstraints_[batch.constraintStart_] : 0;
+
+    // The debug drawer is not thread-safe, so it is not passed to the solver
+    solvers_[threadIndex]->solveGroup(bodies, (int)batch.numBodies_, manifolds, (int)batch.numManifolds_, constraints,
+        (int)batch.numConstraints_, *solverInfo_, 0, m_dispatcher1);
+}
+
+}
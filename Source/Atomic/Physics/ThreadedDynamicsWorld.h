@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+#include <Bullet/src/BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <Bullet/src/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+
+class btSequentialImpulseConstraintSolver;
+
+namespace Atomic
+{
+
+class WorkQueue;
+struct WorkItem;
+
+/// Bullet collision dispatcher which runs the narrowphase of the overlapping pairs in the work queue threads.
+class ThreadedCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+    /// Construct.
+    ThreadedCollisionDispatcher(btCollisionConfiguration* collisionConfiguration);
+
+    /// Set work queue to use, or null to process all pairs in the calling thread.
+    void SetWorkQueue(WorkQueue* queue) { workQueue_ = queue; }
+
+    /// Return work queue.
+    WorkQueue* GetWorkQueue() const { return workQueue_; }
+
+    /// Create a new contact manifold. Thread-safe.
+    virtual btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1);
+    /// Release a contact manifold. Thread-safe.
+    virtual void releaseManifold(btPersistentManifold* manifold);
+    /// Allocate memory for a collision algorithm. Thread-safe.
+    virtual void* allocateCollisionAlgorithm(int size);
+    /// Free memory of a collision algorithm. Thread-safe.
+    virtual void freeCollisionAlgorithm(void* ptr);
+    /// Run the narrowphase for all overlapping pairs.
+    virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher);
+
+private:
+    /// Work queue.
+    WorkQueue* workQueue_;
+    /// Mutex for the manifold and collision algorithm pools.
+    Mutex poolMutex_;
+};
+
+/// Range of simulation islands solved together with one constraint solver call.
+struct PhysicsSolverBatch
+{
+    /// Index of the first body.
+    unsigned bodyStart_;
+    /// Number of bodies.
+    unsigned numBodies_;
+    /// Index of the first contact manifold.
+    unsigned manifoldStart_;
+    /// Number of contact manifolds.
+    unsigned numManifolds_;
+    /// Index of the first constraint.
+    unsigned constraintStart_;
+    /// Number of constraints.
+    unsigned numConstraints_;
+};
+
+/// Bullet dynamics world which solves the simulation islands in the work queue threads.
+class ThreadedDynamicsWorld : public btDiscreteDynamicsWorld
+{
+    friend class ThreadedIslandCallback;
+    friend void SolvePhysicsBatchWork(const WorkItem* item, unsigned threadIndex);
+
+public:
+    /// Construct.
+    ThreadedDynamicsWorld(ThreadedCollisionDispatcher* dispatcher, btBroadphaseInterface* broadphase, btConstraintSolver* solver,
+        btCollisionConfiguration* collisionConfiguration);
+    /// Destruct.
+    virtual ~ThreadedDynamicsWorld();
+
+    /// Set work queue to use for the narrowphase and the constraint solver, or null to simulate in the calling thread only.
+    void SetWorkQueue(WorkQueue* queue);
+    /// Set whether to order the contact manifolds so that the simulation result does not depend on thread timing.
+    void SetDeterministic(bool enable) { deterministic_ = enable; }
+
+    /// Return work queue.
+    WorkQueue* GetWorkQueue() const { return workQueue_; }
+
+    /// Return whether contact manifolds are ordered for a deterministic result.
+    bool GetDeterministic() const { return deterministic_; }
+
+    /// Solve the contacts and constraints of all awake simulation islands.
+    virtual void solveConstraints(btContactSolverInfo& solverInfo);
+
+private:
+    /// Add a simulation island. Called by the island manager.
+    void AddIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId);
+    /// Close the batch being collected and begin a new one.
+    void EndBatch();
+    /// Solve a batch of islands with the solver of the thread.
+    void SolveBatch(const PhysicsSolverBatch& batch, unsigned threadIndex);
+
+    /// Collision dispatcher.
+    ThreadedCollisionDispatcher* threadedDispatcher_;
+    /// Work queue.
+    WorkQueue* workQueue_;
+    /// Constraint solvers per thread. Index 0 is the calling thread.
+    PODVector<btSequentialImpulseConstraintSolver*> solvers_;
+    /// Constraints sorted by island.
+    PODVector<btTypedConstraint*> islandConstraints_;
+    /// Index of the next unassigned constraint while collecting islands.
+    unsigned nextConstraint_;
+    /// Bodies of the batches.
+    PODVector<btCollisionObject*> batchBodies_;
+    /// Contact manifolds of the batches.
+    PODVector<btPersistentManifold*> batchManifolds_;
+    /// Constraints of the batches.
+    PODVector<btTypedConstraint*> batchConstraints_;
+    /// Batches of independent islands, which can be solved in parallel.
+    PODVector<PhysicsSolverBatch> batches_;
+    /// Bodies of the islands which touch kinematic bodies.
+    PODVector<btCollisionObject*> sharedBodies_;
+    /// Contact manifolds of the islands which touch kinematic bodies.
+    PODVector<btPersistentManifold*> sharedManifolds_;
+    /// Constraints of the islands which touch kinematic bodies.
+    PODVector<btTypedConstraint*> sharedConstraints_;
+    /// Batch being collected.
+    PhysicsSolverBatch currentBatch_;
+    /// Solver info for the current step.
+    btContactSolverInfo* solverInfo_;
+    /// Deterministic manifold order flag.
+    bool deterministic_;
+};
+
+}
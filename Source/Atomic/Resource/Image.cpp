@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -208,6 +210,353 @@ struct DDSurfaceDesc2
     unsigned dwTextureStage_;
 };
 
+/// Minimum number of destination pixels before image processing is split to worker threads.
+static const unsigned MIN_PARALLEL_IMAGE_PIXELS = 128 * 128;
+/// Size of the linear to sRGB conversion table.
+static const int LINEAR_TO_SRGB_TABLE_SIZE = 4096;
+
+/// Conversion tables between 8-bit sRGB and linear values.
+struct SRGBTables
+{
+    /// Construct and fill the tables.
+    SRGBTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = (float)i / 255.0f;
+            toLinear_[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; ++i)
+        {
+            float c = (float)i / (float)(LINEAR_TO_SRGB_TABLE_SIZE - 1);
+            float s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+            toSRGB_[i] = (unsigned char)Clamp((int)(s * 255.0f + 0.5f), 0, 255);
+        }
+    }
+
+    /// Convert a linear value to 8-bit sRGB.
+    unsigned char ToSRGB(float value) const
+    {
+        return toSRGB_[Clamp((int)(value * (float)(LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f), 0, LINEAR_TO_SRGB_TABLE_SIZE - 1)];
+    }
+
+    /// 8-bit sRGB to linear table.
+    float toLinear_[256];
+    /// Linear to 8-bit sRGB table.
+    unsigned char toSRGB_[LINEAR_TO_SRGB_TABLE_SIZE];
+};
+
+static const SRGBTables sRGBTables;
+
+/// Return index of the alpha component for a component count, or -1 if none.
+static int GetAlphaComponent(unsigned components)
+{
+    return components == 4 ? 3 : (components == 2 ? 1 : -1);
+}
+
+/// Image row processing function. Called with the job and the row range to process.
+typedef void (*ImageRowFunction)(const void* job, int yStart, int yEnd);
+
+/// Image row processing task shared by the work items.
+struct ImageRowTask
+{
+    /// Row function.
+    ImageRowFunction function_;
+    /// Job data.
+    const void* job_;
+};
+
+static void ProcessImageRowsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const ImageRowTask* task = reinterpret_cast<const ImageRowTask*>(item->aux_);
+    task->function_(task->job_, *reinterpret_cast<const int*>(item->start_), *reinterpret_cast<const int*>(item->end_));
+}
+
+/// Process destination image rows. Split to worker threads when called from the main thread on a large enough image.
+static void ProcessImageRows(Context* context, ImageRowFunction function, const void* job, int numRows, int rowPixels)
+{
+    WorkQueue* queue = context->GetSubsystem<WorkQueue>();
+    int numItems = 1;
+    if (queue && queue->GetNumThreads() && !queue->IsCompleting() && Thread::IsMainThread() &&
+        (unsigned)(numRows * rowPixels) >= MIN_PARALLEL_IMAGE_PIXELS)
+        numItems = Min((int)queue->GetNumThreads() + 1, numRows);
+
+    if (numItems <= 1)
+    {
+        function(job, 0, numRows);
+        return;
+    }
+
+    ImageRowTask task;
+    task.function_ = function;
+    task.job_ = job;
+
+    PODVector<int> rowBounds(numItems + 1);
+    for (int i = 0; i <= numItems; ++i)
+        rowBounds[i] = numRows * i / numItems;
+
+    for (int i = 0; i < numItems; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ProcessImageRowsWork;
+        item->aux_ = &task;
+        item->start_ = &rowBounds[i];
+        item->end_ = &rowBounds[i + 1];
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+/// Evaluate a resampling filter kernel.
+static float EvaluateResampleFilter(ResampleFilter filter, float x)
+{
+    x = Abs(x);
+
+    switch (filter)
+    {
+    case RESAMPLE_BOX:
+        return x <= 0.5f ? 1.0f : 0.0f;
+
+    case RESAMPLE_LANCZOS:
+        if (x < 1e-5f)
+            return 1.0f;
+        if (x >= 3.0f)
+            return 0.0f;
+        return 3.0f * sinf(M_PI * x) * sinf(M_PI * x / 3.0f) / (M_PI * M_PI * x * x);
+
+    default:
+        return Max(1.0f - x, 0.0f);
+    }
+}
+
+/// Return the radius of a resampling filter kernel in source pixels.
+static float GetResampleFilterRadius(ResampleFilter filter)
+{
+    switch (filter)
+    {
+    case RESAMPLE_BOX:
+        return 0.5f;
+
+    case RESAMPLE_LANCZOS:
+        return 3.0f;
+
+    default:
+        return 1.0f;
+    }
+}
+
+/// Precalculated source indices and normalized weights for resampling along one image axis.
+struct ResampleAxis
+{
+    /// Calculate for a source and destination size.
+    void Define(int srcSize, int dstSize, ResampleFilter filter)
+    {
+        // When minifying, widen the kernel so that every source pixel contributes
+        float scale = (float)srcSize / (float)dstSize;
+        float filterScale = Max(scale, 1.0f);
+        float support = GetResampleFilterRadius(filter) * filterScale;
+
+        taps_ = (int)ceilf(support * 2.0f) + 1;
+        indices_.Resize(dstSize * taps_);
+        weights_.Resize(dstSize * taps_);
+
+        // Map the first and last destination pixels to the first and last source pixels, as GetPixelBilinear() sampling did
+        float step = dstSize > 1 ? (float)srcSize / (float)(dstSize - 1) : 0.0f;
+
+        for (int i = 0; i < dstSize; ++i)
+        {
+            float center = Clamp((float)i * step, 0.5f, (float)srcSize - 0.5f);
+            int first = (int)floorf(center - support);
+            int* indices = &indices_[i * taps_];
+            float* weights = &weights_[i * taps_];
+            float total = 0.0f;
+
+            for (int j = 0; j < taps_; ++j)
+            {
+                indices[j] = Clamp(first + j, 0, srcSize - 1);
+                weights[j] = EvaluateResampleFilter(filter, ((float)(first + j) + 0.5f - center) / filterScale);
+                total += weights[j];
+            }
+
+            if (total > 0.0f)
+            {
+                for (int j = 0; j < taps_; ++j)
+                    weights[j] /= total;
+            }
+            else
+            {
+                // Degenerate kernel, fall back to the nearest source pixel
+                for (int j = 0; j < taps_; ++j)
+                    weights[j] = 0.0f;
+                indices[0] = Clamp((int)center, 0, srcSize - 1);
+                weights[0] = 1.0f;
+            }
+        }
+    }
+
+    /// Source pixel indices, taps per destination pixel.
+    PODVector<int> indices_;
+    /// Source pixel weights, taps per destination pixel.
+    PODVector<float> weights_;
+    /// Number of taps per destination pixel.
+    int taps_;
+};
+
+/// Image resize job.
+struct ResizeJob
+{
+    /// Source pixel data.
+    const unsigned char* src_;
+    /// Destination pixel data.
+    unsigned char* dest_;
+    /// Source width.
+    int srcWidth_;
+    /// Destination width.
+    int destWidth_;
+    /// Number of color components.
+    unsigned components_;
+    /// Whether to filter color components in linear space.
+    bool sRGB_;
+    /// Horizontal resampling.
+    ResampleAxis horizontal_;
+    /// Vertical resampling.
+    ResampleAxis vertical_;
+};
+
+static void ResizeRows(const void* jobPtr, int yStart, int yEnd)
+{
+    const ResizeJob& job = *reinterpret_cast<const ResizeJob*>(jobPtr);
+    const unsigned components = job.components_;
+    const int srcRowSize = job.srcWidth_ * components;
+    const int alpha = GetAlphaComponent(components);
+    const int tapsX = job.horizontal_.taps_;
+    const int tapsY = job.vertical_.taps_;
+
+    // Vertically filtered source row, in the same layout as the source
+    PODVector<float> rowBuffer(srcRowSize);
+    float* row = &rowBuffer[0];
+
+    for (int y = yStart; y < yEnd; ++y)
+    {
+        const int* indicesY = &job.vertical_.indices_[y * tapsY];
+        const float* weightsY = &job.vertical_.weights_[y * tapsY];
+
+        for (int i = 0; i < srcRowSize; ++i)
+            row[i] = 0.0f;
+
+        for (int t = 0; t < tapsY; ++t)
+        {
+            const float weight = weightsY[t];
+            if (weight == 0.0f)
+                continue;
+
+            const unsigned char* src = job.src_ + indicesY[t] * srcRowSize;
+            if (!job.sRGB_)
+            {
+                for (int i = 0; i < srcRowSize; ++i)
+                    row[i] += weight * (float)src[i];
+            }
+            else
+            {
+                for (int i = 0; i < srcRowSize; i += components)
+                {
+                    for (unsigned c = 0; c < components; ++c)
+                    {
+                        row[i + c] += weight * ((int)c == alpha ? (float)src[i + c] * (1.0f / 255.0f) :
+                            sRGBTables.toLinear_[src[i + c]]);
+                    }
+                }
+            }
+        }
+
+        unsigned char* dest = job.dest_ + y * job.destWidth_ * components;
+        for (int x = 0; x < job.destWidth_; ++x)
+        {
+            const int* indicesX = &job.horizontal_.indices_[x * tapsX];
+            const float* weightsX = &job.horizontal_.weights_[x * tapsX];
+
+            for (unsigned c = 0; c < components; ++c)
+            {
+                float value = 0.0f;
+                for (int t = 0; t < tapsX; ++t)
+                    value += weightsX[t] * row[indicesX[t] * components + c];
+
+                if (!job.sRGB_)
+                    dest[c] = (unsigned char)Clamp((int)(value + 0.5f), 0, 255);
+                else if ((int)c == alpha)
+                    dest[c] = (unsigned char)Clamp((int)(value * 255.0f + 0.5f), 0, 255);
+                else
+                    dest[c] = sRGBTables.ToSRGB(value);
+            }
+
+            dest += components;
+        }
+    }
+}
+
+/// 2D mip level generation job.
+struct MipLevelJob
+{
+    /// Source pixel data.
+    const unsigned char* src_;
+    /// Destination pixel data.
+    unsigned char* dest_;
+    /// Source width.
+    int srcWidth_;
+    /// Destination width.
+    int destWidth_;
+    /// Whether to average color components in linear space.
+    bool sRGB_;
+};
+
+template <unsigned C> static void MipLevelRows(const void* jobPtr, int yStart, int yEnd)
+{
+    const MipLevelJob& job = *reinterpret_cast<const MipLevelJob*>(jobPtr);
+    const int alpha = GetAlphaComponent(C);
+
+    for (int y = yStart; y < yEnd; ++y)
+    {
+        const unsigned char* inUpper = job.src_ + (y * 2) * job.srcWidth_ * C;
+        const unsigned char* inLower = job.src_ + (y * 2 + 1) * job.srcWidth_ * C;
+        unsigned char* out = job.dest_ + y * job.destWidth_ * C;
+
+        if (!job.sRGB_)
+        {
+            for (int x = 0; x < job.destWidth_ * (int)C; x += C)
+            {
+                for (unsigned c = 0; c < C; ++c)
+                {
+                    out[x + c] = (unsigned char)(((unsigned)inUpper[x * 2 + c] + inUpper[x * 2 + C + c] +
+                                                  inLower[x * 2 + c] + inLower[x * 2 + C + c]) >> 2);
+                }
+            }
+        }
+        else
+        {
+            const float* toLinear = sRGBTables.toLinear_;
+
+            for (int x = 0; x < job.destWidth_ * (int)C; x += C)
+            {
+                for (unsigned c = 0; c < C; ++c)
+                {
+                    if ((int)c == alpha)
+                    {
+                        out[x + c] = (unsigned char)(((unsigned)inUpper[x * 2 + c] + inUpper[x * 2 + C + c] +
+                                                      inLower[x * 2 + c] + inLower[x * 2 + C + c]) >> 2);
+                    }
+                    else
+                    {
+                        out[x + c] = sRGBTables.ToSRGB((toLinear[inUpper[x * 2 + c]] + toLinear[inUpper[x * 2 + C + c]] +
+                                                        toLinear[inLower[x * 2 + c]] + toLinear[inLower[x * 2 + C + c]]) * 0.25f);
+                    }
+                }
+            }
+        }
+    }
+}
+
 bool CompressedLevel::Decompress(unsigned char* dest)
 {
     if (!data_)
@@ -1039,7 +1388,7 @@ bool Image::FlipVertical()
     return true;
 }
 
-bool Image::Resize(int width, int height)
+bool Image::Resize(int width, int height, ResampleFilter filter)
 {
     PROFILE(ResizeImage);
 
@@ -1058,36 +1407,18 @@ bool Image::Resize(int width, int height)
     if (!data_ || width <= 0 || height <= 0)
         return false;
 
-    /// \todo Reducing image size does not sample all needed pixels
     SharedArrayPtr<unsigned char> newData(new unsigned char[width * height * components_]);
-    for (int y = 0; y < height; ++y)
-    {
-        for (int x = 0; x < width; ++x)
-        {
-            // Calculate float coordinates between 0 - 1 for resampling
-            float xF = (width_ > 1) ? (float)x / (float)(width - 1) : 0.0f;
-            float yF = (height_ > 1) ? (float)y / (float)(height - 1) : 0.0f;
-            unsigned uintColor = GetPixelBilinear(xF, yF).ToUInt();
-            unsigned char* dest = newData + (y * width + x) * components_;
-            unsigned char* src = (unsigned char*)&uintColor;
-
-            switch (components_)
-            {
-            case 4:
-                dest[3] = src[3];
-                // Fall through
-            case 3:
-                dest[2] = src[2];
-                // Fall through
-            case 2:
-                dest[1] = src[1];
-                // Fall through
-            default:
-                dest[0] = src[0];
-                break;
-            }
-        }
-    }
+
+    ResizeJob job;
+    job.src_ = data_.Get();
+    job.dest_ = newData.Get();
+    job.srcWidth_ = width_;
+    job.destWidth_ = width;
+    job.components_ = components_;
+    job.sRGB_ = sRGB_;
+    job.horizontal_.Define(width_, width, filter);
+    job.vertical_.Define(height_, height, filter);
+    ProcessImageRows(context_, ResizeRows, &job, height, width);
 
     width_ = width;
     height_ = height;
@@ -1211,6 +1542,15 @@ bool Image::SaveJPG(const String& fileName, int quality) const
         return false;
 }
 
+void Image::SetSRGB(bool enable)
+{
+    // Mip levels calculated so far were filtered in the other color space
+    if (enable != sRGB_)
+        nextLevel_.Reset();
+
+    sRGB_ = enable;
+}
+
 Color Image::GetPixel(int x, int y) const
 {
     return GetPixel(x, y, 0);
@@ -1362,6 +1702,7 @@ SharedPtr<Image> Image::GetNextLevel() const
         mipImage->SetSize(widthOut, heightOut, depthOut, components_);
     else
         mipImage->SetSize(widthOut, heightOut, components_);
+    mipImage->sRGB_ = sRGB_;
 
     const unsigned char* pixelDataIn = data_.Get();
     unsigned char* pixelDataOut = mipImage->data_.Get();
@@ -1415,78 +1756,29 @@ SharedPtr<Image> Image::GetNextLevel() const
     // 2D case
     else if (depth_ == 1)
     {
+        MipLevelJob job;
+        job.src_ = pixelDataIn;
+        job.dest_ = pixelDataOut;
+        job.srcWidth_ = width_;
+        job.destWidth_ = widthOut;
+        job.sRGB_ = sRGB_;
+
         switch (components_)
         {
         case 1:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_];
-                unsigned char* out = &pixelDataOut[y * widthOut];
-
-                for (int x = 0; x < widthOut; ++x)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 1] +
-                                              inLower[x * 2] + inLower[x * 2 + 1]) >> 2);
-                }
-            }
+            ProcessImageRows(context_, MipLevelRows<1>, &job, heightOut, widthOut);
             break;
 
         case 2:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 2];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 2];
-                unsigned char* out = &pixelDataOut[y * widthOut * 2];
-
-                for (int x = 0; x < widthOut * 2; x += 2)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 2] +
-                                              inLower[x * 2] + inLower[x * 2 + 2]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 3] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 3]) >> 2);
-                }
-            }
+            ProcessImageRows(context_, MipLevelRows<2>, &job, heightOut, widthOut);
             break;
 
         case 3:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 3];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 3];
-                unsigned char* out = &pixelDataOut[y * widthOut * 3];
-
-                for (int x = 0; x < widthOut * 3; x += 3)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 3] +
-                                              inLower[x * 2] + inLower[x * 2 + 3]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 4] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 5]) >> 2);
-                }
-            }
+            ProcessImageRows(context_, MipLevelRows<3>, &job, heightOut, widthOut);
             break;
 
         case 4:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 4];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 4];
-                unsigned char* out = &pixelDataOut[y * widthOut * 4];
-
-                for (int x = 0; x < widthOut * 4; x += 4)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 4] +
-                                              inLower[x * 2] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 5]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 6] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 6]) >> 2);
-                    out[x + 3] = (unsigned char)(((unsigned)inUpper[x * 2 + 3] + inUpper[x * 2 + 7] +
-                                                  inLower[x * 2 + 3] + inLower[x * 2 + 7]) >> 2);
-                }
-            }
+            ProcessImageRows(context_, MipLevelRows<4>, &job, heightOut, widthOut);
             break;
 
         default:
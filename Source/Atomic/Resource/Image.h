@@ -47,6 +47,14 @@ enum CompressedFormat
     CF_PVRTC_RGBA_4BPP,
 };
 
+/// Image resampling filters.
+enum ResampleFilter
+{
+    RESAMPLE_BOX = 0,
+    RESAMPLE_BILINEAR,
+    RESAMPLE_LANCZOS
+};
+
 /// Compressed image mip level.
 struct CompressedLevel
 {
@@ -124,8 +132,8 @@ public:
     bool FlipHorizontal();
     /// Flip image vertically. Return true if successful.
     bool FlipVertical();
-    /// Resize image by bilinear resampling. Return true if successful.
-    bool Resize(int width, int height);
+    /// Resize image by separable resampling with the given filter. Large images are processed in worker threads when called from the main thread. Return true if successful.
+    bool Resize(int width, int height, ResampleFilter filter = RESAMPLE_BILINEAR);
     /// Clear the image with a color.
     void Clear(const Color& color);
     /// Clear the image with an integer color. R component is in the 8 lowest bits.
@@ -138,11 +146,13 @@ public:
     bool SaveTGA(const String& fileName) const;
     /// Save in JPG format with compression quality. Return true if successful.
     bool SaveJPG(const String& fileName, int quality) const;
+    /// Set whether the pixel data is sRGB. If so, resizing and mip level generation filter the color components in linear space. Set automatically for sRGB DDS files and by textures whose parameters enable sRGB sampling.
+    void SetSRGB(bool enable);
     /// Whether this texture is detected as a cubemap, only relevant for DDS.
     bool IsCubemap() const { return cubemap_; }
     /// Whether this texture has been detected as a volume, only relevant for DDS.
     bool IsArray() const { return array_; }
-    /// Whether this texture is in sRGB, only relevant for DDS.
+    /// Return whether the pixel data is sRGB.
     bool IsSRGB() const { return sRGB_; }
 
     /// Return a 2D pixel color.
@@ -182,7 +192,7 @@ public:
     /// Return number of compressed mip levels.
     unsigned GetNumCompressedLevels() const { return numCompressedLevels_; }
 
-    /// Return next mip level by bilinear filtering.
+    /// Return next mip level by box filtering. Filters in linear space if the image is sRGB.
     SharedPtr<Image> GetNextLevel() const;
     /// Return the next sibling image of an array or cubemap.
     SharedPtr<Image> GetNextSibling() const { return nextSibling_;  }
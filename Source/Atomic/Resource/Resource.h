@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Core/InternedString.h"
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 
@@ -75,10 +76,10 @@ public:
     void SetAsyncLoadState(AsyncLoadState newState);
 
     /// Return name.
-    const String& GetName() const { return name_; }
+    const String& GetName() const { return name_.GetString(); }
 
     /// Return name hash.
-    StringHash GetNameHash() const { return nameHash_; }
+    StringHash GetNameHash() const { return name_.GetHash(); }
 
     /// Return memory use in bytes, possibly approximate.
     unsigned GetMemoryUse() const { return memoryUse_; }
@@ -90,10 +91,8 @@ public:
     AsyncLoadState GetAsyncLoadState() const { return asyncLoadState_; }
 
 private:
-    /// Name.
-    String name_;
-    /// Name hash.
-    StringHash nameHash_;
+    /// Name, interned so that resources and references by the same name share it.
+    InternedString name_;
     /// Last used timer.
     Timer useTimer_;
     /// Memory use in bytes.
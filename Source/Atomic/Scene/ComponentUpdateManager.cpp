@@ -0,0 +1,282 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Component.h"
+#include "../Scene/ComponentUpdateManager.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Minimum number of components in a group to distribute a threaded update to worker threads.
+static const unsigned MIN_THREADED_UPDATE_COMPONENTS = 16;
+
+/// Work item parameters for a threaded component update.
+struct ComponentUpdateWorkData
+{
+    /// Update function.
+    ComponentUpdateFunction function_;
+    /// Timestep.
+    float timeStep_;
+};
+
+void UpdateComponentsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const ComponentUpdateWorkData& data = *(reinterpret_cast<ComponentUpdateWorkData*>(item->aux_));
+    Component** start = reinterpret_cast<Component**>(item->start_);
+    Component** end = reinterpret_cast<Component**>(item->end_);
+
+    while (start != end)
+    {
+        Component* component = *start;
+        if (component)
+            data.function_(component, data.timeStep_);
+        ++start;
+    }
+}
+
+ComponentUpdateManager::ComponentUpdateManager(Scene* scene) :
+    scene_(scene),
+    updateDepth_(0)
+{
+}
+
+ComponentUpdateManager::~ComponentUpdateManager()
+{
+    for (unsigned i = 0; i < MAX_COMPONENT_UPDATE_PHASES; ++i)
+    {
+        for (PODVector<UpdateGroup*>::Iterator j = groups_[i].Begin(); j != groups_[i].End(); ++j)
+            delete *j;
+    }
+}
+
+void ComponentUpdateManager::AddComponent(Component* component, ComponentUpdatePhase phase, ComponentUpdateFunction function, bool threaded)
+{
+    if (!component || !function)
+        return;
+
+    StringHash type = component->GetType();
+    FlatHashMap<Component*, UpdateGroup*>& componentGroups = componentGroups_[phase];
+    FlatHashMap<Component*, UpdateGroup*>::Iterator i = componentGroups.Find(component);
+    if (i != componentGroups.End())
+    {
+        UpdateGroup* oldGroup = i->second_;
+        if (oldGroup->type_ == type && oldGroup->function_ == function && oldGroup->threaded_ == threaded)
+            return;
+        RemoveFromGroup(oldGroup, component);
+        componentGroups.Erase(i);
+    }
+
+    PODVector<UpdateGroup*>& groups = groups_[phase];
+    UpdateGroup* group = 0;
+    for (PODVector<UpdateGroup*>::Iterator j = groups.Begin(); j != groups.End(); ++j)
+    {
+        if ((*j)->type_ == type && (*j)->function_ == function && (*j)->threaded_ == threaded)
+        {
+            group = *j;
+            break;
+        }
+    }
+
+    if (!group)
+    {
+        group = new UpdateGroup();
+        group->type_ = type;
+        group->function_ = function;
+        group->threaded_ = threaded;
+        group->dirty_ = false;
+        group->numUpdate_ = 0;
+        groups.Push(group);
+    }
+
+    group->indices_.Insert(MakePair(component, group->components_.Size()));
+    group->components_.Push(component);
+    componentGroups.Insert(MakePair(component, group));
+}
+
+void ComponentUpdateManager::RemoveComponent(Component* component, ComponentUpdatePhase phase)
+{
+    FlatHashMap<Component*, UpdateGroup*>& componentGroups = componentGroups_[phase];
+    FlatHashMap<Component*, UpdateGroup*>::Iterator i = componentGroups.Find(component);
+    if (i != componentGroups.End())
+    {
+        RemoveFromGroup(i->second_, component);
+        componentGroups.Erase(i);
+    }
+}
+
+void ComponentUpdateManager::RemoveComponent(Component* component)
+{
+    for (unsigned i = 0; i < MAX_COMPONENT_UPDATE_PHASES; ++i)
+        RemoveComponent(component, (ComponentUpdatePhase)i);
+}
+
+void ComponentUpdateManager::Update(ComponentUpdatePhase phase, float timeStep)
+{
+    PODVector<UpdateGroup*>& groups = groups_[phase];
+    if (groups.Empty())
+        return;
+
+    ++updateDepth_;
+
+    // Components added by the update functions, also to groups not yet updated, wait for the next update
+    unsigned numGroups = groups.Size();
+    for (unsigned i = 0; i < numGroups; ++i)
+        groups[i]->numUpdate_ = groups[i]->components_.Size();
+
+    // Index on each iteration, as groups may be added by the update functions
+    for (unsigned i = 0; i < numGroups; ++i)
+        UpdateComponents(groups[i], timeStep);
+
+    if (!--updateDepth_)
+        CompactGroups();
+}
+
+bool ComponentUpdateManager::HasComponent(Component* component, ComponentUpdatePhase phase) const
+{
+    return componentGroups_[phase].Contains(component);
+}
+
+void ComponentUpdateManager::UpdateComponents(UpdateGroup* group, float timeStep)
+{
+    PODVector<Component*>& components = group->components_;
+    unsigned numComponents = group->numUpdate_;
+    if (!numComponents)
+        return;
+
+    WorkQueue* queue = scene_->GetSubsystem<WorkQueue>();
+    if (group->threaded_ && numComponents >= MIN_THREADED_UPDATE_COMPONENTS && queue && queue->GetNumThreads() &&
+        Thread::IsMainThread() && !scene_->IsThreadedUpdate())
+    {
+        // Notify the scene that a threaded update is going on so that components delay non-threadsafe dirty processing
+        ComponentUpdateWorkData data;
+        data.function_ = group->function_;
+        data.timeStep_ = timeStep;
+
+        scene_->BeginThreadedUpdate();
+
+        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+        int componentsPerItem = Max((int)numComponents / numWorkItems, 1);
+
+        Component** start = &components[0];
+        Component** last = start + numComponents;
+        // Create a work item for each thread
+        for (int i = 0; i < numWorkItems && start != last; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = UpdateComponentsWork;
+            item->aux_ = &data;
+
+            Component** end = last;
+            if (i < numWorkItems - 1 && end - start > componentsPerItem)
+                end = start + componentsPerItem;
+
+            item->start_ = start;
+            item->end_ = end;
+            queue->AddWorkItem(item);
+
+            start = end;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+        scene_->EndThreadedUpdate();
+    }
+    else
+    {
+        // Index on each iteration, as the array may be reallocated by components added during the update
+        for (unsigned i = 0; i < numComponents; ++i)
+        {
+            Component* component = components[i];
+            if (component)
+                group->function_(component, timeStep);
+        }
+    }
+}
+
+void ComponentUpdateManager::RemoveFromGroup(UpdateGroup* group, Component* component)
+{
+    FlatHashMap<Component*, unsigned>::Iterator i = group->indices_.Find(component);
+    if (i == group->indices_.End())
+        return;
+
+    unsigned index = i->second_;
+    group->indices_.Erase(i);
+
+    if (updateDepth_)
+    {
+        // Can not move components while an update may be iterating them
+        group->components_[index] = 0;
+        group->dirty_ = true;
+    }
+    else
+    {
+        // Move the last component into the freed slot
+        unsigned last = group->components_.Size() - 1;
+        if (index != last)
+        {
+            Component* moved = group->components_[last];
+            group->components_[index] = moved;
+            group->indices_[moved] = index;
+        }
+        group->components_.Pop();
+    }
+}
+
+void ComponentUpdateManager::CompactGroups()
+{
+    for (unsigned i = 0; i < MAX_COMPONENT_UPDATE_PHASES; ++i)
+    {
+        for (PODVector<UpdateGroup*>::Iterator j = groups_[i].Begin(); j != groups_[i].End(); ++j)
+        {
+            UpdateGroup* group = *j;
+            if (!group->dirty_)
+                continue;
+
+            PODVector<Component*>& components = group->components_;
+            unsigned dest = 0;
+            for (unsigned k = 0; k < components.Size(); ++k)
+            {
+                if (!components[k])
+                    continue;
+                if (dest != k)
+                {
+                    components[dest] = components[k];
+                    group->indices_[components[dest]] = dest;
+                }
+                ++dest;
+            }
+
+            components.Resize(dest);
+            group->dirty_ = false;
+        }
+    }
+}
+
+}
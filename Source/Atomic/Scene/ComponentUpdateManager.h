@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashMap.h"
+#include "../Math/StringHash.h"
+
+namespace Atomic
+{
+
+class Component;
+class Scene;
+
+/// Component update phase.
+enum ComponentUpdatePhase
+{
+    /// Scene update, variable timestep.
+    COMPONENT_UPDATE = 0,
+    /// Scene post-update, variable timestep.
+    COMPONENT_POSTUPDATE,
+    /// Physics pre-step, fixed timestep.
+    COMPONENT_FIXEDUPDATE,
+    /// Physics post-step, fixed timestep.
+    COMPONENT_FIXEDPOSTUPDATE,
+    MAX_COMPONENT_UPDATE_PHASES
+};
+
+/// Component update function.
+typedef void (*ComponentUpdateFunction)(Component* component, float timeStep);
+
+/// Calls per-frame component updates in bulk instead of through per-component event subscriptions. Components are grouped by type and update function in contiguous arrays. Owned by the Scene.
+class ATOMIC_API ComponentUpdateManager
+{
+public:
+    /// Construct.
+    ComponentUpdateManager(Scene* scene);
+    /// Destruct.
+    ~ComponentUpdateManager();
+
+    /// Add a component to an update phase, or move it to another group if the function or threading mode changes. A threaded component's update function is called from worker threads and must not create or remove objects, send events or access other components' non-threadsafe state.
+    void AddComponent(Component* component, ComponentUpdatePhase phase, ComponentUpdateFunction function, bool threaded = false);
+    /// Remove a component from an update phase.
+    void RemoveComponent(Component* component, ComponentUpdatePhase phase);
+    /// Remove a component from all update phases.
+    void RemoveComponent(Component* component);
+    /// Call the update function of all components in an update phase. Components added during the update are first updated on the next call.
+    void Update(ComponentUpdatePhase phase, float timeStep);
+
+    /// Return whether a component is in an update phase.
+    bool HasComponent(Component* component, ComponentUpdatePhase phase) const;
+    /// Return number of components in an update phase.
+    unsigned GetNumComponents(ComponentUpdatePhase phase) const { return componentGroups_[phase].Size(); }
+
+private:
+    /// Components of one type using the same update function.
+    struct UpdateGroup
+    {
+        /// Component type.
+        StringHash type_;
+        /// Update function.
+        ComponentUpdateFunction function_;
+        /// Threaded update flag.
+        bool threaded_;
+        /// Removed-during-update flag. Null slots are compacted after the update.
+        bool dirty_;
+        /// Number of components at the start of the current update.
+        unsigned numUpdate_;
+        /// Components. Null when removed during the update.
+        PODVector<Component*> components_;
+        /// Component indices.
+        FlatHashMap<Component*, unsigned> indices_;
+    };
+
+    /// Update the components of a group.
+    void UpdateComponents(UpdateGroup* group, float timeStep);
+    /// Remove a component from a group.
+    void RemoveFromGroup(UpdateGroup* group, Component* component);
+    /// Remove null slots from groups after an update.
+    void CompactGroups();
+
+    /// Scene.
+    Scene* scene_;
+    /// Update groups per phase.
+    PODVector<UpdateGroup*> groups_[MAX_COMPONENT_UPDATE_PHASES];
+    /// Group of each component per phase.
+    FlatHashMap<Component*, UpdateGroup*> componentGroups_[MAX_COMPONENT_UPDATE_PHASES];
+    /// Update nesting depth.
+    unsigned updateDepth_;
+};
+
+}
@@ -22,14 +22,8 @@
 
 #include "../Precompiled.h"
 
-#include "../IO/Log.h"
-#ifdef ATOMIC_PHYSICS
-#include "../Physics/PhysicsEvents.h"
-#include "../Physics/PhysicsWorld.h"
-#endif
 #include "../Scene/LogicComponent.h"
 #include "../Scene/Scene.h"
-#include "../Scene/SceneEvents.h"
 
 namespace Atomic
 {
@@ -37,8 +31,8 @@ namespace Atomic
 LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
-    currentEventMask_(0),
-    delayedStartCalled_(false)
+    delayedStartCalled_(false),
+    threadedUpdate_(false)
 {
 }
 
@@ -76,6 +70,15 @@ void LogicComponent::SetUpdateEventMask(unsigned char mask)
     }
 }
 
+void LogicComponent::SetThreadedUpdate(bool enable)
+{
+    if (threadedUpdate_ != enable)
+    {
+        threadedUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -92,18 +95,9 @@ void LogicComponent::OnNodeSet(Node* node)
 
 void LogicComponent::OnSceneSet(Scene* scene)
 {
+    // The scene removes the component from its batched updates when the component is removed
     if (scene)
         UpdateEventSubscription();
-    else
-    {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
-#ifdef ATOMIC_PHYSICS
-        UnsubscribeFromEvent(E_PHYSICSPRESTEP);
-        UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
-#endif
-        currentEventMask_ = 0;
-    }
 }
 
 void LogicComponent::UpdateEventSubscription()
@@ -112,112 +106,68 @@ void LogicComponent::UpdateEventSubscription()
     if (!scene)
         return;
 
+    ComponentUpdateManager& manager = scene->GetComponentUpdateManager();
     bool enabled = IsEnabledEffective();
+    // Delayed start may not be threadsafe, so do the first update in the main thread
+    bool threaded = threadedUpdate_ && delayedStartCalled_;
 
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, HANDLER(LogicComponent, HandleSceneUpdate));
-        currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~USE_UPDATE;
-    }
-
-    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(LogicComponent, HandleScenePostUpdate));
-        currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~USE_POSTUPDATE;
-    }
+    if (enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_))
+        manager.AddComponent(this, COMPONENT_UPDATE, CallUpdate, threaded);
+    else
+        manager.RemoveComponent(this, COMPONENT_UPDATE);
 
-#ifdef ATOMIC_PHYSICS
-    PhysicsWorld* world = scene->GetComponent<PhysicsWorld>();
-    if (!world)
-        return;
+    if (enabled && (updateEventMask_ & USE_POSTUPDATE))
+        manager.AddComponent(this, COMPONENT_POSTUPDATE, CallPostUpdate, threaded);
+    else
+        manager.RemoveComponent(this, COMPONENT_POSTUPDATE);
 
-    bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, HANDLER(LogicComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= USE_FIXEDUPDATE;
-    }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~USE_FIXEDUPDATE;
-    }
+    if (enabled && (updateEventMask_ & USE_FIXEDUPDATE))
+        manager.AddComponent(this, COMPONENT_FIXEDUPDATE, CallFixedUpdate, threaded);
+    else
+        manager.RemoveComponent(this, COMPONENT_FIXEDUPDATE);
 
-    bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
-    if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, HANDLER(LogicComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= USE_FIXEDPOSTUPDATE;
-    }
-    else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~USE_FIXEDPOSTUPDATE;
-    }
-#endif
+    if (enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE))
+        manager.AddComponent(this, COMPONENT_FIXEDPOSTUPDATE, CallFixedPostUpdate, threaded);
+    else
+        manager.RemoveComponent(this, COMPONENT_FIXEDPOSTUPDATE);
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::CallUpdate(Component* component, float timeStep)
 {
-    using namespace SceneUpdate;
+    LogicComponent* logic = static_cast<LogicComponent*>(component);
 
     // Execute user-defined delayed start function before first update
-    if (!delayedStartCalled_)
+    if (!logic->delayedStartCalled_)
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
-
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
+        logic->DelayedStart();
+        logic->delayedStartCalled_ = true;
+
+        // Remove from update if did not need actual updates, or move to threaded update
+        logic->UpdateEventSubscription();
+        if (!(logic->updateEventMask_ & USE_UPDATE))
             return;
-        }
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    logic->Update(timeStep);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::CallPostUpdate(Component* component, float timeStep)
 {
-    using namespace ScenePostUpdate;
-
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    static_cast<LogicComponent*>(component)->PostUpdate(timeStep);
 }
 
-#ifdef ATOMIC_PHYSICS
-
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::CallFixedUpdate(Component* component, float timeStep)
 {
-    using namespace PhysicsPreStep;
-
     // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
+    static_cast<LogicComponent*>(component)->FixedUpdate(timeStep);
 }
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::CallFixedPostUpdate(Component* component, float timeStep)
 {
-    using namespace PhysicsPostStep;
-
     // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    static_cast<LogicComponent*>(component)->FixedPostUpdate(timeStep);
 }
 
-#endif
-
 }
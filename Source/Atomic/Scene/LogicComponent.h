@@ -36,7 +36,7 @@ static const unsigned char USE_FIXEDUPDATE = 0x4;
 /// Bitmask for using the physics post-update event.
 static const unsigned char USE_FIXEDPOSTUPDATE = 0x8;
 
-/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
+/// Helper base class for user-defined game logic components that is updated by the scene's ComponentUpdateManager and forwards the updates to virtual functions similar to ScriptInstance class.
 class ATOMIC_API LogicComponent : public Component
 {
     OBJECT(LogicComponent);
@@ -70,9 +70,15 @@ class ATOMIC_API LogicComponent : public Component
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(unsigned char mask);
 
+    /// Set whether the update functions may be called from worker threads. Use only if the overridden update functions do not create or remove objects, send events or modify other components. DelayedStart() is always called from the main thread.
+    void SetThreadedUpdate(bool enable);
+
     /// Return what update events are subscribed to.
     unsigned char GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Return whether the update functions may be called from worker threads.
+    bool GetThreadedUpdate() const { return threadedUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -83,24 +89,23 @@ protected:
     virtual void OnSceneSet(Scene* scene);
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene's batched updates based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-#ifdef ATOMIC_PHYSICS
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
-#endif
+    /// Call delayed start and scene update. Used as the batched update function.
+    static void CallUpdate(Component* component, float timeStep);
+    /// Call scene post-update.
+    static void CallPostUpdate(Component* component, float timeStep);
+    /// Call physics update.
+    static void CallFixedUpdate(Component* component, float timeStep);
+    /// Call physics post-update.
+    static void CallFixedPostUpdate(Component* component, float timeStep);
+
     /// Requested event subscription mask.
     unsigned char updateEventMask_;
-    /// Current event subscription mask.
-    unsigned char currentEventMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Threaded update flag.
+    bool threadedUpdate_;
 };
 
 }
@@ -25,6 +25,7 @@
 #include "../Container/HashSet.h"
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
+#include "../Scene/ComponentUpdateManager.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
 
@@ -197,6 +198,8 @@ public:
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
+    /// Return the manager for batched component updates.
+    ComponentUpdateManager& GetComponentUpdateManager() { return updateManager_; }
 
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
@@ -271,6 +274,8 @@ private:
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    /// Batched component updates.
+    ComponentUpdateManager updateManager_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
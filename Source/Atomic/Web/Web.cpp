@@ -42,7 +42,13 @@ namespace Atomic
 struct WebPrivate
 {
 #ifndef EMSCRIPTEN
+    WebPrivate() :
+        requestPool(&service)
+    {
+    }
+
     asio::io_service service;
+    WebRequestPool requestPool;
 #endif
 };
 
@@ -73,7 +79,7 @@ SharedPtr<WebRequest> Web::MakeWebRequest(const String& url, const String& verb,
     PROFILE(MakeWebRequest);
 
     // The initialization of the request will take time, can not know at this point if it has an error or not
-    SharedPtr<WebRequest> request(new WebRequest(url, verb, headers, postData));
+    SharedPtr<WebRequest> request(new WebRequest(context_, url, verb, headers, postData));
     return request;
 }
 
@@ -89,4 +95,63 @@ SharedPtr<WebSocket> Web::MakeWebSocket(const String& url)
   return webSocket;
 }
 
+WebRequestPool* Web::GetRequestPool() const
+{
+#ifndef EMSCRIPTEN
+    return &d->requestPool;
+#else
+    return 0;
+#endif
+}
+
+void Web::SetMaxConnections(unsigned maxConnections)
+{
+#ifndef EMSCRIPTEN
+    d->requestPool.SetMaxConnections(maxConnections);
+#endif
+}
+
+void Web::SetMaxIdleConnections(unsigned maxIdleConnections)
+{
+#ifndef EMSCRIPTEN
+    d->requestPool.SetMaxIdleConnections(maxIdleConnections);
+#endif
+}
+
+unsigned Web::GetMaxConnections() const
+{
+#ifndef EMSCRIPTEN
+    return d->requestPool.GetMaxConnections();
+#else
+    return 0;
+#endif
+}
+
+unsigned Web::GetMaxIdleConnections() const
+{
+#ifndef EMSCRIPTEN
+    return d->requestPool.GetMaxIdleConnections();
+#else
+    return 0;
+#endif
+}
+
+unsigned Web::GetNumActiveRequests() const
+{
+#ifndef EMSCRIPTEN
+    return d->requestPool.GetNumActiveRequests();
+#else
+    return 0;
+#endif
+}
+
+unsigned Web::GetNumQueuedRequests() const
+{
+#ifndef EMSCRIPTEN
+    return d->requestPool.GetNumQueuedRequests();
+#else
+    return 0;
+#endif
+}
+
 }
@@ -30,6 +30,7 @@ namespace Atomic
 {
 
 class WebRequest;
+class WebRequestPool;
 class WebSocket;
 
 struct WebPrivate;
@@ -39,21 +40,39 @@ class ATOMIC_API Web : public Object
 {
     OBJECT(Web);
 
+    friend class WebRequest;
+
 public:
     /// Construct.
     Web(Context* context);
     /// Destruct.
     ~Web();
 
-    /// Perform an HTTP request to the specified URL. Empty verb defaults to a GET request. Return a request object which can be used to read the response data.
+    /// Perform an HTTP request to the specified URL. Empty verb defaults to a GET request. The request is queued if the maximum number of connections is in use. Return a request object which can be used to read the response data.
     SharedPtr<WebRequest> MakeWebRequest
         (const String& url, const String& verb = String::EMPTY, const Vector<String>& headers = Vector<String>(),
             const String& postData = String::EMPTY);
     /// Perform an WebSocket request to the specified URL. Return a WebSocket object which can be used to comunicate with the server.
     SharedPtr<WebSocket> MakeWebSocket(const String& url);
 
+    /// Set maximum number of HTTP requests in progress at the same time, at least 1. Default 8.
+    void SetMaxConnections(unsigned maxConnections);
+    /// Set maximum number of idle HTTP connections kept alive per host for reuse. Default 2.
+    void SetMaxIdleConnections(unsigned maxIdleConnections);
+
+    /// Return maximum number of HTTP requests in progress at the same time.
+    unsigned GetMaxConnections() const;
+    /// Return maximum number of idle HTTP connections kept alive per host.
+    unsigned GetMaxIdleConnections() const;
+    /// Return number of HTTP requests in progress.
+    unsigned GetNumActiveRequests() const;
+    /// Return number of HTTP requests waiting for a connection.
+    unsigned GetNumQueuedRequests() const;
+
 private:
     void internalUpdate(StringHash eventType, VariantMap& eventData);
+    /// Return the connection pool that runs the HTTP requests. Null if not supported on the platform.
+    WebRequestPool* GetRequestPool() const;
     WebPrivate *d;
 };
 
@@ -25,242 +25,627 @@
 
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
+#include "../Web/Web.h"
 #include "../Web/WebRequest.h"
 
-#include "../DebugNew.h"
-
-// !!! WARNING! Use HttpRequest from Network if you don't want your interface
-//              to change. This file mimics HttpRequest for now, but will be
-//              changing, and it is here as a placeholder only!
-
 #ifdef EMSCRIPTEN
 
-// Add code to use an XMLHttpRequest or ActiveX XMLHttpRequest here.
+#include "../DebugNew.h"
 
 #else
 
-#include <Civetweb/include/civetweb.h>
+#include "../Web/WebInternalConfig.h"
+#include <asio/connect.hpp>
+#include <asio/io_service.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/write.hpp>
+#include <functional>
+#include "../DebugNew.h"
 
+using std::placeholders::_1;
+using std::placeholders::_2;
 
 namespace Atomic
 {
 
-static const unsigned ERROR_BUFFER_SIZE = 256;
-static const unsigned READ_BUFFER_SIZE = 65536; // Must be a power of two
-
-WebRequest::WebRequest(const String& url, const String& verb, const Vector<String>& headers, const String& postData) :
-    url_(url.Trimmed()),
-    verb_(!verb.Empty() ? verb : "GET"),
-    headers_(headers),
-    postData_(postData),
-    state_(HTTP_INITIALIZING),
-    httpReadBuffer_(new unsigned char[READ_BUFFER_SIZE]),
-    readBuffer_(new unsigned char[READ_BUFFER_SIZE]),
-    readPosition_(0),
-    writePosition_(0)
-{
-    // Size of response is unknown, so just set maximum value. The position will also be changed
-    // to maximum value once the request is done, signaling end for Deserializer::IsEof().
-    size_ = M_MAX_UNSIGNED;
+static const unsigned READ_BUFFER_SIZE = 65536;
+static const unsigned MAX_HEADER_SIZE = 65536;
+static const unsigned DEFAULT_MAX_CONNECTIONS = 8;
+static const unsigned DEFAULT_MAX_IDLE_CONNECTIONS = 2;
 
-    LOGERROR("DO NOT USE WebRequest YET! Use the Network subsystem's HttpRequest. The WebRequest interface is under development and will change soon!");
-    LOGDEBUG("HTTP " + verb_ + " request to URL " + url_);
+/// Connection to an HTTP server, kept alive between requests to the same host.
+struct WebConnection
+{
+    WebConnection(asio::io_service& service, const String& hostKey_) :
+        socket(service),
+        hostKey(hostKey_)
+    {
+    }
 
-    // Start the worker thread to actually create the connection and read the response data.
-    Run();
-}
+    /// Socket.
+    asio::ip::tcp::socket socket;
+    /// Host and port the socket is connected to.
+    String hostKey;
+};
 
-WebRequest::~WebRequest()
+/// Decoding stage of a chunked response body.
+enum WebChunkStage
 {
-    Stop();
-}
+    CHUNK_SIZE = 0,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    CHUNK_TRAILER
+};
 
-void WebRequest::ThreadFunction()
+struct WebRequestInternalState : public std::enable_shared_from_this<WebRequestInternalState>
 {
-    String protocol = "http";
+    /// The WebRequest external state.
+    WebRequest* es;
+    /// Connection pool running the request. Null when not queued or already released.
+    WebRequestPool* pool;
+    /// URL.
+    String url;
+    /// Verb.
+    String verb;
+    /// Error string. Empty if no error.
+    String error;
+    /// Connection state.
+    WebRequestState state;
+    /// Host name.
     String host;
-    String path = "/";
-    int port = 80;
+    /// Port.
+    String port;
+    /// Host and port, the key of reusable connections.
+    String hostKey;
+    /// Serialized request.
+    std::string requestData;
+    /// Resolver of the host name.
+    std::shared_ptr<asio::ip::tcp::resolver> resolver;
+    /// Connection.
+    std::shared_ptr<WebConnection> connection;
+    /// Whether the connection was an idle keep-alive connection.
+    bool reusedConnection;
+    /// Buffer the socket reads into.
+    SharedArrayPtr<unsigned char> readBuffer;
+    /// Response bytes received.
+    unsigned numReceived;
+    /// Response status line and headers until the empty line.
+    String headerData;
+    /// Whether the response headers have been received.
+    bool headersDone;
+    /// Response status code.
+    int statusCode;
+    /// Response headers by lowercase name.
+    HashMap<String, String> responseHeaders;
+    /// Whether the connection can be kept alive after the response.
+    bool keepAlive;
+    /// Whether the body uses chunked transfer encoding.
+    bool chunked;
+    /// Body length from Content-Length, or M_MAX_UNSIGNED to read until the server closes the connection.
+    unsigned contentLength;
+    /// Body bytes received, or bytes left in the current chunk when chunked.
+    unsigned bodyReceived;
+    /// Chunked decoding stage.
+    WebChunkStage chunkStage;
+    /// Partial chunk size or trailer line.
+    String chunkLine;
+
+    WebRequestInternalState(WebRequest* es_) :
+        es(es_),
+        pool(0),
+        state(HTTP_INITIALIZING),
+        reusedConnection(false),
+        readBuffer(new unsigned char[READ_BUFFER_SIZE]),
+        numReceived(0),
+        headersDone(false),
+        statusCode(0),
+        keepAlive(false),
+        chunked(false),
+        contentLength(M_MAX_UNSIGNED),
+        bodyReceived(0),
+        chunkStage(CHUNK_SIZE)
+    {
+    }
 
-    unsigned protocolEnd = url_.Find("://");
-    if (protocolEnd != String::NPOS)
+    bool Done() const
     {
-        protocol = url_.Substring(0, protocolEnd);
-        host = url_.Substring(protocolEnd + 3);
+        return state == HTTP_ERROR || state == HTTP_CLOSED;
     }
-    else
-        host = url_;
 
-    unsigned pathStart = host.Find('/');
-    if (pathStart != String::NPOS)
+    bool Prepare(const Vector<String>& headers, const String& postData)
+    {
+        String protocol = "http";
+        String path = "/";
+
+        unsigned protocolEnd = url.Find("://");
+        if (protocolEnd != String::NPOS)
+        {
+            protocol = url.Substring(0, protocolEnd);
+            host = url.Substring(protocolEnd + 3);
+        }
+        else
+            host = url;
+
+        if (protocol.Compare("http", false))
+        {
+            state = HTTP_ERROR;
+            error = "Unsupported protocol " + protocol;
+            return false;
+        }
+
+        unsigned pathStart = host.Find('/');
+        if (pathStart != String::NPOS)
+        {
+            path = host.Substring(pathStart);
+            host = host.Substring(0, pathStart);
+        }
+
+        port = "80";
+        unsigned portStart = host.Find(':');
+        if (portStart != String::NPOS)
+        {
+            port = host.Substring(portStart + 1);
+            host = host.Substring(0, portStart);
+        }
+
+        hostKey = host + ":" + port;
+
+        String request = verb + " " + path + " HTTP/1.1\r\n";
+        request += "Host: " + (port == "80" ? host : hostKey) + "\r\n";
+        for (unsigned i = 0; i < headers.Size(); ++i)
+        {
+            // Trim and only add non-empty header strings
+            String header = headers[i].Trimmed();
+            if (header.Length())
+                request += header + "\r\n";
+        }
+        if (!postData.Empty())
+            request += "Content-Length: " + String(postData.Length()) + "\r\n";
+        request += "\r\n";
+        request += postData;
+
+        requestData.assign(request.CString(), request.Length());
+        return true;
+    }
+
+    void Start()
     {
-        path = host.Substring(pathStart);
-        host = host.Substring(0, pathStart);
+        connection = pool->TakeIdleConnection(hostKey);
+        reusedConnection = connection != 0;
+        if (connection)
+            Write();
+        else
+            Connect();
     }
 
-    unsigned portStart = host.Find(':');
-    if (portStart != String::NPOS)
+    void Connect()
     {
-        port = ToInt(host.Substring(portStart + 1));
-        host = host.Substring(0, portStart);
+        resolver.reset(new asio::ip::tcp::resolver(*pool->GetService()));
+        asio::ip::tcp::resolver::query query(host.CString(), port.CString());
+        resolver->async_resolve(query, std::bind(&WebRequestInternalState::OnResolve, shared_from_this(), _1, _2));
     }
 
-    char errorBuffer[ERROR_BUFFER_SIZE];
-    memset(errorBuffer, 0, sizeof(errorBuffer));
+    void OnResolve(const asio::error_code& ec, asio::ip::tcp::resolver::iterator endpoints)
+    {
+        resolver.reset();
+        if (Done())
+            return;
+        if (ec)
+        {
+            Fail(ec.message().c_str());
+            return;
+        }
+
+        connection.reset(new WebConnection(*pool->GetService(), hostKey));
+        asio::async_connect(connection->socket, endpoints, std::bind(&WebRequestInternalState::OnConnect, shared_from_this(), _1));
+    }
 
-    String headersStr;
-    for (unsigned i = 0; i < headers_.Size(); ++i)
+    void OnConnect(const asio::error_code& ec)
     {
-        // Trim and only add non-empty header strings
-        String header = headers_[i].Trimmed();
-        if (header.Length())
-            headersStr += header + "\r\n";
+        if (Done())
+            return;
+        if (ec)
+        {
+            Fail(ec.message().c_str());
+            return;
+        }
+
+        Write();
     }
 
-    // Initiate the connection. This may block due to DNS query
-    /// \todo SSL mode will not actually work unless Civetweb's SSL mode is initialized with an external SSL DLL
-    mg_connection* connection = 0;
-    if (postData_.Empty())
+    void Write()
     {
-        connection = mg_download(host.CString(), port, protocol.Compare("https", false) ? 0 : 1, errorBuffer, sizeof(errorBuffer),
-            "%s %s HTTP/1.1\r\n"
-            "Host: %s\r\n"
-            "Connection: close\r\n"
-            "%s"
-            "\r\n", verb_.CString(), path.CString(), host.CString(), headersStr.CString());
+        asio::async_write(connection->socket, asio::buffer(requestData), std::bind(&WebRequestInternalState::OnWrite, shared_from_this(), _1));
     }
-    else
+
+    void OnWrite(const asio::error_code& ec)
     {
-        connection = mg_download(host.CString(), port, protocol.Compare("https", false) ? 0 : 1, errorBuffer, sizeof(errorBuffer),
-            "%s %s HTTP/1.1\r\n"
-            "Host: %s\r\n"
-            "Connection: close\r\n"
-            "%s"
-            "Content-Length: %d\r\n"
-            "\r\n"
-            "%s", verb_.CString(), path.CString(), host.CString(), headersStr.CString(), postData_.Length(), postData_.CString());
+        if (Done())
+            return;
+        if (ec)
+        {
+            if (!Retry())
+                Fail(ec.message().c_str());
+            return;
+        }
+
+        Read();
     }
 
+    void Read()
     {
-        MutexLock lock(mutex_);
-        state_ = connection ? HTTP_OPEN : HTTP_ERROR;
+        connection->socket.async_read_some(asio::buffer(readBuffer.Get(), READ_BUFFER_SIZE),
+            std::bind(&WebRequestInternalState::OnRead, shared_from_this(), _1, _2));
+    }
 
-        // If no connection could be made, store the error and exit
-        if (state_ == HTTP_ERROR)
+    void OnRead(const asio::error_code& ec, std::size_t size)
+    {
+        if (Done())
+            return;
+        if (ec)
         {
-            error_ = String(&errorBuffer[0]);
+            if (Retry())
+                return;
+
+            // Without a length the body ends when the server closes the connection
+            if (ec == asio::error::eof && headersDone && !chunked && contentLength == M_MAX_UNSIGNED)
+                Finish();
+            else
+                Fail(ec == asio::error::eof ? "Connection closed by server" : ec.message().c_str());
             return;
         }
+
+        numReceived += (unsigned)size;
+        if (Receive((unsigned)size))
+            Read();
     }
 
-    // Loop while should run, read data from the connection, copy to the main thread buffer if there is space
-    while (shouldRun_)
+    /// Return whether the request may be sent again without side effects.
+    bool IsIdempotent() const
     {
-        // Read less than full buffer to be able to distinguish between full and empty ring buffer. Reading may block
-        int bytesRead = mg_read(connection, httpReadBuffer_.Get(), READ_BUFFER_SIZE / 4);
-        if (bytesRead <= 0)
-            break;
+        String upperVerb = verb.ToUpper();
+        return upperVerb == "GET" || upperVerb == "HEAD" || upperVerb == "OPTIONS" || upperVerb == "PUT" ||
+            upperVerb == "DELETE";
+    }
+
+    bool Retry()
+    {
+        // A server may close an idle keep-alive connection at any time, retry once on a new connection.
+        // The server may have processed the request before closing, so only retry idempotent verbs
+        if (!reusedConnection || numReceived || !IsIdempotent())
+            return false;
+
+        LOGDEBUG("WebRequest retrying on a new connection to " + hostKey);
+        connection.reset();
+        reusedConnection = false;
+        Connect();
+        return true;
+    }
 
-        mutex_.Acquire();
+    /// Handle received bytes in the read buffer. Return true to continue reading.
+    bool Receive(unsigned size)
+    {
+        const char* data = (const char*)readBuffer.Get();
+        if (headersDone)
+            return ReceiveBody(data, size, true);
+
+        return ReceiveHeaders(data, size);
+    }
 
-        // Wait until enough space in the main thread's ring buffer
-        for (;;)
+    /// Handle received header bytes, followed by the start of the body if the headers are complete. Return true to continue reading.
+    bool ReceiveHeaders(const char* data, unsigned size)
+    {
+        unsigned oldLength = headerData.Length();
+        headerData.Append(data, size);
+
+        // The separator may have been split between reads
+        unsigned headerEnd = headerData.Find("\r\n\r\n", oldLength >= 3 ? oldLength - 3 : 0);
+        if (headerEnd == String::NPOS)
         {
-            unsigned spaceInBuffer = READ_BUFFER_SIZE - ((writePosition_ - readPosition_) & (READ_BUFFER_SIZE - 1));
-            if ((int)spaceInBuffer > bytesRead || !shouldRun_)
-                break;
+            if (headerData.Length() > MAX_HEADER_SIZE)
+            {
+                Fail("Response headers too large");
+                return false;
+            }
+            return true;
+        }
+
+        unsigned bodyStart = headerEnd + 4 - oldLength;
+        headerData.Resize(headerEnd);
+        if (!ParseHeaders())
+            return false;
 
-            mutex_.Release();
-            Time::Sleep(5);
-            mutex_.Acquire();
+        // After an interim response the final response follows
+        if (!headersDone)
+            return ReceiveHeaders(data + bodyStart, size - bodyStart);
+
+        return ReceiveBody(data + bodyStart, size - bodyStart, false);
+    }
+
+    bool ParseHeaders()
+    {
+        Vector<String> lines = headerData.Split('\n');
+        Vector<String> status = lines.Size() ? lines[0].Trimmed().Split(' ') : Vector<String>();
+        if (status.Size() < 2 || !status[0].StartsWith("HTTP/"))
+        {
+            Fail("Malformed response");
+            return false;
         }
 
-        if (!shouldRun_)
+        statusCode = ToInt(status[1]);
+
+        // Discard interim responses such as 100 Continue. 101 Switching Protocols is final, as the connection is not HTTP after it
+        if (statusCode / 100 == 1 && statusCode != 101)
         {
-            mutex_.Release();
-            break;
+            statusCode = 0;
+            headerData.Clear();
+            return true;
         }
 
-        if (writePosition_ + bytesRead <= READ_BUFFER_SIZE)
-            memcpy(readBuffer_.Get() + writePosition_, httpReadBuffer_.Get(), (size_t)bytesRead);
-        else
+        keepAlive = status[0] != "HTTP/1.0";
+
+        for (unsigned i = 1; i < lines.Size(); ++i)
+        {
+            unsigned colon = lines[i].Find(':');
+            if (colon != String::NPOS)
+                responseHeaders[lines[i].Substring(0, colon).Trimmed().ToLower()] = lines[i].Substring(colon + 1).Trimmed();
+        }
+        headerData.Clear();
+
+        HashMap<String, String>::ConstIterator i = responseHeaders.Find("connection");
+        if (i != responseHeaders.End())
         {
-            // Handle ring buffer wrap
-            unsigned part1 = READ_BUFFER_SIZE - writePosition_;
-            unsigned part2 = bytesRead - part1;
-            memcpy(readBuffer_.Get() + writePosition_, httpReadBuffer_.Get(), part1);
-            memcpy(readBuffer_.Get(), httpReadBuffer_.Get() + part1, part2);
+            if (i->second_.Contains("close", false))
+                keepAlive = false;
+            else if (i->second_.Contains("keep-alive", false))
+                keepAlive = true;
         }
 
-        writePosition_ += bytesRead;
-        writePosition_ &= READ_BUFFER_SIZE - 1;
+        i = responseHeaders.Find("transfer-encoding");
+        chunked = i != responseHeaders.End() && i->second_.Contains("chunked", false);
+        if (!chunked)
+        {
+            i = responseHeaders.Find("content-length");
+            if (i != responseHeaders.End())
+                contentLength = ToUInt(i->second_);
+        }
 
-        mutex_.Release();
+        // These responses never have a body
+        if (verb == "HEAD" || statusCode == 204 || statusCode == 304 || statusCode / 100 == 1)
+        {
+            chunked = false;
+            contentLength = 0;
+        }
+
+        if (!chunked && contentLength == M_MAX_UNSIGNED)
+            keepAlive = false;
+
+        headersDone = true;
+        state = HTTP_OPEN;
+        return true;
     }
 
-    // Close the connection
-    mg_close_connection(connection);
+    /// Handle received body bytes. Return true to continue reading.
+    bool ReceiveBody(const char* data, unsigned size, bool wholeBuffer)
+    {
+        if (chunked)
+            return ReceiveChunked(data, size);
 
+        // Ignore anything the server sends past the content length
+        if (contentLength != M_MAX_UNSIGNED && size > contentLength - bodyReceived)
+            size = contentLength - bodyReceived;
+
+        if (size)
+        {
+            bodyReceived += size;
+            Deliver(data, size, wholeBuffer);
+        }
+
+        if (bodyReceived == contentLength)
+        {
+            Finish();
+            return false;
+        }
+
+        return true;
+    }
+
+    /// Decode chunked body bytes. Return true to continue reading.
+    bool ReceiveChunked(const char* data, unsigned size)
     {
-        MutexLock lock(mutex_);
-        state_ = HTTP_CLOSED;
+        while (size)
+        {
+            switch (chunkStage)
+            {
+            case CHUNK_SIZE:
+            case CHUNK_TRAILER:
+                {
+                    const char* lineEnd = (const char*)memchr(data, '\n', size);
+                    unsigned length = lineEnd ? (unsigned)(lineEnd - data) + 1 : size;
+                    chunkLine.Append(data, length);
+                    data += length;
+                    size -= length;
+
+                    if (!lineEnd)
+                    {
+                        if (chunkLine.Length() > MAX_HEADER_SIZE)
+                        {
+                            Fail("Malformed chunked response");
+                            return false;
+                        }
+                        break;
+                    }
+
+                    String line = chunkLine.Trimmed();
+                    chunkLine.Clear();
+
+                    if (chunkStage == CHUNK_TRAILER)
+                    {
+                        // The trailer headers end with an empty line
+                        if (line.Empty())
+                        {
+                            Finish();
+                            return false;
+                        }
+                    }
+                    else
+                    {
+                        // Chunk extensions are ignored
+                        unsigned extension = line.Find(';');
+                        if (extension != String::NPOS)
+                            line = line.Substring(0, extension).Trimmed();
+                        bodyReceived = (unsigned)strtoul(line.CString(), 0, 16);
+                        chunkStage = bodyReceived ? CHUNK_DATA : CHUNK_TRAILER;
+                    }
+                }
+                break;
+
+            case CHUNK_DATA:
+                {
+                    unsigned length = size < bodyReceived ? size : bodyReceived;
+                    Deliver(data, length, false);
+                    data += length;
+                    size -= length;
+                    bodyReceived -= length;
+                    if (!bodyReceived)
+                        chunkStage = CHUNK_DATA_END;
+                }
+                break;
+
+            case CHUNK_DATA_END:
+                // Skip the line break after the chunk data
+                if (*data == '\n')
+                    chunkStage = CHUNK_SIZE;
+                ++data;
+                --size;
+                break;
+            }
+        }
+
+        return true;
     }
-}
 
-unsigned WebRequest::Read(void* dest, unsigned size)
-{
-    mutex_.Acquire();
+    void Deliver(const char* data, unsigned size, bool wholeBuffer)
+    {
+        if (!es)
+            return;
 
-    unsigned char* destPtr = (unsigned char*)dest;
-    unsigned sizeLeft = size;
-    unsigned totalRead = 0;
+        // Hand large reads over to the buffer queue as they are instead of copying
+        if (wholeBuffer && size >= READ_BUFFER_SIZE / 2)
+        {
+            es->readBuffer_->Write(readBuffer, size);
+            readBuffer = new unsigned char[READ_BUFFER_SIZE];
+        }
+        else
+            es->readBuffer_->Write(data, size);
+    }
 
-    for (;;)
+    void Finish()
     {
-        unsigned bytesAvailable;
+        state = HTTP_CLOSED;
+        LOGDEBUG("WebRequest finished " + url);
+
+        std::shared_ptr<WebConnection> reusable;
+        if (keepAlive)
+            reusable = connection;
+        connection.reset();
+        Release(reusable);
 
-        for (;;)
+        if (es)
         {
-            bytesAvailable = CheckEofAndAvailableSize();
-            if (bytesAvailable || IsEof())
-                break;
-            // While no bytes and connection is still open, block until has some data
-            mutex_.Release();
-            Time::Sleep(5);
-            mutex_.Acquire();
+            es->CheckEof();
+            es->SendEvent("complete");
         }
+    }
 
-        if (bytesAvailable)
+    void Fail(const String& message)
+    {
+        Abort(message);
+        LOGDEBUG("WebRequest error: " + error);
+
+        if (es)
         {
-            if (bytesAvailable > sizeLeft)
-                bytesAvailable = sizeLeft;
+            es->CheckEof();
+            es->SendEvent("error");
+        }
+    }
 
-            if (readPosition_ + bytesAvailable <= READ_BUFFER_SIZE)
-                memcpy(destPtr, readBuffer_.Get() + readPosition_, bytesAvailable);
-            else
-            {
-                // Handle ring buffer wrap
-                unsigned part1 = READ_BUFFER_SIZE - readPosition_;
-                unsigned part2 = bytesAvailable - part1;
-                memcpy(destPtr, readBuffer_.Get() + readPosition_, part1);
-                memcpy(destPtr + part1, readBuffer_.Get(), part2);
-            }
+    void Abort(const String& message = String::EMPTY)
+    {
+        if (Done())
+            return;
+
+        state = message.Empty() ? HTTP_CLOSED : HTTP_ERROR;
+        error = message;
 
-            readPosition_ += bytesAvailable;
-            readPosition_ &= READ_BUFFER_SIZE - 1;
-            sizeLeft -= bytesAvailable;
-            totalRead += bytesAvailable;
-            destPtr += bytesAvailable;
+        // Pending operations complete with an error and are ignored
+        if (resolver)
+        {
+            resolver->cancel();
+            resolver.reset();
         }
+        if (connection)
+        {
+            asio::error_code ec;
+            connection->socket.close(ec);
+            connection.reset();
+        }
+        Release(std::shared_ptr<WebConnection>());
+    }
 
-        if (!sizeLeft || !bytesAvailable)
-            break;
+    void Release(const std::shared_ptr<WebConnection>& reusable)
+    {
+        WebRequestPool* owner = pool;
+        pool = 0;
+        if (owner)
+            owner->Release(this, reusable);
+    }
+};
+
+WebRequest::WebRequest(Context* context, const String& url, const String& verb, const Vector<String>& headers, const String& postData) :
+    Object(context),
+    readBuffer_(new BufferQueue(context)),
+    is_(new WebRequestInternalState(this))
+{
+    is_->url = url.Trimmed();
+    is_->verb = !verb.Empty() ? verb : "GET";
+
+    // Size of response is unknown, so just set maximum value. The position will also be changed
+    // to maximum value once the request is done, signaling end for Deserializer::IsEof().
+    size_ = M_MAX_UNSIGNED;
+
+    LOGDEBUG("HTTP " + is_->verb + " request to URL " + is_->url);
+
+    if (!is_->Prepare(headers, postData))
+        LOGERROR("WebRequest error: " + is_->error);
+    else
+    {
+        // Run the request on the Web subsystem's event loop, or queue it until a connection slot is free
+        Web* web = GetSubsystem<Web>();
+        WebRequestPool* pool = web ? web->GetRequestPool() : 0;
+        if (pool)
+            pool->Queue(is_);
+        else
+        {
+            is_->Abort("Web subsystem not available");
+            LOGERROR("WebRequest error: " + is_->error);
+        }
     }
 
-    // Check for end-of-file once more after reading the bytes
-    CheckEofAndAvailableSize();
-    mutex_.Release();
-    return totalRead;
+    CheckEof();
+}
+
+WebRequest::~WebRequest()
+{
+    is_->es = 0;
+    is_->Abort();
+}
+
+unsigned WebRequest::Read(void* dest, unsigned size)
+{
+    unsigned bytesRead = readBuffer_->Read(dest, size);
+    CheckEof();
+    return bytesRead;
 }
 
 unsigned WebRequest::Seek(unsigned position)
@@ -268,32 +653,153 @@ unsigned WebRequest::Seek(unsigned position)
     return position_;
 }
 
+const String& WebRequest::GetURL() const
+{
+    return is_->url;
+}
+
+const String& WebRequest::GetVerb() const
+{
+    return is_->verb;
+}
+
 String WebRequest::GetError() const
 {
-    MutexLock lock(mutex_);
-    const_cast<WebRequest*>(this)->CheckEofAndAvailableSize();
-    return error_;
+    return is_->error;
 }
 
 WebRequestState WebRequest::GetState() const
 {
-    MutexLock lock(mutex_);
-    const_cast<WebRequest*>(this)->CheckEofAndAvailableSize();
-    return state_;
+    return is_->state;
 }
 
 unsigned WebRequest::GetAvailableSize() const
 {
-    MutexLock lock(mutex_);
-    return const_cast<WebRequest*>(this)->CheckEofAndAvailableSize();
+    return readBuffer_->GetSize();
 }
 
-unsigned WebRequest::CheckEofAndAvailableSize()
+int WebRequest::GetStatusCode() const
 {
-    unsigned bytesAvailable = (writePosition_ - readPosition_) & (READ_BUFFER_SIZE - 1);
-    if (state_ == HTTP_ERROR || (state_ == HTTP_CLOSED && !bytesAvailable))
+    return is_->statusCode;
+}
+
+String WebRequest::GetResponseHeader(const String& name) const
+{
+    HashMap<String, String>::ConstIterator i = is_->responseHeaders.Find(name.ToLower());
+    return i != is_->responseHeaders.End() ? i->second_ : String::EMPTY;
+}
+
+void WebRequest::CheckEof()
+{
+    if (is_->state == HTTP_ERROR || (is_->state == HTTP_CLOSED && !readBuffer_->GetSize()))
         position_ = M_MAX_UNSIGNED;
-    return bytesAvailable;
+}
+
+WebRequestPool::WebRequestPool(asio::io_service* service) :
+    service_(service),
+    maxConnections_(DEFAULT_MAX_CONNECTIONS),
+    maxIdleConnections_(DEFAULT_MAX_IDLE_CONNECTIONS)
+{
+}
+
+WebRequestPool::~WebRequestPool()
+{
+    // Nothing may start while shutting down
+    List<std::shared_ptr<WebRequestInternalState> > pending = pending_;
+    pending_.Clear();
+    for (List<std::shared_ptr<WebRequestInternalState> >::Iterator i = pending.Begin(); i != pending.End(); ++i)
+        (*i)->Abort("Web subsystem destroyed");
+
+    Vector<std::shared_ptr<WebRequestInternalState> > active = active_;
+    for (unsigned i = 0; i < active.Size(); ++i)
+        active[i]->Abort("Web subsystem destroyed");
+
+    for (HashMap<String, Vector<std::shared_ptr<WebConnection> > >::Iterator i = idleConnections_.Begin(); i != idleConnections_.End(); ++i)
+    {
+        for (unsigned j = 0; j < i->second_.Size(); ++j)
+        {
+            asio::error_code ec;
+            i->second_[j]->socket.close(ec);
+        }
+    }
+    idleConnections_.Clear();
+}
+
+void WebRequestPool::Queue(const std::shared_ptr<WebRequestInternalState>& request)
+{
+    request->pool = this;
+    pending_.Push(request);
+    StartPending();
+}
+
+void WebRequestPool::Release(WebRequestInternalState* request, const std::shared_ptr<WebConnection>& connection)
+{
+    if (connection && connection->socket.is_open())
+    {
+        Vector<std::shared_ptr<WebConnection> >& idle = idleConnections_[connection->hostKey];
+        if (idle.Size() < maxIdleConnections_)
+            idle.Push(connection);
+    }
+
+    // The request may be aborted while still waiting for a connection slot
+    for (List<std::shared_ptr<WebRequestInternalState> >::Iterator i = pending_.Begin(); i != pending_.End(); ++i)
+    {
+        if (i->get() == request)
+        {
+            pending_.Erase(i);
+            return;
+        }
+    }
+
+    for (unsigned i = 0; i < active_.Size(); ++i)
+    {
+        if (active_[i].get() == request)
+        {
+            active_.Erase(i);
+            break;
+        }
+    }
+
+    StartPending();
+}
+
+std::shared_ptr<WebConnection> WebRequestPool::TakeIdleConnection(const String& hostKey)
+{
+    HashMap<String, Vector<std::shared_ptr<WebConnection> > >::Iterator i = idleConnections_.Find(hostKey);
+    if (i == idleConnections_.End() || i->second_.Empty())
+        return std::shared_ptr<WebConnection>();
+
+    std::shared_ptr<WebConnection> connection = i->second_.Back();
+    i->second_.Pop();
+    return connection;
+}
+
+void WebRequestPool::SetMaxConnections(unsigned maxConnections)
+{
+    maxConnections_ = maxConnections ? maxConnections : 1;
+    StartPending();
+}
+
+void WebRequestPool::SetMaxIdleConnections(unsigned maxIdleConnections)
+{
+    maxIdleConnections_ = maxIdleConnections;
+
+    for (HashMap<String, Vector<std::shared_ptr<WebConnection> > >::Iterator i = idleConnections_.Begin(); i != idleConnections_.End(); ++i)
+    {
+        if (i->second_.Size() > maxIdleConnections_)
+            i->second_.Resize(maxIdleConnections_);
+    }
+}
+
+void WebRequestPool::StartPending()
+{
+    while (!pending_.Empty() && active_.Size() < maxConnections_)
+    {
+        std::shared_ptr<WebRequestInternalState> request = pending_.Front();
+        pending_.PopFront();
+        active_.Push(request);
+        request->Start();
+    }
 }
 
 }
@@ -23,16 +23,22 @@
 
 #pragma once
 
-#include "../Container/ArrayPtr.h"
-#include "../Core/Mutex.h"
-#include "../Container/RefCounted.h"
-#include "../Core/Thread.h"
+#include "../Container/HashMap.h"
+#include "../Container/List.h"
+#include "../Core/Object.h"
+#include "../IO/BufferQueue.h"
 #include "../IO/Deserializer.h"
 
+#include <memory>
+
+namespace asio
+{
+class io_service;
+}
+
 namespace Atomic
 {
 
-/// HTTP connection state
 enum WebRequestState
 {
     HTTP_INITIALIZING = 0,
@@ -41,30 +47,34 @@ enum WebRequestState
     HTTP_CLOSED
 };
 
-/// An HTTP connection with response data stream.
-class WebRequest : public RefCounted, public Deserializer, public Thread
+class WebRequestPool;
+struct WebConnection;
+struct WebRequestInternalState;
+
+/// An HTTP request. Executed on the Web subsystem's event loop, the response body is buffered as it arrives.
+class WebRequest : public Object, public Deserializer
 {
-    REFCOUNTED(WebRequest)
+    friend class Web;
+    friend struct WebRequestInternalState;
+
+    OBJECT(WebRequest)
 
 public:
-    /// Construct with parameters.
-    WebRequest(const String& url, const String& verb, const Vector<String>& headers, const String& postData);
-    /// Destruct. Release the connection object.
+    /// Construct with parameters and queue the request on the Web subsystem.
+    WebRequest(Context* context, const String& url, const String& verb, const Vector<String>& headers, const String& postData);
+    /// Destruct. Abort the request if still in progress.
     ~WebRequest();
 
-    /// Process the connection in the worker thread until closed.
-    virtual void ThreadFunction();
-
-    /// Read response data from the HTTP connection and return number of bytes actually read. While the connection is open, will block while trying to read the specified size. To avoid blocking, only read up to as many bytes as GetAvailableSize() returns.
+    /// Read buffered response data and return number of bytes actually read. Does not block, only up to GetAvailableSize() bytes can be read.
     virtual unsigned Read(void* dest, unsigned size);
     /// Set position from the beginning of the stream. Not supported.
     virtual unsigned Seek(unsigned position);
 
     /// Return URL used in the request.
-    const String& GetURL() const { return url_; }
+    const String& GetURL() const;
 
     /// Return verb used in the request. Default GET if empty verb specified on construction.
-    const String& GetVerb() const { return verb_; }
+    const String& GetVerb() const;
 
     /// Return error. Only non-empty in the error state.
     String GetError() const;
@@ -72,36 +82,72 @@ public:
     WebRequestState GetState() const;
     /// Return amount of bytes in the read buffer.
     unsigned GetAvailableSize() const;
+    /// Return HTTP status code of the response, or 0 if not received yet.
+    int GetStatusCode() const;
+    /// Return a response header by case-insensitive name, or empty if not present.
+    String GetResponseHeader(const String& name) const;
 
     /// Return whether connection is in the open state.
     bool IsOpen() const { return GetState() == HTTP_OPEN; }
 
 private:
-    /// Check for end of the data stream and return available size in buffer. Must only be called when the mutex is held by the main thread.
-    unsigned CheckEofAndAvailableSize();
-
-    /// URL.
-    String url_;
-    /// Verb.
-    String verb_;
-    /// Error string. Empty if no error.
-    String error_;
-    /// Headers.
-    Vector<String> headers_;
-    /// POST data.
-    String postData_;
-    /// Connection state.
-    WebRequestState state_;
-    /// Mutex for synchronizing the worker and the main thread.
-    mutable Mutex mutex_;
-    /// Read buffer for the worker thread.
-    SharedArrayPtr<unsigned char> httpReadBuffer_;
-    /// Read buffer for the main thread.
-    SharedArrayPtr<unsigned char> readBuffer_;
-    /// Read buffer read cursor.
-    unsigned readPosition_;
-    /// Read buffer write cursor.
-    unsigned writePosition_;
+    /// Update end of the data stream.
+    void CheckEof();
+
+    /// Response body received so far.
+    SharedPtr<BufferQueue> readBuffer_;
+    /// Internal state, shared with the pending asynchronous operations.
+    std::shared_ptr<WebRequestInternalState> is_;
+};
+
+/// Runs the HTTP requests of the Web subsystem on its io_service with bounded concurrency, and keeps finished connections alive for reuse by later requests to the same host. Owned by the Web subsystem.
+class WebRequestPool
+{
+public:
+    /// Construct.
+    WebRequestPool(asio::io_service* service);
+    /// Destruct. Abort the requests in progress and close the idle connections.
+    ~WebRequestPool();
+
+    /// Start a request, or queue it until a connection slot is free.
+    void Queue(const std::shared_ptr<WebRequestInternalState>& request);
+    /// Release the connection slot of a finished or aborted request. A connection still usable is kept for reuse.
+    void Release(WebRequestInternalState* request, const std::shared_ptr<WebConnection>& connection);
+    /// Take an idle connection to a host. Return null if none.
+    std::shared_ptr<WebConnection> TakeIdleConnection(const String& hostKey);
+
+    /// Set maximum number of requests in progress at the same time.
+    void SetMaxConnections(unsigned maxConnections);
+    /// Set maximum number of idle connections kept alive per host.
+    void SetMaxIdleConnections(unsigned maxIdleConnections);
+
+    /// Return the io_service.
+    asio::io_service* GetService() const { return service_; }
+    /// Return maximum number of requests in progress at the same time.
+    unsigned GetMaxConnections() const { return maxConnections_; }
+    /// Return maximum number of idle connections kept alive per host.
+    unsigned GetMaxIdleConnections() const { return maxIdleConnections_; }
+    /// Return number of requests in progress.
+    unsigned GetNumActiveRequests() const { return active_.Size(); }
+    /// Return number of requests waiting for a connection slot.
+    unsigned GetNumQueuedRequests() const { return pending_.Size(); }
+
+private:
+    /// Start queued requests while there are free connection slots.
+    void StartPending();
+
+    /// The io_service running the requests.
+    asio::io_service* service_;
+    /// Maximum number of requests in progress.
+    unsigned maxConnections_;
+    /// Maximum number of idle connections per host.
+    unsigned maxIdleConnections_;
+    /// Requests in progress.
+    Vector<std::shared_ptr<WebRequestInternalState> > active_;
+    /// Requests waiting for a connection slot.
+    List<std::shared_ptr<WebRequestInternalState> > pending_;
+    /// Idle keep-alive connections by host and port.
+    HashMap<String, Vector<std::shared_ptr<WebConnection> > > idleConnections_;
 };
 
 }
@@ -139,6 +139,10 @@ bool EditorMode::PlayProject(String addArgs, bool debug)
     LOGINFOF("Launching Broker %s %s", editorBinary.CString(), dump.CString());
 
     IPC* ipc = GetSubsystem<IPC>();
+
+    // stream large payloads such as profiler data and scene snapshots through shared memory
+    ipc->SetSharedMemorySize(4 * 1024 * 1024);
+
     playerBroker_ = ipc->SpawnWorker(editorBinary, vargs);
 
     if (playerBroker_)
@@ -86,6 +86,7 @@ void PlayerMode::ProcessArguments() {
     const Vector<String>& arguments = GetArguments();
 
     int id = -1;
+    IPCHandle sharedMemory = INVALID_IPCHANDLE_VALUE;
 
     for (unsigned i = 0; i < arguments.Size(); ++i)
     {
@@ -101,6 +102,14 @@ void PlayerMode::ProcessArguments() {
 
                     id = ToInt(idc[1].CString());
             }
+#ifndef ATOMIC_PLATFORM_WINDOWS
+            else if (argument.StartsWith("--ipc-shm="))
+            {
+                Vector<String> shm = argument.Split(argument.CString(), '=');
+                if (shm.Size() == 2)
+                    sharedMemory = ToInt(shm[1].CString());
+            }
+#endif
 
             else if (argument.StartsWith("--ipc-server=") || argument.StartsWith("--ipc-client="))
             {
@@ -146,7 +155,7 @@ void PlayerMode::ProcessArguments() {
     {
         launchedByEditor_ = true;
         SubscribeToEvent(E_IPCINITIALIZE, HANDLER(PlayerMode, HandleIPCInitialize));
-        ipc_->InitWorker((unsigned) id, fd_[0], fd_[1]);
+        ipc_->InitWorker((unsigned) id, fd_[0], fd_[1], sharedMemory);
     }
 }
 
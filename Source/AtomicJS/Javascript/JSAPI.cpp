@@ -411,6 +411,9 @@ void js_to_variant(duk_context* ctx, int variantIdx, Variant &v, VariantType var
 
 }
 
+// internal property of the proxy target holding the event VariantMap, for converting values on first access
+static const char* variantMapPointerKey = "\xff" "variantMap";
+
 // variant map Proxy getter, so we can convert access to string based
 // member lookup, to string hash on the fly
 
@@ -421,8 +424,35 @@ static int variantmap_property_get(duk_context* ctx)
     if (duk_is_string(ctx, 1))
     {
         StringHash key = duk_to_string(ctx, 1);
-        duk_get_prop_index(ctx, 0, (unsigned) key.Value());
-        return 1;
+
+        // already converted
+        if (duk_get_prop_index(ctx, 0, (unsigned) key.Value()))
+            return 1;
+
+        duk_pop(ctx);
+
+        // convert from the event data, if the event is still being sent
+        duk_get_prop_string(ctx, 0, variantMapPointerKey);
+        const VariantMap* vmap = (const VariantMap*) duk_get_pointer(ctx, -1);
+        duk_pop(ctx);
+
+        if (vmap)
+        {
+            VariantMap::ConstIterator itr = vmap->Find(key);
+
+            if (itr != vmap->End())
+            {
+                js_push_variant(ctx, itr->second_);
+
+                if (!duk_is_undefined(ctx, -1))
+                {
+                    duk_dup(ctx, -1);
+                    duk_put_prop_index(ctx, 0, (unsigned) key.Value());
+                }
+
+                return 1;
+            }
+        }
     }
 
     duk_push_undefined(ctx);
@@ -442,11 +472,58 @@ static int variantmap_property_deleteproperty(duk_context* ctx)
         duk_del_prop(ctx, 0);
     }
 
+    // the event data is no longer valid
+    duk_push_pointer(ctx, 0);
+    duk_put_prop_string(ctx, 0, variantMapPointerKey);
+
     duk_push_boolean(ctx, 1);
     return 1;
 
 }
 
+// the property handler is shared by all variant map proxies, instead of
+// creating the handler and its functions for every event sent to script
+static void js_push_variantmap_handler(duk_context* ctx)
+{
+    duk_push_global_stash(ctx);
+    duk_get_prop_index(ctx, -1, JS_GLOBALSTASH_VARIANTMAP_HANDLER);
+
+    if (!duk_is_object(ctx, -1))
+    {
+        duk_pop(ctx);
+
+        duk_push_object(ctx);
+        duk_push_c_function(ctx, variantmap_property_get, 3);
+        duk_put_prop_string(ctx, -2, "get");
+        duk_push_c_function(ctx, variantmap_property_deleteproperty, 2);
+        duk_put_prop_string(ctx, -2, "deleteProperty");
+
+        duk_dup(ctx, -1);
+        duk_put_prop_index(ctx, -3, JS_GLOBALSTASH_VARIANTMAP_HANDLER);
+    }
+
+    duk_remove(ctx, -2);
+}
+
+void js_push_event_variantmap(duk_context* ctx, const VariantMap &vmap)
+{
+    duk_get_global_string(ctx, "Proxy");
+
+    // values are converted by the property getter on first access
+    duk_push_object(ctx);
+    duk_push_pointer(ctx, (void*) &vmap);
+    duk_put_prop_string(ctx, -2, variantMapPointerKey);
+
+    js_push_variantmap_handler(ctx);
+
+    duk_new(ctx, 2);
+}
+
+void js_release_event_variantmap(duk_context* ctx, duk_idx_t idx)
+{
+    // deletes all properties, see JSAPI.cpp variantmap_property_deleteproperty
+    duk_del_prop_index(ctx, idx, 0);
+}
 
 void js_push_variantmap(duk_context* ctx, const VariantMap &vmap)
 {
@@ -477,11 +554,7 @@ void js_push_variantmap(duk_context* ctx, const VariantMap &vmap)
     }
 
     // setup property handler
-    duk_push_object(ctx);
-    duk_push_c_function(ctx, variantmap_property_get, 3);
-    duk_put_prop_string(ctx, -2, "get");
-    duk_push_c_function(ctx, variantmap_property_deleteproperty, 2);
-    duk_put_prop_string(ctx, -2, "deleteProperty");
+    js_push_variantmap_handler(ctx);
 
     duk_new(ctx, 2);
 
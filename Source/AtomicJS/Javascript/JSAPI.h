@@ -31,6 +31,7 @@ typedef void* JS_HEAP_PTR;
 #define JS_GLOBALSTASH_INDEX_COMPONENTS 0
 #define JS_GLOBALSTASH_INDEX_NODE_REGISTRY 1
 #define JS_GLOBALSTASH_VARIANTMAP_CACHE 2
+#define JS_GLOBALSTASH_VARIANTMAP_HANDLER 3
 
 // indexers for instance objects
 #define JS_INSTANCE_INDEX_FINALIZED 0
@@ -58,6 +59,10 @@ void js_class_get_constructor(duk_context* ctx, const char* package, const char
 /// Pushes variant value or undefined if can't be pushed
 void js_push_variant(duk_context* ctx, const Variant &v);
 void js_push_variantmap(duk_context* ctx, const VariantMap &vmap);
+/// Pushes event data whose values are converted on first access. The event data must stay alive until js_release_event_variantmap is called on the pushed object.
+void js_push_event_variantmap(duk_context* ctx, const VariantMap &vmap);
+/// Releases the values and the event data of a variant map object at the index, later accesses return undefined.
+void js_release_event_variantmap(duk_context* ctx, duk_idx_t idx);
 
 void js_to_variant(duk_context* ctx, int variantIdx, Variant &v, VariantType variantType = VAR_NONE);
 
@@ -66,4 +71,69 @@ void js_object_to_variantmap(duk_context* ctx, int objIdx, VariantMap &v);
 /// Returns true if the item is a buffer, and if data and size are passed, they are given values to access the buffer data.
 duk_bool_t js_check_is_buffer_and_get_data(duk_context* ctx, duk_idx_t idx, void** data, duk_size_t* size);
 
+/// Returns the name of the typed array class storing elements of type T.
+template<typename T> inline const char* js_typed_array_class();
+template<> inline const char* js_typed_array_class<float>() { return "Float32Array"; }
+template<> inline const char* js_typed_array_class<int>() { return "Int32Array"; }
+
+/// Returns the storage of the value at idx if it is a typed array of the class storing T with the given number of elements, otherwise null.
+template<typename T>
+inline void* js_get_typed_array_data(duk_context* ctx, duk_idx_t idx, int elements)
+{
+    duk_size_t size;
+    void* buffer = duk_get_buffer_data(ctx, idx, &size);
+
+    if (!buffer || size != sizeof(T) * elements)
+        return 0;
+
+    // A buffer of the same size with another element type, such as an Int32Array for a Vector3, must be converted by index
+    idx = duk_normalize_index(ctx, idx);
+    duk_get_global_string(ctx, js_typed_array_class<T>());
+    bool match = duk_is_function(ctx, -1) && duk_instanceof(ctx, idx, -1);
+    duk_pop(ctx);
+
+    return match ? buffer : 0;
+}
+
+/// Reads a math value type (Vector3, Quaternion, Color...) argument. A typed array of the element type and size is copied directly from its storage, other values are read by index.
+template<typename T>
+inline void js_get_number_array(duk_context* ctx, duk_idx_t idx, T* data, int elements)
+{
+    void* buffer = js_get_typed_array_data<T>(ctx, idx, elements);
+
+    if (buffer)
+    {
+        memcpy(data, buffer, sizeof(T) * elements);
+        return;
+    }
+
+    for (int i = 0; i < elements; i++)
+    {
+        duk_get_prop_index(ctx, idx, i);
+        data[i] = (T) duk_to_number(ctx, -1);
+        duk_pop(ctx);
+    }
+}
+
+/// Pushes a math value type result. If the value at outIdx is a typed array of the element type and size, the result is written to its storage and it is pushed instead of a new array.
+template<typename T>
+inline void js_push_number_array(duk_context* ctx, const T* data, int elements, duk_idx_t outIdx)
+{
+    void* buffer = js_get_typed_array_data<T>(ctx, outIdx, elements);
+
+    if (buffer)
+    {
+        memcpy(buffer, data, sizeof(T) * elements);
+        duk_dup(ctx, outIdx);
+        return;
+    }
+
+    duk_push_array(ctx);
+    for (int i = 0; i < elements; i++)
+    {
+        duk_push_number(ctx, data[i]);
+        duk_put_prop_index(ctx, -2, i);
+    }
+}
+
 }
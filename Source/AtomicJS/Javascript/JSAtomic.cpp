@@ -59,6 +59,7 @@
 
 #include "JSAtomicPlayer.h"
 #include "JSAtomic.h"
+#include "JSWorker.h"
 
 #include <Atomic/Scene/Scene.h>
 #include <Atomic/Environment/ProcSky.h>
@@ -312,6 +313,7 @@ void jsapi_init_atomic(JSVM* vm)
     jsapi_init_scene(vm);
 
     jsapi_init_atomicplayer(vm);
+    jsapi_init_jsworker(vm);
 
     duk_context* ctx = vm->GetJSContext();
 
@@ -26,10 +26,6 @@
 #include <Atomic/Core/Context.h>
 #include <Atomic/Resource/ResourceCache.h>
 
-#ifdef ATOMIC_PHYSICS
-#include <Atomic/Physics/PhysicsEvents.h>
-#include <Atomic/Physics/PhysicsWorld.h>
-#endif
 #include <Atomic/Scene/Scene.h>
 #include <Atomic/Scene/SceneEvents.h>
 
@@ -120,7 +116,6 @@ public:
 JSComponent::JSComponent(Context* context) :
     ScriptComponent(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
-    currentEventMask_(0),
     instanceInitialized_(false),
     started_(false),
     destroyed_(false),
@@ -410,18 +405,9 @@ void JSComponent::OnNodeSet(Node* node)
 
 void JSComponent::OnSceneSet(Scene* scene)
 {
+    // The scene removes the component from its batched updates when the component is removed
     if (scene)
         UpdateEventSubscription();
-    else
-    {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
-#ifdef ATOMIC_PHYSICS
-        UnsubscribeFromEvent(E_PHYSICSPRESTEP);
-        UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
-#endif
-        currentEventMask_ = 0;
-    }
 }
 
 void JSComponent::UpdateEventSubscription()
@@ -430,113 +416,72 @@ void JSComponent::UpdateEventSubscription()
     if (!scene)
         return;
 
+    ComponentUpdateManager& manager = scene->GetComponentUpdateManager();
     bool enabled = IsEnabledEffective();
 
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, HANDLER(JSComponent, HandleSceneUpdate));
-        currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~USE_UPDATE;
-    }
-
-    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(JSComponent, HandleScenePostUpdate));
-        currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~USE_POSTUPDATE;
-    }
+    // Script methods are called from the main thread only
+    if (enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_))
+        manager.AddComponent(this, COMPONENT_UPDATE, CallUpdate);
+    else
+        manager.RemoveComponent(this, COMPONENT_UPDATE);
 
-#ifdef ATOMIC_PHYSICS
-    PhysicsWorld* world = scene->GetComponent<PhysicsWorld>();
-    if (!world)
-        return;
+    if (enabled && (updateEventMask_ & USE_POSTUPDATE))
+        manager.AddComponent(this, COMPONENT_POSTUPDATE, CallPostUpdate);
+    else
+        manager.RemoveComponent(this, COMPONENT_POSTUPDATE);
 
-    bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, HANDLER(JSComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= USE_FIXEDUPDATE;
-    }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~USE_FIXEDUPDATE;
-    }
+    if (enabled && (updateEventMask_ & USE_FIXEDUPDATE))
+        manager.AddComponent(this, COMPONENT_FIXEDUPDATE, CallFixedUpdate);
+    else
+        manager.RemoveComponent(this, COMPONENT_FIXEDUPDATE);
 
-    bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
-    if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, HANDLER(JSComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= USE_FIXEDPOSTUPDATE;
-    }
-    else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~USE_FIXEDPOSTUPDATE;
-    }
-#endif
+    if (enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE))
+        manager.AddComponent(this, COMPONENT_FIXEDPOSTUPDATE, CallFixedPostUpdate);
+    else
+        manager.RemoveComponent(this, COMPONENT_FIXEDPOSTUPDATE);
 }
 
-void JSComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void JSComponent::CallUpdate(Component* component, float timeStep)
 {
-    using namespace SceneUpdate;
+    JSComponent* jsComponent = static_cast<JSComponent*>(component);
 
-    assert(!destroyed_);
+    assert(!jsComponent->destroyed_);
 
     // Execute user-defined delayed start function before first update
-    if (!delayedStartCalled_)
+    if (!jsComponent->delayedStartCalled_)
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
+        jsComponent->DelayedStart();
+        jsComponent->delayedStartCalled_ = true;
 
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
+        // If did not need actual updates, remove from update now
+        if (!(jsComponent->updateEventMask_ & USE_UPDATE))
         {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
+            jsComponent->UpdateEventSubscription();
             return;
         }
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    jsComponent->Update(timeStep);
 }
 
-void JSComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void JSComponent::CallPostUpdate(Component* component, float timeStep)
 {
-    using namespace ScenePostUpdate;
-
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    static_cast<JSComponent*>(component)->PostUpdate(timeStep);
 }
 
-#ifdef ATOMIC_PHYSICS
-void JSComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
+void JSComponent::CallFixedUpdate(Component* component, float timeStep)
 {
-    using namespace PhysicsPreStep;
-
     // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
+    static_cast<JSComponent*>(component)->FixedUpdate(timeStep);
 }
 
-void JSComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
+void JSComponent::CallFixedPostUpdate(Component* component, float timeStep)
 {
-    using namespace PhysicsPostStep;
-
     // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    static_cast<JSComponent*>(component)->FixedPostUpdate(timeStep);
 }
-#endif
 
 bool JSComponent::Load(Deserializer& source, bool setInstanceDefault)
 {
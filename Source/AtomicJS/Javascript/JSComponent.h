@@ -100,18 +100,16 @@ protected:
     virtual void OnSceneSet(Scene* scene);
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene's batched updates based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-#ifdef ATOMIC_PHYSICS
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
-#endif
+    /// Call delayed start and scene update. Used as the batched update function.
+    static void CallUpdate(Component* component, float timeStep);
+    /// Call scene post-update.
+    static void CallPostUpdate(Component* component, float timeStep);
+    /// Call physics update.
+    static void CallFixedUpdate(Component* component, float timeStep);
+    /// Call physics post-update.
+    static void CallFixedPostUpdate(Component* component, float timeStep);
 
     void CallScriptMethod(const String& name, bool passValue = false, float value = 0.0f);
 
@@ -134,8 +132,6 @@ private:
 
     /// Requested event subscription mask.
     unsigned char updateEventMask_;
-    /// Current event subscription mask.
-    unsigned char currentEventMask_;
 
     bool instanceInitialized_;
     bool started_;
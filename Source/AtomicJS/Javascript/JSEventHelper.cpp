@@ -88,8 +88,7 @@ void JSEventDispatcher::EndSendEvent(Context* context, Object* sender, StringHas
         // deletes all properties, thus freeing references, even if
         // the variant map object is held onto by script (it will be invalid, post
         // event send)
-        // see JSAPI.cpp variantmap_property_deleteproperty
-        duk_del_prop_index(ctx, -1, 0);
+        js_release_event_variantmap(ctx, -1);
 
         duk_push_pointer(ctx, (void*) &eventData);
         duk_push_undefined(ctx);
@@ -165,8 +164,8 @@ void JSEventHelper::HandleEvent(StringHash eventType, VariantMap& eventData)
 
             // we need to push a new variant map and store to cache
             // the cache object will be cleared at the send end in  the
-            // global listener above
-            js_push_variantmap(ctx, eventData);
+            // global listener above, values are only converted when accessed
+            js_push_event_variantmap(ctx, eventData);
             duk_push_pointer(ctx, (void*) &eventData);
             duk_dup(ctx, -2);
             duk_put_prop(ctx, -4);
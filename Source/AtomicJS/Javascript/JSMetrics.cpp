@@ -147,15 +147,44 @@ void JSMetrics::DumpJSComponents()
 
 }
 
+void JSMetrics::DumpGC()
+{
+    LOGINFOF("Heap size: %u bytes", GetHeapSize());
+    LOGINFOF("GC passes: %u, total %.2f ms, last %.2f ms, max %.2f ms", GetGCPasses(), GetGCTotalTime(), GetGCLastTime(), GetGCMaxTime());
+}
+
+unsigned JSMetrics::GetHeapSize() const
+{
+    return vm_ ? (unsigned) vm_->heapSize_ : 0;
+}
+
+unsigned JSMetrics::GetGCPasses() const
+{
+    return vm_ ? vm_->gcPasses_ : 0;
+}
+
+float JSMetrics::GetGCTotalTime() const
+{
+    return vm_ ? vm_->gcTotalTime_ : 0.0f;
+}
+
+float JSMetrics::GetGCLastTime() const
+{
+    return vm_ ? vm_->gcLastTime_ : 0.0f;
+}
+
+float JSMetrics::GetGCMaxTime() const
+{
+    return vm_ ? vm_->gcMaxTime_ : 0.0f;
+}
+
 void JSMetrics::Capture()
 {
     objectMetrics_.Clear();
     nodeMetrics_.Clear();
 
-    // run twice to call finalizers
-    // see duktape docs
-    duk_gc(vm_->GetJSContext(), 0);
-    duk_gc(vm_->GetJSContext(), 0);
+    // full collection, recorded in the GC metrics
+    vm_->GC();
 
 
     HashMap<void*, RefCounted*>::ConstIterator itr = vm_->heapToObject_.Begin();
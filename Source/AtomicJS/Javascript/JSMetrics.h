@@ -60,6 +60,18 @@ public:
     void Dump();
     void DumpNodes();
     void DumpJSComponents();
+    void DumpGC();
+
+    /// Return bytes allocated by the Javascript heap.
+    unsigned GetHeapSize() const;
+    /// Return number of garbage collection passes run.
+    unsigned GetGCPasses() const;
+    /// Return total milliseconds spent in garbage collection.
+    float GetGCTotalTime() const;
+    /// Return milliseconds spent in the last garbage collection pass.
+    float GetGCLastTime() const;
+    /// Return milliseconds spent in the longest garbage collection pass.
+    float GetGCMaxTime() const;
 
 private:
 
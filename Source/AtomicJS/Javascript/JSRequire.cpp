@@ -22,7 +22,9 @@
 
 #include <assert.h>
 
+#include <Atomic/Core/Timer.h>
 #include <Atomic/IO/FileSystem.h>
+#include <Atomic/IO/MemoryBuffer.h>
 #include <Atomic/Resource/ResourceCache.h>
 
 /*
@@ -89,6 +91,96 @@ namespace Atomic
     }
 */
 
+    // module functions are compiled the same way as Duktape's require compiles module source,
+    // keeping the wrapper on the first line so that line numbers match the source
+    static const char* moduleWrapperBegin = "function (require,exports,module){";
+    static const char* moduleWrapperEnd = "\n}";
+
+    static unsigned js_module_source_hash(const String& source)
+    {
+        unsigned hash = 0;
+        const char* chars = source.CString();
+        for (unsigned i = 0; i < source.Length(); i++)
+            hash = SDBMHash(hash, (unsigned char)chars[i]);
+
+        return hash;
+    }
+
+    static void js_push_module_wrapper(duk_context* ctx, const String& moduleID, const String& source)
+    {
+        duk_push_string(ctx, moduleWrapperBegin);
+        duk_push_lstring(ctx, source.CString(), source.Length());
+        duk_push_string(ctx, moduleWrapperEnd);
+        duk_concat(ctx, 3);
+        duk_push_string(ctx, moduleID.CString());
+    }
+
+    static duk_ret_t js_load_function_safe(duk_context* ctx)
+    {
+        duk_load_function(ctx);
+        return 1;
+    }
+
+    bool js_write_module_bytecode(duk_context* ctx, const String& moduleID, const String& source, Serializer& dest)
+    {
+        js_push_module_wrapper(ctx, moduleID, source);
+
+        if (duk_pcompile(ctx, DUK_COMPILE_FUNCTION) != 0)
+        {
+            LOGERRORF("Unable to compile module %s: %s", moduleID.CString(), duk_safe_to_string(ctx, -1));
+            duk_pop(ctx);
+            return false;
+        }
+
+        duk_dump_function(ctx);
+
+        duk_size_t size;
+        const void* data = duk_get_buffer(ctx, -1, &size);
+
+        dest.WriteFileID("JSBC");
+        dest.WriteUInt(DUK_VERSION);
+        dest.WriteUInt(source.Length());
+        dest.WriteUInt(js_module_source_hash(source));
+        dest.WriteUInt((unsigned)size);
+        bool success = dest.Write(data, (unsigned)size) == (unsigned)size;
+
+        duk_pop(ctx);
+        return success;
+    }
+
+    bool js_push_module_bytecode(duk_context* ctx, Deserializer& source, const String& moduleSource)
+    {
+        // the bytecode format is specific to the Duktape version
+        if (source.ReadFileID() != "JSBC" || source.ReadUInt() != DUK_VERSION)
+            return false;
+
+        // stale bytecode is ignored, the module is then compiled from source
+        unsigned sourceLength = source.ReadUInt();
+        unsigned sourceHash = source.ReadUInt();
+        if (sourceLength != moduleSource.Length() || sourceHash != js_module_source_hash(moduleSource))
+            return false;
+
+        unsigned size = source.ReadUInt();
+        if (!size || size > source.GetSize() - source.GetPosition())
+            return false;
+
+        void* data = duk_push_fixed_buffer(ctx, size);
+        if (source.Read(data, size) != size)
+        {
+            duk_pop(ctx);
+            return false;
+        }
+
+        // bytecode from an incompatible Duktape build fails to load
+        if (duk_safe_call(ctx, js_load_function_safe, 1, 1) != DUK_EXEC_SUCCESS || !duk_is_function(ctx, -1))
+        {
+            duk_pop(ctx);
+            return false;
+        }
+
+        return true;
+    }
+
     // see http://duktape.org/guide.html#modules
     static int js_module_search(duk_context* ctx)
     {
@@ -154,8 +246,38 @@ namespace Atomic
             vm->SetLastModuleSearchFile(jsfile->GetFullPath());
             String source;
             jsfile->ReadText(source);
-            source.Append('\n');
-            duk_push_string(ctx, source.CString());
+
+            HiresTimer loadTimer;
+
+            // prefer bytecode precompiled by the build, otherwise compile the module source
+            String bytecodePath = ReplaceExtension(path, JS_BYTECODE_EXTENSION);
+            bool bytecode = false;
+
+            if (cache->Exists(bytecodePath))
+            {
+                SharedPtr<File> bytecodeFile(cache->GetFile(bytecodePath, false));
+                bytecode = js_push_module_bytecode(ctx, *bytecodeFile, source);
+
+                if (!bytecode)
+                    LOGDEBUGF("Ignoring stale bytecode %s", bytecodePath.CString());
+            }
+
+            if (!bytecode)
+            {
+                js_push_module_wrapper(ctx, moduleID, source);
+                duk_compile(ctx, DUK_COMPILE_FUNCTION);
+            }
+
+            vm->AddModuleLoadTime(loadTimer.GetUSec(false), bytecode);
+
+            // call the module function as Duktape's require would, the exports are already in place
+            duk_dup(ctx, 2);
+            duk_dup(ctx, 1);
+            duk_dup(ctx, 2);
+            duk_dup(ctx, 3);
+            duk_call_method(ctx, 3);
+
+            duk_push_undefined(ctx);
             return 1;
         }
         else
@@ -22,11 +22,25 @@
 
 #pragma once
 
+#include <Duktape/duktape.h>
+
+#include <Atomic/Container/Str.h>
+
 namespace Atomic
 {
 
 class JSVM;
+class Deserializer;
+class Serializer;
+
+/// Extension of precompiled module bytecode files, which are looked up next to the module source.
+static const char* const JS_BYTECODE_EXTENSION = ".jsc";
 
 void js_init_require(JSVM* vm);
 
+/// Compile module source and write it as precompiled bytecode, along with the source hash for validating the bytecode on load.
+bool js_write_module_bytecode(duk_context* ctx, const String& moduleID, const String& source, Serializer& dest);
+/// Push the module function from precompiled bytecode. Return false and push nothing if the bytecode is invalid or does not match the source.
+bool js_push_module_bytecode(duk_context* ctx, Deserializer& source, const String& moduleSource);
+
 }
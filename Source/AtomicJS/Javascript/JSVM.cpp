@@ -23,6 +23,7 @@
 #include <Duktape/duktape.h>
 
 #include <Atomic/Core/Profiler.h>
+#include <Atomic/Core/Timer.h>
 #include <Atomic/Core/CoreEvents.h>
 
 #include <Atomic/IO/File.h>
@@ -49,7 +50,21 @@ JSVM* JSVM::instance_ = NULL;
 JSVM::JSVM(Context* context) :
     Object(context),
     ctx_(0),
-    gcTime_(0.0f)
+    gcTime_(0.0f),
+    gcInterval_(5.0f),
+    gcHeapGrowth_(0.0f),
+    gcFrameBudget_(0.0f),
+    gcDebt_(0.0f),
+    gcPassesPending_(0),
+    heapSize_(0),
+    gcHeapBase_(0),
+    gcPasses_(0),
+    gcTotalTime_(0.0f),
+    gcLastTime_(0.0f),
+    gcMaxTime_(0.0f),
+    moduleLoadTime_(0),
+    modulesLoaded_(0),
+    bytecodeModulesLoaded_(0)
 {
     assert(!instance_);
 
@@ -72,9 +87,61 @@ JSVM::~JSVM()
     instance_ = NULL;
 }
 
+// Heap allocation functions which track the heap size for growth triggered garbage collection.
+// The size is stored in front of each block, which keeps 16 byte alignment
+static const size_t JS_ALLOC_HEADER_SIZE = 16;
+
+static void* js_heap_alloc(void* udata, duk_size_t size)
+{
+    if (!size)
+        return 0;
+
+    unsigned char* block = (unsigned char*) malloc(size + JS_ALLOC_HEADER_SIZE);
+    if (!block)
+        return 0;
+
+    *((duk_size_t*) block) = size;
+    *((size_t*) udata) += size;
+    return block + JS_ALLOC_HEADER_SIZE;
+}
+
+static void js_heap_free(void* udata, void* ptr)
+{
+    if (!ptr)
+        return;
+
+    unsigned char* block = (unsigned char*) ptr - JS_ALLOC_HEADER_SIZE;
+    *((size_t*) udata) -= *((duk_size_t*) block);
+    free(block);
+}
+
+static void* js_heap_realloc(void* udata, void* ptr, duk_size_t size)
+{
+    if (!ptr)
+        return js_heap_alloc(udata, size);
+
+    if (!size)
+    {
+        js_heap_free(udata, ptr);
+        return 0;
+    }
+
+    unsigned char* block = (unsigned char*) ptr - JS_ALLOC_HEADER_SIZE;
+    duk_size_t oldSize = *((duk_size_t*) block);
+
+    block = (unsigned char*) realloc(block, size + JS_ALLOC_HEADER_SIZE);
+    if (!block)
+        return 0;
+
+    *((duk_size_t*) block) = size;
+    *((size_t*) udata) += size;
+    *((size_t*) udata) -= oldSize;
+    return block + JS_ALLOC_HEADER_SIZE;
+}
+
 void JSVM::InitJSContext()
 {
-    ctx_ = duk_create_heap_default();
+    ctx_ = duk_create_heap(js_heap_alloc, js_heap_realloc, js_heap_free, &heapSize_, 0);
 
     jsapi_init_atomic(this);
 
@@ -97,6 +164,8 @@ void JSVM::InitJSContext()
     // handle this elsewhere?
     SubscribeToEvents();
 
+    gcHeapBase_ = heapSize_;
+
 }
 
 
@@ -115,21 +184,7 @@ void JSVM::HandleUpdate(StringHash eventType, VariantMap& eventData)
     // Take the frame time step, which is stored as a float
     float timeStep = eventData[P_TIMESTEP].GetFloat();
 
-    gcTime_ += timeStep;
-    if (gcTime_ > 5.0f)
-    {
-        PROFILE(JSVM_GC);
-
-        // run twice to call finalizers
-        // see duktape docs
-        // also ensure #define DUK_OPT_NO_VOLUNTARY_GC
-        // is enabled in duktape.h
-        duk_gc(ctx_, 0);
-        duk_gc(ctx_, 0);
-
-        gcTime_ = 0;
-
-    }
+    UpdateGC(timeStep);
 
     duk_get_global_string(ctx_, "__js_atomic_main_update");
 
@@ -402,8 +457,73 @@ bool JSVM::ExecuteFile(File *file)
 void JSVM::GC()
 {
     // run twice to ensure finalizers are run
+    RunGCPass();
+    RunGCPass();
+
+    gcPassesPending_ = 0;
+    gcTime_ = 0.0f;
+    gcHeapBase_ = heapSize_;
+}
+
+void JSVM::UpdateGC(float timeStep)
+{
+    gcTime_ += timeStep;
+
+    if (gcFrameBudget_ > 0.0f)
+    {
+        gcDebt_ -= gcFrameBudget_;
+        if (gcDebt_ < 0.0f)
+            gcDebt_ = 0.0f;
+    }
+    else
+        gcDebt_ = 0.0f;
+
+    if (!gcPassesPending_)
+    {
+        bool intervalElapsed = gcInterval_ > 0.0f && gcTime_ > gcInterval_;
+        bool heapGrown = gcHeapGrowth_ > 0.0f && heapSize_ > gcHeapBase_ + (size_t)(gcHeapBase_ * gcHeapGrowth_);
+
+        if (!intervalElapsed && !heapGrown)
+            return;
+
+        // run twice to call finalizers
+        // see duktape docs
+        // also ensure #define DUK_OPT_NO_VOLUNTARY_GC
+        // is enabled in duktape.h
+        gcPassesPending_ = 2;
+        gcTime_ = 0.0f;
+    }
+
+    // Duktape's mark and sweep is not incremental, so with a budget at most one pass runs per frame,
+    // and only once the time used by earlier passes has been paid back
+    while (gcPassesPending_ && gcDebt_ <= 0.0f)
+    {
+        RunGCPass();
+        --gcPassesPending_;
+
+        if (gcFrameBudget_ > 0.0f)
+        {
+            gcDebt_ += gcLastTime_;
+            break;
+        }
+    }
+
+    if (!gcPassesPending_)
+        gcHeapBase_ = heapSize_;
+}
+
+void JSVM::RunGCPass()
+{
+    PROFILE(JSVM_GC);
+
+    HiresTimer gcTimer;
     duk_gc(ctx_, 0);
-    duk_gc(ctx_, 0);
+
+    gcLastTime_ = gcTimer.GetUSec(false) / 1000.0f;
+    gcTotalTime_ += gcLastTime_;
+    if (gcLastTime_ > gcMaxTime_)
+        gcMaxTime_ = gcLastTime_;
+    ++gcPasses_;
 }
 
 bool JSVM::ExecuteMain()
@@ -421,6 +541,8 @@ bool JSVM::ExecuteMain()
         return false;
     }
 
+    LOGINFOF("Loaded %u script modules (%u precompiled) in %.2f ms", modulesLoaded_, bytecodeModulesLoaded_, moduleLoadTime_ / 1000.0);
+
     if (duk_is_object(ctx_, -1))
     {
         duk_get_prop_string(ctx_, -1, "update");
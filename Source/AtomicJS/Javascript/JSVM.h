@@ -34,6 +34,10 @@
 
 //#define JSVM_DEBUG
 
+// internal property of instance objects holding the native object, read directly
+// by js_to_class_instance instead of looking up the heap pointer in the object map
+#define JS_INSTANCE_NATIVE_KEY "\xff" "native"
+
 namespace Atomic
 {
 
@@ -73,7 +77,23 @@ public:
 
     inline duk_context* GetJSContext() { return ctx_; }
 
+    /// Run a full garbage collection, including finalizers.
     void GC();
+
+    /// Set interval in seconds between periodic garbage collections. Zero disables periodic collection.
+    void SetGCInterval(float interval) { gcInterval_ = interval; }
+    /// Set heap growth ratio since the last collection that triggers a garbage collection. Zero disables growth triggered collection.
+    void SetGCHeapGrowth(float ratio) { gcHeapGrowth_ = ratio; }
+    /// Set average milliseconds per frame that garbage collection may use. When nonzero, a collection's passes are spread over frames and collections are postponed until the time is paid back. Zero is unlimited.
+    void SetGCFrameBudget(float ms) { gcFrameBudget_ = ms; }
+
+    /// Return periodic garbage collection interval in seconds.
+    float GetGCInterval() const { return gcInterval_; }
+    /// Return heap growth ratio that triggers garbage collection.
+    float GetGCHeapGrowth() const { return gcHeapGrowth_; }
+    /// Return garbage collection milliseconds per frame budget.
+    float GetGCFrameBudget() const { return gcFrameBudget_; }
+
     JSMetrics* GetMetrics() { return metrics_; }
 
     void DumpJavascriptObjects() {}
@@ -102,6 +122,11 @@ public:
 
         heapToObject_[heapptr] = object;
 
+        duk_push_heapptr(ctx_, heapptr);
+        duk_push_pointer(ctx_, object);
+        duk_put_prop_string(ctx_, -2, JS_INSTANCE_NATIVE_KEY);
+        duk_pop(ctx_);
+
 #ifdef JSVM_DEBUG
         HashMap<void*, void*>::Iterator itr = removedHeapPtr_.Find(heapptr);
         if (itr != removedHeapPtr_.End())
@@ -127,6 +152,13 @@ public:
         void* heapptr = object->JSGetHeapPtr();
         assert(heapptr);
         object->JSSetHeapPtr(NULL);
+
+        // the instance object is still reachable while being finalized
+        duk_push_heapptr(ctx_, heapptr);
+        duk_push_pointer(ctx_, NULL);
+        duk_put_prop_string(ctx_, -2, JS_INSTANCE_NATIVE_KEY);
+        duk_pop(ctx_);
+
         HashMap<void*, RefCounted*>::Iterator hitr = heapToObject_.Find(heapptr);
         assert(hitr != heapToObject_.End());
         heapToObject_.Erase(hitr);
@@ -176,6 +208,15 @@ public:
 
     const String& GetLastModuleSearchFile() { return lastModuleSearchFilename_; }
 
+    /// Record the time spent loading or compiling a required module and whether it was precompiled bytecode.
+    void AddModuleLoadTime(long long usec, bool bytecode)
+    {
+        moduleLoadTime_ += usec;
+        ++modulesLoaded_;
+        if (bytecode)
+            ++bytecodeModulesLoaded_;
+    }
+
     const String& GetErrorString() { return errorString_; }
 
     void SendJSErrorEvent(const String& filename = String::EMPTY);
@@ -187,6 +228,11 @@ private:
     void SubscribeToEvents();
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
 
+    /// Start garbage collection passes according to the GC policy and run those that fit the frame budget.
+    void UpdateGC(float timeStep);
+    /// Run one mark and sweep pass and record its timing.
+    void RunGCPass();
+
     duk_context* ctx_;
 
     HashMap<void*, RefCounted*> heapToObject_;
@@ -197,11 +243,38 @@ private:
 
 #endif
 
+    /// Time since the last garbage collection.
     float gcTime_;
+    /// Periodic garbage collection interval.
+    float gcInterval_;
+    /// Heap growth ratio that triggers garbage collection.
+    float gcHeapGrowth_;
+    /// Garbage collection milliseconds per frame budget.
+    float gcFrameBudget_;
+    /// Garbage collection milliseconds used over the budget, paid back each frame.
+    float gcDebt_;
+    /// Mark and sweep passes left in the current collection.
+    unsigned gcPassesPending_;
+
+    /// Bytes allocated by the Duktape heap.
+    size_t heapSize_;
+    /// Heap size after the last garbage collection.
+    size_t gcHeapBase_;
+
+    /// Garbage collection metrics, reported through JSMetrics.
+    unsigned gcPasses_;
+    float gcTotalTime_;
+    float gcLastTime_;
+    float gcMaxTime_;
 
     Vector<String> moduleSearchPath_;
     String lastModuleSearchFilename_;
 
+    /// Module load statistics for comparing startup with and without precompiled bytecode.
+    long long moduleLoadTime_;
+    unsigned modulesLoaded_;
+    unsigned bytecodeModulesLoaded_;
+
     String errorString_;
 
     SharedPtr<JSUI> ui_;
@@ -221,7 +294,11 @@ T* js_to_class_instance(duk_context* ctx, int index, unsigned classID)
     if (!duk_is_object(ctx, index))
         return NULL;
 
-    return (T*) JSVM::GetJSVM(ctx)->GetObjectPtr(duk_get_heapptr(ctx, index));
+    duk_get_prop_string(ctx, index, JS_INSTANCE_NATIVE_KEY);
+    T* instance = (T*) duk_get_pointer(ctx, -1);
+    duk_pop(ctx);
+
+    return instance;
 }
 
 // pushes null if instance is null
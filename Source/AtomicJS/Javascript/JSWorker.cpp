@@ -0,0 +1,577 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Duktape/duktape.h>
+
+#include <Atomic/Core/CoreEvents.h>
+#include <Atomic/Core/Thread.h>
+#include <Atomic/IO/File.h>
+#include <Atomic/IO/Log.h>
+#include <Atomic/IO/MemoryBuffer.h>
+#include <Atomic/Resource/ResourceCache.h>
+
+#include "JSVM.h"
+#include "JSWorker.h"
+
+namespace Atomic
+{
+
+// global stash key of the worker thread pointer in a worker heap
+static const char* workerThreadKey = "\xff" "workerThread";
+
+// value tags of the structured clone format
+enum JSCloneTag
+{
+    JS_CLONE_UNDEFINED = 0,
+    JS_CLONE_NULL,
+    JS_CLONE_FALSE,
+    JS_CLONE_TRUE,
+    JS_CLONE_NUMBER,
+    JS_CLONE_STRING,
+    JS_CLONE_ARRAY,
+    JS_CLONE_OBJECT,
+    JS_CLONE_BUFFER
+};
+
+// nesting limit, which also rejects values with cycles
+static const unsigned JS_CLONE_MAX_DEPTH = 64;
+
+/// Worker thread running a script in its own Duktape heap.
+class JSWorkerThread : public Thread
+{
+public:
+    /// Construct.
+    JSWorkerThread(JSWorker* worker) :
+        worker_(worker),
+        closed_(false)
+    {
+    }
+
+    /// Create the worker heap, run the script and dispatch messages to it until stopped or closed.
+    virtual void ThreadFunction();
+
+    /// Stop dispatching messages after the current one.
+    void Close() { closed_ = true; }
+    /// Queue a message posted by the worker script for the main thread.
+    void PostWorkerMessage(const VectorBuffer& message) { worker_->PostWorkerMessage(message); }
+
+    /// Return whether the script has closed the worker or failed to run.
+    bool IsClosed() const { return closed_; }
+
+private:
+    /// Log the error on top of the stack.
+    void LogError(duk_context* ctx);
+
+    /// Worker.
+    JSWorker* worker_;
+    /// Closed flag.
+    volatile bool closed_;
+};
+
+static JSWorkerThread* js_get_worker_thread(duk_context* ctx)
+{
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, workerThreadKey);
+    JSWorkerThread* thread = (JSWorkerThread*) duk_get_pointer(ctx, -1);
+    duk_pop_2(ctx);
+
+    return thread;
+}
+
+static int Worker_Print(duk_context* ctx)
+{
+    duk_concat(ctx, duk_get_top(ctx));
+
+    LOGINFOF("%s", duk_to_string(ctx, -1));
+    return 0;
+}
+
+static int Worker_PostMessage(duk_context* ctx)
+{
+    bool cloned;
+
+    {
+        VectorBuffer message;
+        cloned = js_write_structured_clone(ctx, 0, message);
+        if (cloned)
+            js_get_worker_thread(ctx)->PostWorkerMessage(message);
+    }
+
+    if (!cloned)
+        duk_error(ctx, DUK_ERR_TYPE_ERROR, "postMessage: value can not be cloned");
+
+    return 0;
+}
+
+static int Worker_Close(duk_context* ctx)
+{
+    js_get_worker_thread(ctx)->Close();
+    return 0;
+}
+
+void JSWorkerThread::LogError(duk_context* ctx)
+{
+    if (duk_is_object(ctx, -1))
+        duk_get_prop_string(ctx, -1, "stack");
+    else
+        duk_dup(ctx, -1);
+
+    LOGERRORF("JSWorker %s: %s", worker_->GetScriptPath().CString(), duk_safe_to_string(ctx, -1));
+
+    duk_pop(ctx);
+}
+
+void JSWorkerThread::ThreadFunction()
+{
+    duk_context* ctx = duk_create_heap_default();
+
+    duk_push_global_stash(ctx);
+    duk_push_pointer(ctx, this);
+    duk_put_prop_string(ctx, -2, workerThreadKey);
+    duk_pop(ctx);
+
+    // the worker API, scripts have no access to the engine
+    duk_push_global_object(ctx);
+
+    duk_push_object(ctx);
+    duk_push_c_function(ctx, Worker_Print, DUK_VARARGS);
+    duk_put_prop_string(ctx, -2, "log");
+    duk_put_prop_string(ctx, -2, "console");
+
+    duk_push_c_function(ctx, Worker_Print, DUK_VARARGS);
+    duk_put_prop_string(ctx, -2, "print");
+    duk_push_c_function(ctx, Worker_PostMessage, 1);
+    duk_put_prop_string(ctx, -2, "postMessage");
+    duk_push_c_function(ctx, Worker_Close, 0);
+    duk_put_prop_string(ctx, -2, "close");
+
+    duk_pop(ctx);
+
+    duk_push_string(ctx, worker_->GetScriptPath().CString());
+    if (duk_eval_raw(ctx, worker_->source_.CString(), 0,
+                     DUK_COMPILE_EVAL | DUK_COMPILE_SAFE | DUK_COMPILE_NOSOURCE | DUK_COMPILE_STRLEN) != 0)
+    {
+        LogError(ctx);
+        closed_ = true;
+    }
+
+    duk_pop(ctx);
+
+    Vector<VectorBuffer> messages;
+
+    while (shouldRun_ && !closed_)
+    {
+        worker_->WaitForWorkerMessages();
+        worker_->ReceiveWorkerMessages(messages);
+
+        for (unsigned i = 0; i < messages.Size() && !closed_; ++i)
+        {
+            duk_get_global_string(ctx, "onmessage");
+
+            // without a handler messages are dropped
+            if (!duk_is_function(ctx, -1))
+            {
+                duk_pop(ctx);
+                break;
+            }
+
+            messages[i].Seek(0);
+            js_push_structured_clone(ctx, messages[i]);
+
+            if (duk_pcall(ctx, 1) != 0)
+                LogError(ctx);
+
+            duk_pop(ctx);
+        }
+
+        messages.Clear();
+    }
+
+    duk_destroy_heap(ctx);
+}
+
+JSWorker::JSWorker(Context* context) :
+    Object(context),
+    thread_(0)
+{
+    SubscribeToEvent(E_UPDATE, HANDLER(JSWorker, HandleUpdate));
+}
+
+JSWorker::~JSWorker()
+{
+    Stop();
+}
+
+bool JSWorker::Start(const String& scriptPath)
+{
+    if (thread_)
+        Stop();
+
+    SharedPtr<File> file(GetSubsystem<ResourceCache>()->GetFile(scriptPath));
+    if (file.Null())
+    {
+        LOGERRORF("JSWorker: could not load script %s", scriptPath.CString());
+        return false;
+    }
+
+    scriptPath_ = scriptPath;
+    file->ReadText(source_);
+    source_.Append('\n');
+
+    thread_ = new JSWorkerThread(this);
+    if (!thread_->Run())
+    {
+        LOGERRORF("JSWorker: could not start worker thread for %s", scriptPath.CString());
+        delete thread_;
+        thread_ = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void JSWorker::Stop()
+{
+    if (!thread_)
+        return;
+
+    // wake up the worker if it is waiting for messages
+    workerMessageAvailable_.Release();
+    thread_->Stop();
+    delete thread_;
+    thread_ = 0;
+
+    MutexLock lock(messageMutex_);
+    workerMessages_.Clear();
+    mainMessages_.Clear();
+    while (workerMessageAvailable_.TryAcquire())
+        ;
+}
+
+bool JSWorker::IsRunning() const
+{
+    return thread_ && !thread_->IsClosed();
+}
+
+void JSWorker::PostMessage(const unsigned char* data, unsigned size)
+{
+    MutexLock lock(messageMutex_);
+    workerMessages_.Push(VectorBuffer(data, size));
+    workerMessageAvailable_.Release();
+}
+
+void JSWorker::WaitForWorkerMessages()
+{
+    workerMessageAvailable_.Acquire();
+}
+
+void JSWorker::ReceiveWorkerMessages(Vector<VectorBuffer>& messages)
+{
+    MutexLock lock(messageMutex_);
+    messages.Swap(workerMessages_);
+
+    // all queued messages are taken at once, consume the wakeups of the others
+    while (workerMessageAvailable_.TryAcquire())
+        ;
+}
+
+void JSWorker::PostWorkerMessage(const VectorBuffer& message)
+{
+    MutexLock lock(messageMutex_);
+    mainMessages_.Push(message);
+}
+
+void JSWorker::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    {
+        MutexLock lock(messageMutex_);
+        if (mainMessages_.Empty())
+            return;
+
+        deliverMessages_.Swap(mainMessages_);
+    }
+
+    // the handler may release the last reference to the worker
+    SharedPtr<JSWorker> keepAlive(this);
+
+    JSVM* vm = JSVM::GetJSVM(0);
+
+    if (vm)
+    {
+        duk_context* ctx = vm->GetJSContext();
+
+        for (unsigned i = 0; i < deliverMessages_.Size(); ++i)
+        {
+            // the script object may have been finalized by the previous handler
+            void* heapptr = JSGetHeapPtr();
+            if (!heapptr)
+                break;
+
+            duk_push_heapptr(ctx, heapptr);
+            duk_get_prop_string(ctx, -1, "onmessage");
+
+            if (!duk_is_function(ctx, -1))
+            {
+                duk_pop_2(ctx);
+                break;
+            }
+
+            duk_swap_top(ctx, -2);
+
+            deliverMessages_[i].Seek(0);
+            js_push_structured_clone(ctx, deliverMessages_[i]);
+
+            if (duk_pcall_method(ctx, 1) != 0 && duk_is_object(ctx, -1))
+                vm->SendJSErrorEvent();
+
+            duk_pop(ctx);
+        }
+    }
+
+    deliverMessages_.Clear();
+}
+
+static bool js_write_clone_value(duk_context* ctx, duk_idx_t idx, VectorBuffer& dest, unsigned depth)
+{
+    if (depth > JS_CLONE_MAX_DEPTH)
+        return false;
+
+    idx = duk_normalize_index(ctx, idx);
+
+    switch (duk_get_type(ctx, idx))
+    {
+    case DUK_TYPE_UNDEFINED:
+        dest.WriteUByte(JS_CLONE_UNDEFINED);
+        return true;
+
+    case DUK_TYPE_NULL:
+        dest.WriteUByte(JS_CLONE_NULL);
+        return true;
+
+    case DUK_TYPE_BOOLEAN:
+        dest.WriteUByte(duk_get_boolean(ctx, idx) ? JS_CLONE_TRUE : JS_CLONE_FALSE);
+        return true;
+
+    case DUK_TYPE_NUMBER:
+        dest.WriteUByte(JS_CLONE_NUMBER);
+        dest.WriteDouble(duk_get_number(ctx, idx));
+        return true;
+
+    case DUK_TYPE_STRING:
+    {
+        duk_size_t length;
+        const char* str = duk_get_lstring(ctx, idx, &length);
+        dest.WriteUByte(JS_CLONE_STRING);
+        dest.WriteVLE((unsigned) length);
+        dest.Write(str, (unsigned) length);
+        return true;
+    }
+
+    case DUK_TYPE_BUFFER:
+    case DUK_TYPE_OBJECT:
+        break;
+
+    default:
+        return false;
+    }
+
+    // typed arrays and buffers are cloned as their bytes
+    void* data;
+    duk_size_t size;
+    if (js_check_is_buffer_and_get_data(ctx, idx, &data, &size))
+    {
+        dest.WriteUByte(JS_CLONE_BUFFER);
+        dest.WriteVLE((unsigned) size);
+        dest.Write(data, (unsigned) size);
+        return true;
+    }
+
+    // functions and engine objects belong to their heap
+    if (duk_is_function(ctx, idx) || duk_has_prop_string(ctx, idx, JS_INSTANCE_NATIVE_KEY))
+        return false;
+
+    if (duk_is_array(ctx, idx))
+    {
+        unsigned length = (unsigned) duk_get_length(ctx, idx);
+
+        dest.WriteUByte(JS_CLONE_ARRAY);
+        dest.WriteVLE(length);
+
+        for (unsigned i = 0; i < length; ++i)
+        {
+            duk_get_prop_index(ctx, idx, i);
+            if (!js_write_clone_value(ctx, -1, dest, depth + 1))
+                return false;
+            duk_pop(ctx);
+        }
+
+        return true;
+    }
+
+    dest.WriteUByte(JS_CLONE_OBJECT);
+
+    // the property count is written once the properties have been enumerated
+    unsigned countPosition = dest.GetPosition();
+    unsigned count = 0;
+    dest.WriteUInt(0);
+
+    duk_enum(ctx, idx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+
+    while (duk_next(ctx, -1, 1))
+    {
+        duk_size_t length;
+        const char* key = duk_to_lstring(ctx, -2, &length);
+        dest.WriteVLE((unsigned) length);
+        dest.Write(key, (unsigned) length);
+
+        if (!js_write_clone_value(ctx, -1, dest, depth + 1))
+            return false;
+
+        duk_pop_2(ctx);
+        ++count;
+    }
+
+    duk_pop(ctx);
+
+    unsigned endPosition = dest.GetPosition();
+    dest.Seek(countPosition);
+    dest.WriteUInt(count);
+    dest.Seek(endPosition);
+
+    return true;
+}
+
+static void js_push_clone_string(duk_context* ctx, Deserializer& source)
+{
+    unsigned length = source.ReadVLE();
+    void* data = duk_push_fixed_buffer(ctx, length);
+    source.Read(data, length);
+    duk_to_string(ctx, -1);
+}
+
+bool js_write_structured_clone(duk_context* ctx, duk_idx_t idx, VectorBuffer& dest)
+{
+    duk_idx_t top = duk_get_top(ctx);
+
+    bool cloned = js_write_clone_value(ctx, idx, dest, 0);
+
+    duk_set_top(ctx, top);
+
+    return cloned;
+}
+
+void js_push_structured_clone(duk_context* ctx, Deserializer& source)
+{
+    switch (source.ReadUByte())
+    {
+    case JS_CLONE_NULL:
+        duk_push_null(ctx);
+        break;
+
+    case JS_CLONE_FALSE:
+        duk_push_false(ctx);
+        break;
+
+    case JS_CLONE_TRUE:
+        duk_push_true(ctx);
+        break;
+
+    case JS_CLONE_NUMBER:
+        duk_push_number(ctx, source.ReadDouble());
+        break;
+
+    case JS_CLONE_STRING:
+        js_push_clone_string(ctx, source);
+        break;
+
+    case JS_CLONE_ARRAY:
+    {
+        unsigned length = source.ReadVLE();
+
+        duk_push_array(ctx);
+        for (unsigned i = 0; i < length; ++i)
+        {
+            js_push_structured_clone(ctx, source);
+            duk_put_prop_index(ctx, -2, i);
+        }
+    }   break;
+
+    case JS_CLONE_OBJECT:
+    {
+        unsigned count = source.ReadUInt();
+
+        duk_push_object(ctx);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            js_push_clone_string(ctx, source);
+            js_push_structured_clone(ctx, source);
+            duk_put_prop(ctx, -3);
+        }
+    }   break;
+
+    case JS_CLONE_BUFFER:
+    {
+        unsigned size = source.ReadVLE();
+        void* data = duk_push_fixed_buffer(ctx, size);
+        source.Read(data, size);
+        duk_push_buffer_object(ctx, -1, 0, size, DUK_BUFOBJ_UINT8ARRAY);
+        duk_replace(ctx, -2);
+    }   break;
+
+    default:
+        duk_push_undefined(ctx);
+        break;
+    }
+}
+
+static int JSWorker_PostMessage(duk_context* ctx)
+{
+    duk_push_this(ctx);
+    JSWorker* worker = js_to_class_instance<JSWorker>(ctx, -1, 0);
+    duk_pop(ctx);
+
+    bool cloned;
+
+    {
+        VectorBuffer message;
+        cloned = js_write_structured_clone(ctx, 0, message);
+        if (cloned && worker)
+            worker->PostMessage((const unsigned char*) message.GetData(), message.GetSize());
+    }
+
+    if (!cloned)
+        duk_error(ctx, DUK_ERR_TYPE_ERROR, "postMessage: value can not be cloned");
+
+    return 0;
+}
+
+void jsapi_init_jsworker(JSVM* vm)
+{
+    duk_context* ctx = vm->GetJSContext();
+
+    js_class_get_prototype(ctx, "Atomic", "JSWorker");
+    duk_push_c_function(ctx, JSWorker_PostMessage, 1);
+    duk_put_prop_string(ctx, -2, "postMessage");
+    duk_pop(ctx);
+}
+
+}
@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Duktape/duktape.h>
+
+#include <Atomic/Core/Mutex.h>
+#include <Atomic/Core/Semaphore.h>
+#include <Atomic/Core/Object.h>
+#include <Atomic/IO/VectorBuffer.h>
+
+namespace Atomic
+{
+
+class JSVM;
+class JSWorkerThread;
+
+/// Javascript worker running a script in its own Duktape heap on a worker thread. The worker heap has no engine bindings,
+/// only the language builtins (including Math and JSON), print, console.log and messaging. Messages are structured clones
+/// of plain values, arrays, objects and typed arrays, passed with postMessage() and received by the onmessage handler
+/// on either side. Script keeps the worker alive by holding a reference to it.
+class ATOMIC_API JSWorker : public Object
+{
+    friend class JSWorkerThread;
+
+    OBJECT(JSWorker);
+
+public:
+    /// Construct.
+    JSWorker(Context* context);
+    /// Destruct. Stop the worker thread.
+    virtual ~JSWorker();
+
+    /// Load a script and start running it on the worker thread. Return true if successful.
+    bool Start(const String& scriptPath);
+    /// Stop the worker thread and discard pending messages.
+    void Stop();
+
+    /// Queue a serialized message for the worker script.
+    void PostMessage(const unsigned char* data, unsigned size);
+
+    /// Return the script the worker runs.
+    const String& GetScriptPath() const { return scriptPath_; }
+    /// Return whether the worker thread is running.
+    bool IsRunning() const;
+
+private:
+    /// Deliver messages posted by the worker script to the onmessage handler of the script object.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+
+    /// Wait until a message is posted to the worker or the worker is stopped. Called from the worker thread.
+    void WaitForWorkerMessages();
+    /// Take the messages posted to the worker. Called from the worker thread.
+    void ReceiveWorkerMessages(Vector<VectorBuffer>& messages);
+    /// Queue a message posted by the worker script. Called from the worker thread.
+    void PostWorkerMessage(const VectorBuffer& message);
+
+    /// Worker thread.
+    JSWorkerThread* thread_;
+    /// Script path.
+    String scriptPath_;
+    /// Script source, read on the main thread as the resource cache is not thread safe.
+    String source_;
+    /// Mutex for the message queues.
+    Mutex messageMutex_;
+    /// Messages waiting to be received by the worker script.
+    Vector<VectorBuffer> workerMessages_;
+    /// Counts the messages waiting to be received, plus a wakeup when stopping. Released with the mutex held.
+    Semaphore workerMessageAvailable_;
+    /// Messages posted by the worker script waiting to be delivered on the main thread.
+    Vector<VectorBuffer> mainMessages_;
+    /// Messages being delivered on the main thread, swapped with mainMessages_ to keep the mutex held briefly.
+    Vector<VectorBuffer> deliverMessages_;
+};
+
+/// Write a structured clone of the value at idx. Return false if the value, or a value it contains, is a function, an engine object, too deeply nested or cyclic.
+bool js_write_structured_clone(duk_context* ctx, duk_idx_t idx, VectorBuffer& dest);
+/// Read a structured clone and push it on the stack. Typed arrays are pushed as Uint8Array.
+void js_push_structured_clone(duk_context* ctx, Deserializer& source);
+
+void jsapi_init_jsworker(JSVM* vm);
+
+}
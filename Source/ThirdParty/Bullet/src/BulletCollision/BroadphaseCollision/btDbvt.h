@@ -344,6 +344,20 @@ struct	btDbvt
 								const btVector3& aabbMin,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const;
+	// ATOMIC BEGIN
+	///rayTestInternal variant with a caller-supplied stack, which can be called in parallel
+	DBVT_PREFIX
+		void		rayTestInternal(	const btDbvtNode* root,
+								const btVector3& rayFrom,
+								const btVector3& rayTo,
+								const btVector3& rayDirectionInverse,
+								unsigned int signs[3],
+								btScalar lambda_max,
+								const btVector3& aabbMin,
+								const btVector3& aabbMax,
+								btAlignedObjectArray<const btDbvtNode*>& stack,
+								DBVT_IPOLICY) const;
+	// ATOMIC END
 
 	DBVT_PREFIX
 		static void		collideKDOP(const btDbvtNode* root,
@@ -961,6 +975,23 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const
 {
+	// ATOMIC BEGIN
+	rayTestInternal(root,rayFrom,rayTo,rayDirectionInverse,signs,lambda_max,aabbMin,aabbMax,m_rayTestStack,policy);
+}
+
+DBVT_PREFIX
+inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
+								const btVector3& rayFrom,
+								const btVector3& rayTo,
+								const btVector3& rayDirectionInverse,
+								unsigned int signs[3],
+								btScalar lambda_max,
+								const btVector3& aabbMin,
+								const btVector3& aabbMax,
+								btAlignedObjectArray<const btDbvtNode*>& stack,
+								DBVT_IPOLICY) const
+{
+	// ATOMIC END
         (void) rayTo;
 	DBVT_CHECKTYPE
 	if(root)
@@ -969,7 +1000,6 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 
 		int								depth=1;
 		int								treshold=DOUBLE_STACKSIZE-2;
-		btAlignedObjectArray<const btDbvtNode*>&	stack = m_rayTestStack;
 		stack.resize(DOUBLE_STACKSIZE);
 		stack[0]=root;
 		btVector3 bounds[2];
@@ -453,8 +453,22 @@ unsigned long int			CProfileManager::ResetTime = 0;
  * The string used is assumed to be a static string; pointer compares are used throughout      *
  * the profiling code for efficiency.                                                          *
  *=============================================================================================*/
+// ATOMIC BEGIN
+static btProfileThreadCheck gProfileThreadCheck = 0;
+
+void btSetProfileThreadCheck(btProfileThreadCheck check)
+{
+	gProfileThreadCheck = check;
+}
+// ATOMIC END
+
 void	CProfileManager::Start_Profile( const char * name )
 {
+	// ATOMIC BEGIN
+	if (gProfileThreadCheck && !gProfileThreadCheck())
+		return;
+	// ATOMIC END
+
 	if (name != CurrentNode->Get_Name()) {
 		CurrentNode = CurrentNode->Get_Sub_Node( name );
 	}
@@ -468,6 +482,11 @@ void	CProfileManager::Start_Profile( const char * name )
  *=============================================================================================*/
 void	CProfileManager::Stop_Profile( void )
 {
+	// ATOMIC BEGIN
+	if (gProfileThreadCheck && !gProfileThreadCheck())
+		return;
+	// ATOMIC END
+
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
 	if (CurrentNode->Return()) {
@@ -177,6 +177,14 @@ private:
 };
 
 
+// ATOMIC BEGIN
+///Function which returns whether the calling thread may record profile samples. The profile tree is not thread-safe,
+///so when parts of the simulation run in worker threads the samples from those threads are dropped.
+typedef bool (*btProfileThreadCheck)();
+///Set the thread check function, or null to record samples from all threads
+void btSetProfileThreadCheck(btProfileThreadCheck check);
+// ATOMIC END
+
 ///ProfileSampleClass is a simple way to profile a function's scope
 ///Use the BT_PROFILE macro at the start of scope to time
 class	CProfileSample {
@@ -204,6 +204,14 @@ struct dtCrowdAgentDebugInfo
 /// Type for the update callback.
 typedef void (*dtUpdateCallback)(dtCrowdAgent* ag, float dt);
 
+// ATOMIC BEGIN
+/// Type for a task which processes the active agents [begin, end) on the thread with the given index.
+typedef void (*dtCrowdTask)(void* data, int begin, int end, int threadIndex);
+/// Type for the parallel for callback, which runs a task over [0, count) split across threads and returns when all is done.
+/// Thread index 0 must be the calling thread.
+typedef void (*dtParallelForCallback)(void* userData, int count, dtCrowdTask task, void* taskData);
+// ATOMIC END
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
@@ -234,6 +242,30 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	// ATOMIC BEGIN
+	dtParallelForCallback m_parallelFor;
+	void* m_parallelForUserData;
+	int m_maxThreads;
+	dtNavMeshQuery** m_threadNavQueries;
+	dtObstacleAvoidanceQuery** m_threadObstacleQueries;
+	int* m_threadSampleCounts;
+	int m_updateAgentCount;
+	float m_updateDt;
+	dtCrowdAgentDebugInfo* m_updateDebug;
+
+	bool initThreadQueries(const dtNavMesh* nav);
+	void purgeThreadQueries();
+	void runParallel(dtCrowdTask task);
+
+	static void updateNeighboursTask(void* data, int begin, int end, int threadIndex);
+	static void updateSteeringTask(void* data, int begin, int end, int threadIndex);
+	static void updateVelocityTask(void* data, int begin, int end, int threadIndex);
+	static void integrateTask(void* data, int begin, int end, int threadIndex);
+	static void calcCollisionTask(void* data, int begin, int end, int threadIndex);
+	static void applyCollisionTask(void* data, int begin, int end, int threadIndex);
+	static void movePositionTask(void* data, int begin, int end, int threadIndex);
+	// ATOMIC END
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
@@ -256,6 +288,16 @@ public:
 	///  @param[in]		cb				The update callback.
 	/// @return True if the initialization succeeded.
 	bool init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav, dtUpdateCallback cb = 0);
+
+	// ATOMIC BEGIN
+	/// Sets a callback for running the per-agent update phases on multiple threads.
+	/// The update callback is still called on the calling thread.
+	///  @param[in]		cb			The parallel for callback, or null to update on the calling thread only.
+	///  @param[in]		userData	User data passed to the callback.
+	///  @param[in]		maxThreads	The number of threads the callback may use, including the calling thread.
+	/// @return True if the per-thread queries were initialized.
+	bool setParallelFor(dtParallelForCallback cb, void* userData, const int maxThreads);
+	// ATOMIC END
 	
 	/// Sets the shared avoidance configuration for the specified index.
 	///  @param[in]		idx		The index. [Limits: 0 <= value < #DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS]
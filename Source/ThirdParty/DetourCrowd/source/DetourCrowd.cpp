@@ -344,7 +344,18 @@ dtCrowd::dtCrowd() :
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_navquery(0),
+	// ATOMIC BEGIN
+	m_parallelFor(0),
+	m_parallelForUserData(0),
+	m_maxThreads(1),
+	m_threadNavQueries(0),
+	m_threadObstacleQueries(0),
+	m_threadSampleCounts(0),
+	m_updateAgentCount(0),
+	m_updateDt(0),
+	m_updateDebug(0)
+	// ATOMIC END
 {
 }
 
@@ -355,6 +366,10 @@ dtCrowd::~dtCrowd()
 
 void dtCrowd::purge()
 {
+	// ATOMIC BEGIN
+	purgeThreadQueries();
+	// ATOMIC END
+	
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -464,9 +479,397 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	if (dtStatusFailed(m_navquery->init(nav, MAX_COMMON_NODES)))
 		return false;
 	
+	// ATOMIC BEGIN
+	if (m_parallelFor && !initThreadQueries(nav))
+		return false;
+	// ATOMIC END
+	
 	return true;
 }
 
+// ATOMIC BEGIN
+bool dtCrowd::setParallelFor(dtParallelForCallback cb, void* userData, const int maxThreads)
+{
+	purgeThreadQueries();
+
+	m_parallelFor = cb;
+	m_parallelForUserData = userData;
+	m_maxThreads = cb ? dtMax(maxThreads, 1) : 1;
+
+	if (!m_navquery || !m_parallelFor)
+		return true;
+	return initThreadQueries(m_navquery->getAttachedNavMesh());
+}
+
+bool dtCrowd::initThreadQueries(const dtNavMesh* nav)
+{
+	purgeThreadQueries();
+
+	// Thread 0 is the calling thread, which uses the crowd's own queries.
+	m_threadNavQueries = (dtNavMeshQuery**)dtAlloc(sizeof(dtNavMeshQuery*)*m_maxThreads, DT_ALLOC_PERM);
+	if (!m_threadNavQueries)
+		return false;
+	memset(m_threadNavQueries, 0, sizeof(dtNavMeshQuery*)*m_maxThreads);
+	
+	m_threadObstacleQueries = (dtObstacleAvoidanceQuery**)dtAlloc(sizeof(dtObstacleAvoidanceQuery*)*m_maxThreads, DT_ALLOC_PERM);
+	if (!m_threadObstacleQueries)
+		return false;
+	memset(m_threadObstacleQueries, 0, sizeof(dtObstacleAvoidanceQuery*)*m_maxThreads);
+	
+	m_threadSampleCounts = (int*)dtAlloc(sizeof(int)*m_maxThreads, DT_ALLOC_PERM);
+	if (!m_threadSampleCounts)
+		return false;
+	
+	m_threadNavQueries[0] = m_navquery;
+	m_threadObstacleQueries[0] = m_obstacleQuery;
+	
+	for (int i = 1; i < m_maxThreads; ++i)
+	{
+		m_threadNavQueries[i] = dtAllocNavMeshQuery();
+		if (!m_threadNavQueries[i])
+			return false;
+		if (dtStatusFailed(m_threadNavQueries[i]->init(nav, MAX_COMMON_NODES)))
+			return false;
+		
+		m_threadObstacleQueries[i] = dtAllocObstacleAvoidanceQuery();
+		if (!m_threadObstacleQueries[i])
+			return false;
+		if (!m_threadObstacleQueries[i]->init(6, 8))
+			return false;
+	}
+	
+	return true;
+}
+
+void dtCrowd::purgeThreadQueries()
+{
+	for (int i = 1; i < m_maxThreads; ++i)
+	{
+		if (m_threadNavQueries)
+			dtFreeNavMeshQuery(m_threadNavQueries[i]);
+		if (m_threadObstacleQueries)
+			dtFreeObstacleAvoidanceQuery(m_threadObstacleQueries[i]);
+	}
+	
+	dtFree(m_threadNavQueries);
+	m_threadNavQueries = 0;
+	dtFree(m_threadObstacleQueries);
+	m_threadObstacleQueries = 0;
+	dtFree(m_threadSampleCounts);
+	m_threadSampleCounts = 0;
+}
+
+void dtCrowd::runParallel(dtCrowdTask task)
+{
+	if (m_parallelFor && m_threadNavQueries && m_updateAgentCount > 1)
+		(*m_parallelFor)(m_parallelForUserData, m_updateAgentCount, task, this);
+	else
+		(*task)(this, 0, m_updateAgentCount, 0);
+}
+
+void dtCrowd::updateNeighboursTask(void* data, int begin, int end, int threadIndex)
+{
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtNavMeshQuery* navquery = crowd->m_threadNavQueries ? crowd->m_threadNavQueries[threadIndex] : crowd->m_navquery;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	const int nagents = crowd->m_updateAgentCount;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+
+		// Update the collision boundary after certain distance has been passed or
+		// if it has become invalid.
+		const dtQueryFilter* filter = &crowd->m_filters[ag->params.queryFilterType];
+		const float updateThr = ag->params.collisionQueryRange*0.25f;
+		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
+			!ag->boundary.isValid(navquery, filter))
+		{
+			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
+								navquery, filter);
+		}
+		// Query neighbour agents
+		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
+								  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
+								  agents, nagents, crowd->m_grid);
+		for (int j = 0; j < ag->nneis; j++)
+			ag->neis[j].idx = crowd->getAgentIndex(agents[ag->neis[j].idx]);
+	}
+}
+
+void dtCrowd::updateSteeringTask(void* data, int begin, int end, int /*threadIndex*/)
+{
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
+			continue;
+		
+		float dvel[3] = {0,0,0};
+
+		if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		{
+			dtVcopy(dvel, ag->targetPos);
+			ag->desiredSpeed = dtVlen(ag->targetPos);
+		}
+		else
+		{
+			// Calculate steering direction.
+			if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
+				calcSmoothSteerDirection(ag, dvel);
+			else
+				calcStraightSteerDirection(ag, dvel);
+			
+			// Calculate speed scale, which tells the agent to slowdown at the end of the path.
+			const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
+			const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
+				
+			ag->desiredSpeed = ag->params.maxSpeed;
+			dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
+		}
+
+		// Separation
+		if (ag->params.updateFlags & DT_CROWD_SEPARATION)
+		{
+			const float separationDist = ag->params.collisionQueryRange; 
+			const float invSeparationDist = 1.0f / separationDist; 
+			const float separationWeight = ag->params.separationWeight;
+			
+			float w = 0;
+			float disp[3] = {0,0,0};
+			
+			for (int j = 0; j < ag->nneis; ++j)
+			{
+				const dtCrowdAgent* nei = &crowd->m_agents[ag->neis[j].idx];
+				
+				float diff[3];
+				dtVsub(diff, ag->npos, nei->npos);
+				diff[1] = 0;
+				
+				const float distSqr = dtVlenSqr(diff);
+				if (distSqr < 0.00001f)
+					continue;
+				if (distSqr > dtSqr(separationDist))
+					continue;
+				const float dist = dtMathSqrtf(distSqr);
+				const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
+				
+				dtVmad(disp, disp, diff, weight/dist);
+				w += 1.0f;
+			}
+			
+			if (w > 0.0001f)
+			{
+				// Adjust desired velocity.
+				dtVmad(dvel, dvel, disp, 1.0f/w);
+				// Clamp desired velocity to desired speed.
+				const float speedSqr = dtVlenSqr(dvel);
+				const float desiredSqr = dtSqr(ag->desiredSpeed);
+				if (speedSqr > desiredSqr)
+					dtVscale(dvel, dvel, desiredSqr/speedSqr);
+			}
+		}
+		
+		// Set the desired velocity.
+		dtVcopy(ag->dvel, dvel);
+	}
+}
+
+void dtCrowd::updateVelocityTask(void* data, int begin, int end, int threadIndex)
+{
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtObstacleAvoidanceQuery* obstacleQuery = crowd->m_threadObstacleQueries ? crowd->m_threadObstacleQueries[threadIndex] :
+		crowd->m_obstacleQuery;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	const int debugIdx = crowd->m_updateDebug ? crowd->m_updateDebug->idx : -1;
+	int sampleCount = 0;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		
+		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
+		{
+			obstacleQuery->reset();
+			
+			// Add neighbours as obstacles.
+			for (int j = 0; j < ag->nneis; ++j)
+			{
+				const dtCrowdAgent* nei = &crowd->m_agents[ag->neis[j].idx];
+				obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
+			}
+
+			// Append neighbour segments as obstacles.
+			for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
+			{
+				const float* s = ag->boundary.getSegment(j);
+				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
+					continue;
+				obstacleQuery->addSegment(s, s+3);
+			}
+
+			dtObstacleAvoidanceDebugData* vod = 0;
+			if (debugIdx == i) 
+				vod = crowd->m_updateDebug->vod;
+			
+			// Sample new safe velocity.
+			bool adaptive = true;
+			int ns = 0;
+
+			const dtObstacleAvoidanceParams* params = &crowd->m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
+				
+			if (adaptive)
+			{
+				ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+														   ag->vel, ag->dvel, ag->nvel, params, vod);
+			}
+			else
+			{
+				ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
+													   ag->vel, ag->dvel, ag->nvel, params, vod);
+			}
+			sampleCount += ns;
+		}
+		else
+		{
+			// If not using velocity planning, new velocity is directly the desired velocity.
+			dtVcopy(ag->nvel, ag->dvel);
+		}
+	}
+	
+	if (crowd->m_threadSampleCounts)
+		crowd->m_threadSampleCounts[threadIndex] += sampleCount;
+	else
+		crowd->m_velocitySampleCount += sampleCount;
+}
+
+void dtCrowd::integrateTask(void* data, int begin, int end, int /*threadIndex*/)
+{
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		integrate(ag, crowd->m_updateDt);
+	}
+}
+
+void dtCrowd::calcCollisionTask(void* data, int begin, int end, int /*threadIndex*/)
+{
+	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+	
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		const int idx0 = crowd->getAgentIndex(ag);
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+
+		dtVset(ag->disp, 0,0,0);
+		
+		float w = 0;
+
+		for (int j = 0; j < ag->nneis; ++j)
+		{
+			const dtCrowdAgent* nei = &crowd->m_agents[ag->neis[j].idx];
+			const int idx1 = crowd->getAgentIndex(nei);
+
+			float diff[3];
+			dtVsub(diff, ag->npos, nei->npos);
+			diff[1] = 0;
+			
+			float dist = dtVlenSqr(diff);
+			if (dist > dtSqr(ag->params.radius + nei->params.radius))
+				continue;
+			dist = dtMathSqrtf(dist);
+			float pen = (ag->params.radius + nei->params.radius) - dist;
+			if (dist < 0.0001f)
+			{
+				// Agents on top of each other, try to choose diverging separation directions.
+				if (idx0 > idx1)
+					dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
+				else
+					dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
+				pen = 0.01f;
+			}
+			else
+			{
+				pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
+			}
+			
+			dtVmad(ag->disp, ag->disp, diff, pen);			
+			
+			w += 1.0f;
+		}
+		
+		if (w > 0.0001f)
+		{
+			const float iw = 1.0f / w;
+			dtVscale(ag->disp, ag->disp, iw);
+		}
+	}
+}
+
+void dtCrowd::applyCollisionTask(void* data, int begin, int end, int /*threadIndex*/)
+{
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		
+		dtVadd(ag->npos, ag->npos, ag->disp);
+	}
+}
+
+void dtCrowd::movePositionTask(void* data, int begin, int end, int threadIndex)
+{
+	dtCrowd* crowd = (dtCrowd*)data;
+	dtNavMeshQuery* navquery = crowd->m_threadNavQueries ? crowd->m_threadNavQueries[threadIndex] : crowd->m_navquery;
+	dtCrowdAgent** agents = crowd->m_activeAgents;
+	
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		
+		// Move along navmesh.
+		ag->corridor.movePosition(ag->npos, navquery, &crowd->m_filters[ag->params.queryFilterType]);
+		// Get valid constrained position back.
+		dtVcopy(ag->npos, ag->corridor.getPos());
+
+		// If not using path, truncate the corridor to just one poly.
+		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		{
+			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
+			ag->partial = false;
+		}
+	}
+}
+// ATOMIC END
+
 void dtCrowd::setObstacleAvoidanceParams(const int idx, const dtObstacleAvoidanceParams* params)
 {
 	if (idx >= 0 && idx < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
@@ -1079,29 +1482,17 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
 	}
 	
+	// ATOMIC BEGIN
+	// The per-agent phases only write to the agent itself, so they can be split across threads.
+	m_updateAgentCount = nagents;
+	m_updateDt = dt;
+	m_updateDebug = debug;
+	if (m_threadSampleCounts)
+		memset(m_threadSampleCounts, 0, sizeof(int)*m_maxThreads);
+	
 	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-
-		// Update the collision boundary after certain distance has been passed or
-		// if it has become invalid.
-		const float updateThr = ag->params.collisionQueryRange*0.25f;
-		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
-		{
-			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
-		}
-		// Query neighbour agents
-		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
-								  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
-								  agents, nagents, m_grid);
-		for (int j = 0; j < ag->nneis; j++)
-			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
-	}
+	runParallel(updateNeighboursTask);
+	// ATOMIC END
 	
 	// Find next corner to steer to.
 	for (int i = 0; i < nagents; ++i)
@@ -1183,240 +1574,44 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		}
 	}
 		
+	// ATOMIC BEGIN
 	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
-			continue;
-		
-		float dvel[3] = {0,0,0};
-
-		if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			dtVcopy(dvel, ag->targetPos);
-			ag->desiredSpeed = dtVlen(ag->targetPos);
-		}
-		else
-		{
-			// Calculate steering direction.
-			if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
-				calcSmoothSteerDirection(ag, dvel);
-			else
-				calcStraightSteerDirection(ag, dvel);
-			
-			// Calculate speed scale, which tells the agent to slowdown at the end of the path.
-			const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
-			const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
-				
-			ag->desiredSpeed = ag->params.maxSpeed;
-			dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
-		}
-
-		// Separation
-		if (ag->params.updateFlags & DT_CROWD_SEPARATION)
-		{
-			const float separationDist = ag->params.collisionQueryRange; 
-			const float invSeparationDist = 1.0f / separationDist; 
-			const float separationWeight = ag->params.separationWeight;
-			
-			float w = 0;
-			float disp[3] = {0,0,0};
-			
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				const float distSqr = dtVlenSqr(diff);
-				if (distSqr < 0.00001f)
-					continue;
-				if (distSqr > dtSqr(separationDist))
-					continue;
-				const float dist = dtMathSqrtf(distSqr);
-				const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
-				
-				dtVmad(disp, disp, diff, weight/dist);
-				w += 1.0f;
-			}
-			
-			if (w > 0.0001f)
-			{
-				// Adjust desired velocity.
-				dtVmad(dvel, dvel, disp, 1.0f/w);
-				// Clamp desired velocity to desired speed.
-				const float speedSqr = dtVlenSqr(dvel);
-				const float desiredSqr = dtSqr(ag->desiredSpeed);
-				if (speedSqr > desiredSqr)
-					dtVscale(dvel, dvel, desiredSqr/speedSqr);
-			}
-		}
-		
-		// Set the desired velocity.
-		dtVcopy(ag->dvel, dvel);
-	}
+	runParallel(updateSteeringTask);
 	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
+	// Velocity planning.
+	runParallel(updateVelocityTask);
+	if (m_threadSampleCounts)
 	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		
-		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
-		{
-			m_obstacleQuery->reset();
-			
-			// Add neighbours as obstacles.
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
-			}
-
-			// Append neighbour segments as obstacles.
-			for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
-			{
-				const float* s = ag->boundary.getSegment(j);
-				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
-					continue;
-				m_obstacleQuery->addSegment(s, s+3);
-			}
-
-			dtObstacleAvoidanceDebugData* vod = 0;
-			if (debugIdx == i) 
-				vod = debug->vod;
-			
-			// Sample new safe velocity.
-			bool adaptive = true;
-			int ns = 0;
-
-			const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
-				
-			if (adaptive)
-			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
-															 ag->vel, ag->dvel, ag->nvel, params, vod);
-			}
-			else
-			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
-			}
-			m_velocitySampleCount += ns;
-		}
-		else
-		{
-			// If not using velocity planning, new velocity is directly the desired velocity.
-			dtVcopy(ag->nvel, ag->dvel);
-		}
+		for (int i = 0; i < m_maxThreads; ++i)
+			m_velocitySampleCount += m_threadSampleCounts[i];
 	}
 
 	// Integrate.
-	for (int i = 0; i < nagents; ++i)
+	runParallel(integrateTask);
+	
+	// Handle collisions.
+	for (int iter = 0; iter < 4; ++iter)
 	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		integrate(ag, dt);
+		runParallel(calcCollisionTask);
+		runParallel(applyCollisionTask);
 	}
 	
-	// Handle collisions.
-	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+	// Move along navmesh.
+	runParallel(movePositionTask);
 	
-	for (int iter = 0; iter < 4; ++iter)
+	// Urho3D: Add update callback support
+	// The callback writes back to the scene, so call it for all agents on this thread after the parallel phases
+	if (m_updateCallback)
 	{
 		for (int i = 0; i < nagents; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
-			const int idx0 = getAgentIndex(ag);
-			
 			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 				continue;
-
-			dtVset(ag->disp, 0,0,0);
-			
-			float w = 0;
-
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				const int idx1 = getAgentIndex(nei);
-
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				float dist = dtVlenSqr(diff);
-				if (dist > dtSqr(ag->params.radius + nei->params.radius))
-					continue;
-				dist = dtMathSqrtf(dist);
-				float pen = (ag->params.radius + nei->params.radius) - dist;
-				if (dist < 0.0001f)
-				{
-					// Agents on top of each other, try to choose diverging separation directions.
-					if (idx0 > idx1)
-						dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
-					else
-						dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
-					pen = 0.01f;
-				}
-				else
-				{
-					pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
-				}
-				
-				dtVmad(ag->disp, ag->disp, diff, pen);			
-				
-				w += 1.0f;
-			}
-			
-			if (w > 0.0001f)
-			{
-				const float iw = 1.0f / w;
-				dtVscale(ag->disp, ag->disp, iw);
-			}
-		}
-		
-		for (int i = 0; i < nagents; ++i)
-		{
-			dtCrowdAgent* ag = agents[i];
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
-			
-			dtVadd(ag->npos, ag->npos, ag->disp);
-		}
-	}
-	
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		
-		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
-		// Get valid constrained position back.
-		dtVcopy(ag->npos, ag->corridor.getPos());
-
-		// If not using path, truncate the corridor to just one poly.
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
-			ag->partial = false;
-		}
-
-		// Urho3D: Add update callback support
-		if (m_updateCallback)
 			(*m_updateCallback)(ag, dt);
+		}
 	}
+	// ATOMIC END
 	
 	// Update agents using off-mesh connection.
 	for (int i = 0; i < m_maxAgents; ++i)
@@ -112,6 +112,11 @@ public:
 	
 	dtStatus update(const float /*dt*/, class dtNavMesh* navmesh);
 	
+	// ATOMIC BEGIN
+	/// Returns true when there are no obstacle requests or tile updates left to process.
+	bool isUpToDate() const { return m_nreqs == 0 && m_nupdate == 0; }
+	// ATOMIC END
+	
 	dtStatus buildNavMeshTilesAt(const int tx, const int ty, class dtNavMesh* navmesh);
 	
 	dtStatus buildNavMeshTile(const dtCompressedTileRef ref, class dtNavMesh* navmesh);
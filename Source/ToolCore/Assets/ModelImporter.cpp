@@ -46,6 +46,7 @@ void ModelImporter::SetDefaults()
 
     scale_ = 1.0;
     importAnimations_ = false;
+    compressAnimations_ = false;
     animationInfo_.Clear();
 
 }
@@ -85,6 +86,7 @@ bool ModelImporter::ImportAnimation(const String& filename, const String& name,
 
     importer->SetScale(scale_);
     importer->SetExportAnimations(true);
+    importer->SetCompressAnimations(compressAnimations_);
     importer->SetStartTime(startTime);
     importer->SetEndTime(endTime);
 
@@ -114,6 +116,9 @@ bool ModelImporter::ImportAnimation(const String& filename, const String& name,
             }
 
             LOGINFOF("Import Info: %s : %s", info.name_.CString(), fileName.CString());
+
+            if (compressAnimations_)
+                LOGINFOF("Compression: %s : %s", info.name_.CString(), info.compressionReport_.ToString().CString());
         }
 
         return true;
@@ -324,6 +329,9 @@ bool ModelImporter::LoadSettingsInternal(JSONValue& jsonRoot)
     if (import.Get("importAnimations").IsBool())
         importAnimations_ = import.Get("importAnimations").GetBool();
 
+    if (import.Get("compressAnimations").IsBool())
+        compressAnimations_ = import.Get("compressAnimations").GetBool();
+
     if (import.Get("animInfo").IsArray())
     {
         JSONArray animInfo = import.Get("animInfo").GetArray();
@@ -353,6 +361,7 @@ bool ModelImporter::SaveSettingsInternal(JSONValue& jsonRoot)
     JSONValue save;
     save.Set("scale", scale_);
     save.Set("importAnimations", importAnimations_);
+    save.Set("compressAnimations", compressAnimations_);
 
     JSONArray animInfo;
 
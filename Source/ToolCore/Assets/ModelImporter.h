@@ -67,6 +67,9 @@ public:
     bool GetImportAnimations() { return importAnimations_; }
     void SetImportAnimations(bool importAnimations) { importAnimations_ = importAnimations; }
 
+    bool GetCompressAnimations() { return compressAnimations_; }
+    void SetCompressAnimations(bool compressAnimations) { compressAnimations_ = compressAnimations; }
+
     unsigned GetAnimationCount();
     void SetAnimationCount(unsigned count);
 
@@ -93,6 +96,7 @@ protected:
 
     double scale_;
     bool importAnimations_;
+    bool compressAnimations_;
     Vector<SharedPtr<AnimationImportInfo>> animationInfo_;
 
     SharedPtr<Node> importNode_;
@@ -6,6 +6,7 @@
 //
 
 #include <Atomic/Container/Str.h>
+#include <Atomic/Container/Vector.h>
 
 #pragma once
 
@@ -34,6 +35,9 @@ struct BuildResourceEntry
     // the checksum_
     unsigned checksum_;
 
+    // generated data written instead of the file at absolutePath_, if not empty
+    PODVector<unsigned char> data_;
+
     BuildResourceEntry()
     {
         offset_ = size_ = checksum_ = 0;
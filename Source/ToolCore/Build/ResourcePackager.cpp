@@ -29,7 +29,11 @@
 
 #include "Atomic/Core/StringUtils.h"
 #include <Atomic/IO/FileSystem.h>
+#include <Atomic/IO/VectorBuffer.h>
 #include <Atomic/Container/ArrayPtr.h>
+#include <Atomic/Container/HashSet.h>
+
+#include <AtomicJS/Javascript/JSRequire.h>
 
 #include <LZ4/lz4.h>
 #include <LZ4/lz4hc.h>
@@ -50,7 +54,10 @@ ResourcePackager::ResourcePackager(Context* context, BuildBase* buildBase) : Obj
 
 ResourcePackager::~ResourcePackager()
 {
-
+    for (unsigned i = 0; i < generatedEntries_.Size(); i++)
+    {
+        delete generatedEntries_[i];
+    }
 }
 
 bool ResourcePackager::WritePackageFile(const String& destFilePath)
@@ -87,24 +94,31 @@ bool ResourcePackager::WritePackageFile(const String& destFilePath)
 
         entry->offset_ = dest->GetSize();
 
-        File srcFile(context_, entry->absolutePath_);
-        if (!srcFile.IsOpen())
-        {
-            buildBase_->FailBuild("Could not open input file " + entry->absolutePath_);
-            return false;
-        }
-
         unsigned dataSize = entry->size_;
         totalDataSize += dataSize;
         SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
 
-        if (srcFile.Read(&buffer[0], dataSize) != dataSize)
+        if (entry->data_.Size())
         {
-            buildBase_->FailBuild("Could not read input file " + entry->absolutePath_);
-            return false;
+            memcpy(&buffer[0], &entry->data_[0], dataSize);
         }
+        else
+        {
+            File srcFile(context_, entry->absolutePath_);
+            if (!srcFile.IsOpen())
+            {
+                buildBase_->FailBuild("Could not open input file " + entry->absolutePath_);
+                return false;
+            }
+
+            if (srcFile.Read(&buffer[0], dataSize) != dataSize)
+            {
+                buildBase_->FailBuild("Could not read input file " + entry->absolutePath_);
+                return false;
+            }
 
-        srcFile.Close();
+            srcFile.Close();
+        }
 
         for (unsigned j = 0; j < dataSize; ++j)
         {
@@ -187,12 +201,83 @@ void ResourcePackager::WriteHeader(File* dest)
 }
 
 
+void ResourcePackager::GenerateBytecodeEntries()
+{
+    duk_context* ctx = duk_create_heap_default();
+
+    if (!ctx)
+    {
+        buildBase_->BuildWarn("Unable to create Javascript heap, modules will not be precompiled");
+        return;
+    }
+
+    // bytecode files already in the resources are not replaced
+    HashSet<String> packagePaths;
+    for (unsigned i = 0; i < resourceEntries_.Size(); i++)
+        packagePaths.Insert(resourceEntries_[i]->packagePath_);
+
+    unsigned numEntries = resourceEntries_.Size();
+    unsigned numCompiled = 0;
+
+    for (unsigned i = 0; i < numEntries; i++)
+    {
+        BuildResourceEntry* entry = resourceEntries_[i];
+
+        if (GetExtension(entry->packagePath_) != ".js")
+            continue;
+
+        String bytecodePath = ReplaceExtension(entry->packagePath_, JS_BYTECODE_EXTENSION);
+
+        if (packagePaths.Contains(bytecodePath))
+            continue;
+
+        File file(context_);
+
+        if (!file.Open(entry->absolutePath_))
+            continue;
+
+        String source;
+        file.ReadText(source);
+
+        String moduleID = ReplaceExtension(entry->packagePath_, String::EMPTY);
+
+        VectorBuffer bytecode;
+        if (!js_write_module_bytecode(ctx, moduleID, source, bytecode))
+        {
+            // the module is still loaded from source at runtime
+            buildBase_->BuildWarn("Unable to precompile " + entry->packagePath_);
+            continue;
+        }
+
+        BuildResourceEntry* newEntry = new BuildResourceEntry;
+        newEntry->absolutePath_ = entry->absolutePath_;
+        newEntry->resourceDir_ = entry->resourceDir_;
+        newEntry->packagePath_ = bytecodePath;
+        newEntry->data_ = bytecode.GetBuffer();
+        newEntry->size_ = newEntry->data_.Size();
+
+        generatedEntries_.Push(newEntry);
+        resourceEntries_.Push(newEntry);
+        numCompiled++;
+    }
+
+    duk_destroy_heap(ctx);
+
+    buildBase_->BuildLog("Precompiled " + String(numCompiled) + " Javascript modules", false);
+}
+
 void ResourcePackager::GeneratePackage(const String& destFilePath)
 {
+    GenerateBytecodeEntries();
+
     for (unsigned i = 0; i < resourceEntries_.Size(); i++)
     {
         BuildResourceEntry* entry = resourceEntries_[i];
 
+        // generated entries have their size already set
+        if (entry->data_.Size())
+            continue;
+
         File file(context_);
 
         if (!file.Open(entry->absolutePath_))
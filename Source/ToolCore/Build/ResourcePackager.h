@@ -38,8 +38,14 @@ private:
     void WriteHeader(File* dest);
     bool WritePackageFile(const String& destFilePath);
 
+    // precompile Javascript modules to Duktape bytecode, which the player prefers over the source when it matches
+    void GenerateBytecodeEntries();
+
     PODVector<BuildResourceEntry*> resourceEntries_;
 
+    // entries generated by the packager, owned by it
+    PODVector<BuildResourceEntry*> generatedEntries_;
+
     WeakPtr<BuildBase> buildBase_;
 
     unsigned checksum_;
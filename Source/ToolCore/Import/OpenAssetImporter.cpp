@@ -58,6 +58,7 @@ OpenAssetImporter::OpenAssetImporter(Context* context) : Object(context) ,
     saveBinary_(false),
     createZone_(true),
     noAnimations_(false),
+    compressAnimations_(false),
     noHierarchy_(false),
     noMaterials_(false),
     noTextures_(false),
@@ -1110,6 +1111,12 @@ bool OpenAssetImporter::BuildAndSaveAnimations(OutModel* model, const String &an
 
         outAnim->SetTracks(tracks);
 
+        AnimationInfo info;
+        if (compressAnimations_)
+        {
+            info.compressionReport_ = outAnim->Compress(compressionSettings_);
+        }
+
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
         {
@@ -1119,7 +1126,6 @@ bool OpenAssetImporter::BuildAndSaveAnimations(OutModel* model, const String &an
 
         outAnim->Save(outFile);
 
-        AnimationInfo info;
         info.name_ = SanitateAssetName(animName);
         info.cacheFilename_ = animOutName;
         animationInfos_.Push(info);
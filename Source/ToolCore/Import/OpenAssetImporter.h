@@ -37,6 +37,7 @@
 
 #include <Atomic/Core/Object.h>
 #include <Atomic/Scene/Node.h>
+#include <Atomic/Atomic3D/Animation.h>
 
 using namespace Atomic;
 
@@ -53,6 +54,7 @@ public:
     {
         String name_;
         String cacheFilename_;
+        AnimationCompressionReport compressionReport_;
     };
 
     OpenAssetImporter(Context* context);
@@ -69,6 +71,8 @@ public:
     void SetEndTime(float endTime) { endTime_ = endTime; }
     void SetScale(float scale) { scale_ = scale; }
     void SetExportAnimations(bool exportAnimations) { noAnimations_ = !exportAnimations; }
+    void SetCompressAnimations(bool compressAnimations) { compressAnimations_ = compressAnimations; }
+    void SetAnimationCompressionSettings(const AnimationCompressionSettings& settings) { compressionSettings_ = settings; }
 
     void SetVerboseLog(bool verboseLog) { verboseLog_ = verboseLog; }
 
@@ -115,6 +119,7 @@ private:
     bool saveBinary_;
     bool createZone_;
     bool noAnimations_;
+    bool compressAnimations_;
     bool noHierarchy_;
     bool noMaterials_;
     bool noTextures_;
@@ -141,6 +146,7 @@ private:
     PODVector<aiAnimation*> sceneAnimations_;
 
     Vector<AnimationInfo> animationInfos_;
+    AnimationCompressionSettings compressionSettings_;
 
     SharedPtr<Node> importNode_;
 
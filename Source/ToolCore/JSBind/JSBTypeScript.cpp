@@ -116,6 +116,7 @@ void JSBTypeScript::ExportFunction(JSBFunction* function)
     source_ += scriptName + "(";
 
     Vector<JSBFunctionType*>& parameters = function->GetParameters();
+    bool hasParameters = false;
 
     for (unsigned i = 0; i < parameters.Size(); i++)
     {
@@ -126,6 +127,8 @@ void JSBTypeScript::ExportFunction(JSBFunction* function)
         if (scriptType == "Context" || scriptType == "Atomic.Context")
             continue;
 
+        hasParameters = true;
+
         String name = ftype->name_;
 
         // TS doesn't like arguments named arguments
@@ -143,6 +146,17 @@ void JSBTypeScript::ExportFunction(JSBFunction* function)
             source_ += ", ";
     }
 
+    // number array results can be written into a typed array passed after the arguments
+    JSBFunctionType* returnType = function->GetReturnType();
+
+    if (returnType && returnType->type_->asClassType() && returnType->type_->asClassType()->class_->IsNumberArray())
+    {
+        if (hasParameters)
+            source_ += ", ";
+
+        source_ += "out?: " + GetScriptType(returnType);
+    }
+
     if (function->IsConstructor())
         source_ += ");\n";
     else
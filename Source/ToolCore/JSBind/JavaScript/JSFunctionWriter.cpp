@@ -83,13 +83,7 @@ void JSFunctionWriter::WriteParameterMarshal(String& source)
                         source.AppendWithFormat("if (duk_get_top(ctx) >= %i) {\n", cparam + 1);
                     }
 
-                    for (int j = 0; j < elements; j++)
-                    {
-                        source.AppendWithFormat("duk_get_prop_index(ctx, %i, %i);\n", cparam, j);
-                        source.AppendWithFormat("arrayData%i[%i] = (%s) duk_to_number(ctx, -1);\n", cparam, j, elementType.CString());
-                    }
-
-                    source.AppendWithFormat("duk_pop_n(ctx, %i);\n", elements);
+                    source.AppendWithFormat("js_get_number_array<%s>(ctx, %i, arrayData%i, %i);\n", elementType.CString(), cparam, cparam, elements);
 
                     if (init.Length())
                     {
@@ -479,13 +473,18 @@ void JSFunctionWriter::WriteFunction(String& source)
             {
                 returnDeclared = true;
                 String elementType = klassType->class_->GetArrayElementType();
-                source.AppendWithFormat("const %s* arrayData = retValue.Data();\n", elementType.CString());
-                source.Append("duk_push_array(ctx);\n");
-                for (int i = 0; i < klassType->class_->GetNumberArrayElements(); i++)
+
+                // an optional typed array passed after the arguments receives the result in place
+                int outIdx = 0;
+                for (unsigned i = 0; i < parameters.Size(); i++)
                 {
-                    source.AppendWithFormat("duk_push_number(ctx, arrayData[%i]);\n", i);
-                    source.AppendWithFormat("duk_put_prop_index(ctx, -2, %i);\n", i);
+                    JSBClassType* ctype = parameters[i]->type_->asClassType();
+                    if (!ctype || ctype->class_->GetName() != "Context")
+                        outIdx++;
                 }
+
+                source.AppendWithFormat("js_push_number_array<%s>(ctx, retValue.Data(), %i, %i);\n",
+                                        elementType.CString(), klassType->class_->GetNumberArrayElements(), outIdx);
             }
             else
             {
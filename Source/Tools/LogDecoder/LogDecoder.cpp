@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2014-2015, THUNDERBEAST GAMES LLC All rights reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/IO/File.h>
+#include <Atomic/IO/Log.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+SharedPtr<Context> context_(new Context());
+bool timeStamp_ = true;
+int level_ = LOG_DEBUG;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 1)
+        ErrorExit(
+            "Usage: LogDecoder <binary log file> [output file] [options]\n"
+            "\n"
+            "Options:\n"
+            "-n      Omit timestamps\n"
+            "-w      Output only warnings and errors\n"
+            "-e      Output only errors\n"
+        );
+
+    const String& inputName = arguments[0];
+    String outputName;
+
+    for (unsigned i = 1; i < arguments.Size(); ++i)
+    {
+        if (arguments[i][0] != '-')
+            outputName = arguments[i];
+        else if (arguments[i].Length() > 1)
+        {
+            switch (arguments[i][1])
+            {
+            case 'n':
+                timeStamp_ = false;
+                break;
+
+            case 'w':
+                level_ = LOG_WARNING;
+                break;
+
+            case 'e':
+                level_ = LOG_ERROR;
+                break;
+            }
+        }
+    }
+
+    File source(context_);
+    if (!source.Open(inputName))
+        ErrorExit("Could not open input file " + inputName);
+
+    Vector<StoredLogMessage> messages;
+    if (!Log::ReadBinaryLog(source, messages))
+        ErrorExit(inputName + " is not a binary log file");
+
+    SharedPtr<File> dest;
+    if (!outputName.Empty())
+    {
+        dest = new File(context_);
+        if (!dest->Open(outputName, FILE_WRITE))
+            ErrorExit("Could not open output file " + outputName);
+    }
+
+    for (unsigned i = 0; i < messages.Size(); ++i)
+    {
+        const StoredLogMessage& message = messages[i];
+
+        // Raw messages are output unless filtering, in which case only raw errors pass
+        if (message.level_ == LOG_RAW ? (level_ > LOG_DEBUG && !message.error_) : message.level_ < level_)
+            continue;
+
+        String line = Log::FormatLogMessage(message, timeStamp_);
+        if (dest)
+        {
+            if (message.level_ == LOG_RAW)
+                dest->Write(line.CString(), line.Length());
+            else
+                dest->WriteLine(line);
+        }
+        else if (message.level_ == LOG_RAW)
+            PrintUnicode(line);
+        else
+            PrintUnicodeLine(line);
+    }
+}